@@ -0,0 +1,165 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "geometry/broadphase.h"
+#include "geometry/collision.h"
+#include "geometry/geometry.h"
+
+// Times the laser-vs-fighter collision phase of a tick, brute force against the uniform grid
+// broadphase, for a growing number of fighters. Fighters are spread at constant density and
+// every fighter has four lasers in flight.
+
+namespace
+{
+constexpr float dt = 1.0f / 60.0f;
+constexpr float laser_speed = 1000.0f;
+constexpr float laser_length = 4.0f;
+constexpr int lasers_per_fighter = 4;
+
+struct Body
+{
+    Eigen::Isometry3f pose;
+    Eigen::Vector3f dimensions;
+};
+
+struct Laser
+{
+    Eigen::Isometry3f pose;
+};
+
+Eigen::Isometry3f random_pose(std::mt19937& rng, const float extent)
+{
+    std::uniform_real_distribution<float> pos(-extent, extent);
+    return geometry::make_pose(Eigen::Vector3f(pos(rng), pos(rng), pos(rng)),
+                               Eigen::Quaternionf::UnitRandom());
+}
+
+int brute_force(const std::vector<Body>& fighters, const std::vector<Laser>& lasers)
+{
+    int hits = 0;
+    for (const auto& laser : lasers)
+    {
+        for (const auto& fighter : fighters)
+        {
+            if (geometry::ray_aabb_test(laser.pose,
+                                        laser_length / 2.0f,
+                                        -laser_length / 2.0f - laser_speed * dt,
+                                        fighter.pose,
+                                        fighter.dimensions))
+            {
+                ++hits;
+                break;
+            }
+        }
+    }
+    return hits;
+}
+
+int grid(geometry::UniformGrid& grid,
+         const std::vector<Body>& fighters,
+         const std::vector<Laser>& lasers)
+{
+    grid.clear();
+    for (std::size_t i = 0; i < fighters.size(); ++i)
+    {
+        const auto [min, max] = geometry::world_aabb(fighters[i].pose, fighters[i].dimensions);
+        grid.insert(i, min, max);
+    }
+    grid.build();
+
+    int hits = 0;
+    std::vector<std::uint32_t> candidates;
+    for (const auto& laser : lasers)
+    {
+        const float tmax = laser_length / 2.0f;
+        const float tmin = -laser_length / 2.0f - laser_speed * dt;
+        const Eigen::Vector3f fwd = laser.pose.linear().col(0);
+
+        candidates.clear();
+        grid.query_segment(laser.pose.translation() + tmin * fwd,
+                           laser.pose.translation() + tmax * fwd,
+                           candidates);
+
+        for (const auto id : candidates)
+        {
+            if (geometry::ray_aabb_test(
+                    laser.pose, tmax, tmin, fighters[id].pose, fighters[id].dimensions))
+            {
+                ++hits;
+                break;
+            }
+        }
+    }
+    return hits;
+}
+
+template <typename Fn>
+double time_ms(Fn&& fn, const int repetitions)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; ++i)
+    {
+        fn();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count() / repetitions;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    std::mt19937 rng(1234);
+    geometry::UniformGrid uniform_grid(32.0f);
+
+    std::printf(
+        "%10s %10s %16s %16s %8s\n", "fighters", "lasers", "brute (ms)", "grid (ms)", "hits");
+
+    for (const int num_fighters : { 10, 30, 100, 300, 1000, 3000, 10000 })
+    {
+        // ~40 m between fighters on average, whatever the count
+        const float extent = 20.0f * std::cbrt(static_cast<float>(num_fighters));
+
+        std::vector<Body> fighters;
+        for (int i = 0; i < num_fighters; ++i)
+        {
+            fighters.push_back({ random_pose(rng, extent), Eigen::Vector3f(8.4f, 8.2f, 10.2f) });
+        }
+        std::vector<Laser> lasers;
+        for (int i = 0; i < num_fighters * lasers_per_fighter; ++i)
+        {
+            lasers.push_back({ random_pose(rng, extent) });
+        }
+
+        const int repetitions = num_fighters < 1000 ? 50 : 5;
+        int grid_hits = 0;
+        const double grid_ms =
+            time_ms([&]() { grid_hits = grid(uniform_grid, fighters, lasers); }, repetitions);
+
+        // Brute force beyond a few thousand fighters takes seconds per tick
+        if (num_fighters <= 3000)
+        {
+            int brute_hits = 0;
+            const double brute_ms =
+                time_ms([&]() { brute_hits = brute_force(fighters, lasers); }, repetitions);
+            std::printf("%10d %10zu %16.3f %16.3f %4d/%-4d\n",
+                        num_fighters,
+                        lasers.size(),
+                        brute_ms,
+                        grid_ms,
+                        grid_hits,
+                        brute_hits);
+        }
+        else
+        {
+            std::printf("%10d %10zu %16s %16.3f %4d\n",
+                        num_fighters,
+                        lasers.size(),
+                        "-",
+                        grid_ms,
+                        grid_hits);
+        }
+    }
+}
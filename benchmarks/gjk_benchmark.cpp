@@ -0,0 +1,161 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "geometry/collision.h"
+#include "geometry/geometry.h"
+#include "geometry/gjk.h"
+
+// Times gjk() on pairs of boxes drifting past each other, starting every query from scratch
+// against warm starting it from the simplex of the previous frame, and checks both against
+// obb_intersect_test, exiting with a failure on any disagreement. Pairs found intersecting are also
+// run through epa().
+
+namespace
+{
+constexpr float dt = 1.0f / 60.0f;
+constexpr int num_frames = 120;
+
+// obb_intersect_test adds 1e-6 to the rotation's absolute values so that near parallel edges can't
+// separate anything, which inflates the boxes' projections by up to the extents times 1e-6: boxes
+// a couple of 1e-5 apart still intersect it. Pairs closer, or deeper, than this only touch, and
+// either answer counts as agreeing.
+constexpr float touching_distance = 1e-4f;
+
+struct Pair
+{
+    geometry::CollisionShape a;
+    geometry::CollisionShape b;
+    Eigen::Vector3f half_extents_a;
+    Eigen::Vector3f half_extents_b;
+    Eigen::Vector3f position;
+    Eigen::Quaternionf orientation;
+    Eigen::Vector3f velocity;
+    Eigen::Vector3f angular_velocity;
+    geometry::GjkSimplex simplex;
+};
+
+// Moves b, keeping its orientation normalized so that the pose stays rigid
+void step(Pair& pair)
+{
+    const Eigen::Quaternionf rotation(Eigen::AngleAxisf(pair.angular_velocity.norm() * dt,
+                                                        pair.angular_velocity.normalized()));
+    pair.position += pair.velocity * dt;
+    pair.orientation = (rotation * pair.orientation).normalized();
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> extent(0.5f, 5.0f);
+    std::uniform_real_distribution<float> pos(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> vel(-20.0f, 20.0f);
+
+    std::printf("%10s %14s %14s %14s %14s %10s %10s\n",
+                "pairs",
+                "cold (ns/pair)",
+                "warm (ns/pair)",
+                "cold (iters)",
+                "warm (iters)",
+                "contacts",
+                "mismatch");
+
+    bool ok = true;
+    for (const int num_pairs : { 16, 256, 4096 })
+    {
+        std::vector<Pair> pairs;
+        for (int i = 0; i < num_pairs; ++i)
+        {
+            const Eigen::Vector3f half_a(extent(rng), extent(rng), extent(rng));
+            const Eigen::Vector3f half_b(extent(rng), extent(rng), extent(rng));
+            pairs.push_back({ geometry::CollisionShape(-half_a, half_a),
+                              geometry::CollisionShape(-half_b, half_b),
+                              half_a,
+                              half_b,
+                              Eigen::Vector3f(pos(rng), pos(rng), pos(rng)),
+                              Eigen::Quaternionf::UnitRandom(),
+                              Eigen::Vector3f(vel(rng), vel(rng), vel(rng)),
+                              Eigen::Vector3f::Random(),
+                              geometry::GjkSimplex() });
+        }
+
+        double cold_ns = 0.0;
+        double warm_ns = 0.0;
+        long cold_iterations = 0;
+        long warm_iterations = 0;
+        int contacts = 0;
+        int mismatches = 0;
+
+        for (int frame = 0; frame < num_frames; ++frame)
+        {
+            std::vector<Eigen::Isometry3f> relative_poses;
+            for (const auto& pair : pairs)
+            {
+                relative_poses.push_back(geometry::make_pose(pair.position, pair.orientation));
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < pairs.size(); ++i)
+            {
+                auto simplex = geometry::GjkSimplex();
+                cold_iterations +=
+                    geometry::gjk(pairs[i].a, pairs[i].b, relative_poses[i], simplex)
+                        .num_iterations;
+            }
+            auto stop = std::chrono::steady_clock::now();
+            cold_ns += std::chrono::duration<double, std::nano>(stop - start).count();
+
+            start = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < pairs.size(); ++i)
+            {
+                warm_iterations +=
+                    geometry::gjk(pairs[i].a, pairs[i].b, relative_poses[i], pairs[i].simplex)
+                        .num_iterations;
+            }
+            stop = std::chrono::steady_clock::now();
+            warm_ns += std::chrono::duration<double, std::nano>(stop - start).count();
+
+            for (std::size_t i = 0; i < pairs.size(); ++i)
+            {
+                auto& pair = pairs[i];
+                auto simplex = pair.simplex;
+                const auto result = geometry::gjk(pair.a, pair.b, relative_poses[i], simplex);
+                auto contact = std::optional<geometry::Contact>();
+                if (result.intersecting)
+                {
+                    contact = geometry::epa(pair.a, pair.b, relative_poses[i], simplex);
+                    contacts += contact.has_value();
+                }
+
+                const bool touching = result.intersecting ?
+                                          !contact || contact->depth < touching_distance :
+                                          result.distance < touching_distance;
+                if (!touching)
+                {
+                    mismatches += result.intersecting !=
+                                  geometry::obb_intersect_test(
+                                      pair.half_extents_a, pair.half_extents_b, relative_poses[i]);
+                }
+
+                step(pair);
+            }
+        }
+
+        const double num_queries = static_cast<double>(num_pairs) * num_frames;
+        std::printf("%10d %14.2f %14.2f %14.2f %14.2f %10d %10d\n",
+                    num_pairs,
+                    cold_ns / num_queries,
+                    warm_ns / num_queries,
+                    cold_iterations / num_queries,
+                    warm_iterations / num_queries,
+                    contacts,
+                    mismatches);
+        ok &= mismatches == 0;
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
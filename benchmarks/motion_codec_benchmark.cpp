@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "geometry/geometry.h"
+#include "geometry/motion_codec.h"
+
+// Round trips random MotionStates through geometry::MotionStateCodec and checks the errors against
+// the codec's bounds, and that decoding gives back exactly the quantized states, with and without
+// a baseline. Then times encoding and decoding, and reports the bits a state takes when encoded in
+// full, against the previous tick's state, and while at rest. Exits with a failure if a check
+// fails.
+//
+// Usage: motion_codec_benchmark [num_states] [num_repeats]
+
+namespace
+{
+constexpr float dt = 1.0f / 60.0f;
+constexpr float sector_extent = 4096.0f;
+
+// As in data/urdf/awing.urdf
+constexpr auto limits = geometry::MotionStateCodec::Limits{ 50.0f, 50.0f, 3.14f, 6.28f };
+
+Eigen::Vector3f random_vector(std::mt19937& rng, const float max_norm)
+{
+    std::normal_distribution<float> normal;
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    const Eigen::Vector3f direction =
+        Eigen::Vector3f(normal(rng), normal(rng), normal(rng)).normalized();
+    return direction * max_norm * uniform(rng);
+}
+
+// Like urdf::FighterModel::apply_motion_limits
+void clamp_norm(Eigen::Vector3f& x, const float max_norm)
+{
+    if (const float norm = x.norm(); norm > max_norm)
+    {
+        x *= max_norm / norm;
+    }
+}
+
+geometry::MotionState random_state(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> position(-sector_extent, sector_extent);
+
+    auto state = geometry::MotionState(
+        Eigen::Vector3f(position(rng), position(rng), position(rng)),
+        Eigen::Quaternionf::UnitRandom());
+    state.velocity = random_vector(rng, limits.velocity);
+    state.acceleration = random_vector(rng, limits.acceleration);
+    state.angular_velocity = random_vector(rng, limits.angular_velocity);
+    state.angular_acceleration = random_vector(rng, limits.angular_acceleration);
+    return state;
+}
+
+struct Errors
+{
+    float position = 0.0f;
+    float orientation = 0.0f;
+    float velocity = 0.0f;
+    float acceleration = 0.0f;
+    float angular_velocity = 0.0f;
+    float angular_acceleration = 0.0f;
+
+    void add(const geometry::MotionState& a, const geometry::MotionState& b)
+    {
+        const auto max_abs = [](const Eigen::Vector3f& x, const Eigen::Vector3f& y) {
+            return (x - y).cwiseAbs().maxCoeff();
+        };
+        position = std::max(position, max_abs(a.position, b.position));
+        orientation = std::max(orientation, a.orientation.angularDistance(b.orientation));
+        velocity = std::max(velocity, max_abs(a.velocity, b.velocity));
+        acceleration = std::max(acceleration, max_abs(a.acceleration, b.acceleration));
+        angular_velocity =
+            std::max(angular_velocity, max_abs(a.angular_velocity, b.angular_velocity));
+        angular_acceleration = std::max(angular_acceleration,
+                                        max_abs(a.angular_acceleration, b.angular_acceleration));
+    }
+};
+
+// Compared with a little slack for the float arithmetic of quantizing
+bool check(const char* name, const float error, const float bound)
+{
+    const bool ok = error <= bound * 1.001f + 1e-6f;
+    std::printf("%-22s %12.3g %12.3g %s\n", name, error, bound, ok ? "ok" : "EXCEEDED");
+    return ok;
+}
+
+template <typename Fn>
+double time_ms(Fn&& fn)
+{
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    const auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_states = argc > 1 ? std::atoi(argv[1]) : 100000;
+    const int num_repeats = argc > 2 ? std::atoi(argv[2]) : 10;
+
+    std::mt19937 rng(1234);
+    const auto codec =
+        geometry::MotionStateCodec(Eigen::Vector3f(100.0f, -50.0f, 25.0f), sector_extent, limits);
+
+    std::vector<geometry::MotionState> states;
+    std::vector<geometry::MotionState> next_states;
+    for (int i = 0; i < num_states; ++i)
+    {
+        auto& state = states.emplace_back(random_state(rng));
+        state.position += Eigen::Vector3f(100.0f, -50.0f, 25.0f);
+
+        // A tick later, steering a little
+        auto& next = next_states.emplace_back(state);
+        next.integrate(dt);
+        next.acceleration = random_vector(rng, limits.acceleration);
+        next.angular_acceleration = random_vector(rng, limits.angular_acceleration);
+        clamp_norm(next.velocity, limits.velocity);
+        clamp_norm(next.angular_velocity, limits.angular_velocity);
+    }
+
+    // Round trip errors, and exact decoding with and without a baseline
+    std::vector<geometry::MotionStateCodec::Quantized> quantized;
+    std::vector<geometry::MotionStateCodec::Quantized> next_quantized;
+    for (int i = 0; i < num_states; ++i)
+    {
+        quantized.push_back(codec.quantize(states[i]));
+        next_quantized.push_back(codec.quantize(next_states[i]));
+    }
+
+    std::vector<std::uint8_t> full;
+    std::vector<std::uint8_t> delta;
+    std::vector<std::uint8_t> resting;
+    {
+        auto full_writer = geometry::BitWriter(full);
+        auto delta_writer = geometry::BitWriter(delta);
+        auto resting_writer = geometry::BitWriter(resting);
+        for (int i = 0; i < num_states; ++i)
+        {
+            codec.encode(quantized[i], nullptr, full_writer);
+            codec.encode(next_quantized[i], &quantized[i], delta_writer);
+            codec.encode(quantized[i], &quantized[i], resting_writer);
+        }
+        full_writer.flush();
+        delta_writer.flush();
+        resting_writer.flush();
+    }
+
+    auto errors = Errors();
+    int num_mismatches = 0;
+    {
+        auto full_reader = geometry::BitReader(full);
+        auto delta_reader = geometry::BitReader(delta);
+        auto resting_reader = geometry::BitReader(resting);
+        for (int i = 0; i < num_states; ++i)
+        {
+            const auto decoded = codec.decode(nullptr, full_reader);
+            num_mismatches += decoded != quantized[i];
+            num_mismatches += codec.decode(&quantized[i], delta_reader) != next_quantized[i];
+            num_mismatches += codec.decode(&quantized[i], resting_reader) != quantized[i];
+
+            errors.add(states[i], codec.dequantize(decoded));
+        }
+    }
+
+    std::printf("%-22s %12s %12s\n", "round trip error", "max", "bound");
+    bool ok = true;
+    ok &= check("position (m)", errors.position, codec.max_position_error());
+    ok &= check("orientation (rad)", errors.orientation, codec.max_orientation_error());
+    ok &= check("velocity", errors.velocity, codec.max_velocity_error());
+    ok &= check("acceleration", errors.acceleration, codec.max_acceleration_error());
+    ok &= check("angular velocity", errors.angular_velocity, codec.max_angular_velocity_error());
+    ok &= check("angular acceleration",
+                errors.angular_acceleration,
+                codec.max_angular_acceleration_error());
+    std::printf("%-22s %12d\n", "decoding mismatches", num_mismatches);
+    ok &= num_mismatches == 0;
+
+    const auto bits_per_state = [num_states](const std::vector<std::uint8_t>& data) {
+        return 8.0 * static_cast<double>(data.size()) / num_states;
+    };
+    std::printf("\n%-22s %12s\n", "encoded size", "bits/state");
+    std::printf("%-22s %12zu\n", "raw MotionState", 8 * sizeof(geometry::MotionState));
+    std::printf("%-22s %12d\n", "full, worst case", codec.max_bits());
+    std::printf("%-22s %12d\n", "delta, worst case", codec.max_delta_bits());
+    std::printf("%-22s %12.1f\n", "full", bits_per_state(full));
+    std::printf("%-22s %12.1f\n", "delta, a tick apart", bits_per_state(delta));
+    std::printf("%-22s %12.1f\n", "delta, at rest", bits_per_state(resting));
+
+    // Throughput, best of the repeats
+    double encode_ms = 0.0;
+    double decode_ms = 0.0;
+    double delta_encode_ms = 0.0;
+    double delta_decode_ms = 0.0;
+    std::vector<std::uint8_t> buffer;
+    std::vector<geometry::MotionState> decoded(num_states);
+    for (int repeat = 0; repeat < num_repeats; ++repeat)
+    {
+        const auto encode = [&](const bool with_baseline) {
+            buffer.clear();
+            auto writer = geometry::BitWriter(buffer);
+            for (int i = 0; i < num_states; ++i)
+            {
+                codec.encode(codec.quantize(next_states[i]),
+                             with_baseline ? &quantized[i] : nullptr,
+                             writer);
+            }
+            writer.flush();
+        };
+        const auto decode = [&](const bool with_baseline) {
+            auto reader = geometry::BitReader(buffer);
+            for (int i = 0; i < num_states; ++i)
+            {
+                decoded[i] =
+                    codec.dequantize(codec.decode(with_baseline ? &quantized[i] : nullptr, reader));
+            }
+        };
+
+        const auto e = time_ms([&]() { encode(false); });
+        const auto d = time_ms([&]() { decode(false); });
+        const auto de = time_ms([&]() { encode(true); });
+        const auto dd = time_ms([&]() { decode(true); });
+
+        encode_ms = repeat == 0 ? e : std::min(encode_ms, e);
+        decode_ms = repeat == 0 ? d : std::min(decode_ms, d);
+        delta_encode_ms = repeat == 0 ? de : std::min(delta_encode_ms, de);
+        delta_decode_ms = repeat == 0 ? dd : std::min(delta_decode_ms, dd);
+    }
+
+    const auto rate = [num_states](const double ms) { return num_states / ms / 1000.0; };
+    std::printf("\n%-22s %12s %12s\n", "throughput", "ms", "M states/s");
+    std::printf("%-22s %12.3f %12.2f\n", "encode, full", encode_ms, rate(encode_ms));
+    std::printf("%-22s %12.3f %12.2f\n", "decode, full", decode_ms, rate(decode_ms));
+    std::printf("%-22s %12.3f %12.2f\n", "encode, delta", delta_encode_ms, rate(delta_encode_ms));
+    std::printf("%-22s %12.3f %12.2f\n", "decode, delta", delta_decode_ms, rate(delta_decode_ms));
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,335 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "ecs/scene.h"
+#include "net/client.h"
+#include "net/prediction.h"
+#include "net/server.h"
+#include "urdf/fighter_input.h"
+#include "urdf/parsing.h"
+
+// Flies a client's fighter against a net::GameServer over loopback UDP, through a relay that holds
+// datagrams back and drops some, with net::FighterPrediction predicting the fighter ahead of the
+// server. Everything runs in lockstep in one thread, so latencies are whole ticks. For a range of
+// latencies and loss rates, reports how often the server corrected the prediction, how many ticks
+// the rollbacks re-simulated and took, and how far they moved the fighter. Then times rollbacks of
+// a growing number of ticks against the budget of a frame.
+//
+// Over a link that neither drops nor jitters, the server applies an input every tick, so the
+// prediction has to match it exactly once the first inputs got through. Exits with a failure if it
+// doesn't, or if re-simulating 10 ticks doesn't fit in a frame.
+//
+// Usage: prediction_benchmark [num_ticks]
+
+namespace
+{
+constexpr float dt = 1.0f / 60.0f;
+constexpr double frame_budget_ms = 1000.0 / 60.0;
+
+// How many ticks the client holds its actions for, on average
+constexpr int mean_hold_ticks = 20;
+
+struct Link
+{
+    int latency_ticks;  // One way
+    int jitter_ticks;   // Up to this many more, at random, which reorders datagrams
+    float loss;
+};
+
+// Relays datagrams between a client and the server, holding each back for the link's latency and
+// dropping some
+class LossyLink
+{
+  public:
+    LossyLink(const net::Address& server, const Link& link, std::mt19937& rng)
+      : server(server), link(link), rng(rng)
+    {
+    }
+
+    // Where the client should send to
+    net::Address get_address() const
+    {
+        return net::Address::loopback(client_side.get_local_address().port);
+    }
+
+    // Takes in what arrived from either side, and passes on what is due by the tick
+    void pump(const int tick)
+    {
+        std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+        std::uniform_int_distribution<int> jitter(0, link.jitter_ticks);
+
+        net::Address from;
+        buffer.resize(net::max_packet_size);
+        const auto take = [&](net::UdpSocket& socket, const bool to_server) {
+            while (const auto size = socket.receive(from, buffer.data(), buffer.size()))
+            {
+                if (to_server)
+                {
+                    client = from;
+                }
+                if (uniform(rng) >= link.loss)
+                {
+                    in_flight.push_back(Datagram{ tick + link.latency_ticks + jitter(rng),
+                                                  to_server,
+                                                  std::vector<char>(buffer.begin(),
+                                                                    buffer.begin() + *size) });
+                }
+            }
+        };
+        take(client_side, true);
+        take(server_side, false);
+
+        // Released in the order they are due, so that jitter reorders them
+        std::stable_sort(
+            in_flight.begin(), in_flight.end(), [](const Datagram& a, const Datagram& b) {
+                return a.due_tick < b.due_tick;
+            });
+        auto due = in_flight.begin();
+        for (; due != in_flight.end() && due->due_tick <= tick; ++due)
+        {
+            if (due->to_server)
+            {
+                server_side.send(server, due->data.data(), due->data.size());
+            }
+            else if (client)
+            {
+                client_side.send(*client, due->data.data(), due->data.size());
+            }
+        }
+        in_flight.erase(in_flight.begin(), due);
+    }
+
+  private:
+    struct Datagram
+    {
+        int due_tick;
+        bool to_server;
+        std::vector<char> data;
+    };
+
+    const net::Address server;
+    const Link link;
+    std::mt19937& rng;
+
+    net::UdpSocket client_side;  // What the client sends to
+    net::UdpSocket server_side;  // What the server sees as the client
+    std::optional<net::Address> client;
+
+    std::vector<Datagram> in_flight;
+    std::vector<char> buffer;
+};
+
+struct Result
+{
+    int num_snapshots = 0;
+    int num_corrections = 0;
+    int num_late_corrections = 0;  // After the first inputs got through
+    int max_resimulated = 0;
+    double total_resimulated = 0.0;
+    double max_rollback_ms = 0.0;
+    double total_jump = 0.0;  // How far corrections moved the predicted fighter, in metres
+    double max_jump = 0.0;
+};
+
+template <typename Fn>
+double time_ms(Fn&& fn)
+{
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    const auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+// Steering and throttle, but not the fire actions
+urdf::FighterInput::Actions random_actions(std::mt19937& rng)
+{
+    std::uniform_int_distribution<unsigned long> actions(
+        0, (1ul << static_cast<int>(urdf::FighterInput::Action::FIRE)) - 1);
+    return urdf::FighterInput::Actions(actions(rng));
+}
+
+Result run(std::mt19937& rng,
+           const urdf::FighterModel& model,
+           const Link& link,
+           const int num_ticks)
+{
+    auto server = net::GameServer(std::make_shared<ecs::Scene>(true), 0, dt);
+    auto relay = LossyLink(net::Address::loopback(server.get_port()), link, rng);
+    auto client = net::GameClient(relay.get_address());
+
+    int tick = 0;
+    const auto run_server_tick = [&]() {
+        relay.pump(tick);
+        server.update();
+        relay.pump(tick);
+        ++tick;
+    };
+
+    while (!client.connected())
+    {
+        if (tick > 600)
+        {
+            std::fprintf(stderr, "Could not connect\n");
+            std::exit(EXIT_FAILURE);
+        }
+        client.connect();
+        run_server_tick();
+        client.poll();
+    }
+
+    auto prediction = net::FighterPrediction(model, client.get_codec(), dt);
+    const auto entity = client.get_welcome().entity;
+
+    // By then the first inputs have made the round trip, and any corrections are due to the link
+    const int settled_tick = tick + 60 + 4 * (link.latency_ticks + link.jitter_ticks);
+
+    std::uniform_int_distribution<int> change(0, mean_hold_ticks - 1);
+    auto actions = urdf::FighterInput::Actions();
+    auto result = Result();
+    for (int i = 0; i < num_ticks; ++i)
+    {
+        if (client.poll())
+        {
+            ++result.num_snapshots;
+
+            const auto before = prediction.get_state() ? std::optional(*prediction.get_state())
+                                                       : std::nullopt;
+            const auto num_corrections = prediction.get_num_corrections();
+            std::size_t num_resimulated = 0;
+            const auto ms = time_ms([&]() {
+                num_resimulated = prediction.reconcile(*client.get_latest_snapshot(), entity);
+            });
+
+            // Not counting the first snapshot, which the prediction starts from
+            if (before && prediction.get_num_corrections() > num_corrections)
+            {
+                ++result.num_corrections;
+                result.num_late_corrections += tick >= settled_tick;
+
+                const double jump = (prediction.get_state()->position - before->position).norm();
+                result.total_jump += jump;
+                result.max_jump = std::max(result.max_jump, jump);
+                result.total_resimulated += num_resimulated;
+                result.max_resimulated =
+                    std::max(result.max_resimulated, static_cast<int>(num_resimulated));
+                result.max_rollback_ms = std::max(result.max_rollback_ms, ms);
+            }
+        }
+
+        if (change(rng) == 0)
+        {
+            actions = random_actions(rng);
+        }
+        prediction.predict(client.send_input(actions), actions);
+
+        run_server_tick();
+    }
+
+    return result;
+}
+
+// Rolls back num_ticks pending inputs, over and over, and returns the mean time it took
+double time_rollback(std::mt19937& rng,
+                     const urdf::FighterModel& model,
+                     const geometry::MotionStateCodec& codec,
+                     const int num_ticks)
+{
+    constexpr int num_repeats = 1000;
+    const auto entity = entt::entity(0);
+
+    auto prediction = net::FighterPrediction(model, codec, dt);
+    auto snapshot = net::Snapshot{ 0, net::no_tick, {} };
+    snapshot.states.emplace_back(
+        entity,
+        codec.quantize(geometry::MotionState(Eigen::Vector3f::Zero(),
+                                             Eigen::Quaternionf::Identity())));
+    for (int i = 0; i < num_ticks; ++i)
+    {
+        prediction.predict(static_cast<std::uint32_t>(i), random_actions(rng));
+    }
+
+    // Nothing applied yet and no state predicted to match, so every call re-simulates them all
+    double total_ms = 0.0;
+    for (int i = 0; i < num_repeats; ++i)
+    {
+        ++snapshot.tick;
+        total_ms += time_ms([&]() { prediction.reconcile(snapshot, entity); });
+    }
+    return total_ms / num_repeats;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_ticks = argc > 1 ? std::atoi(argv[1]) : 1800;
+
+    std::mt19937 rng(1234);
+    const auto model = urdf::parse_fighter_urdf("awing.urdf");
+
+    constexpr std::array<Link, 6> links = { Link{ 0, 0, 0.0f },  Link{ 3, 0, 0.0f },
+                                            Link{ 6, 0, 0.0f },  Link{ 6, 2, 0.05f },
+                                            Link{ 9, 3, 0.1f },  Link{ 15, 3, 0.2f } };
+
+    bool ok = true;
+    std::printf("%8s %8s %6s %10s %12s %10s %10s %14s %10s %10s\n",
+                "rtt ms",
+                "jitter",
+                "loss",
+                "snapshots",
+                "corrections",
+                "resim mean",
+                "resim max",
+                "rollback max",
+                "jump mean",
+                "jump max");
+    for (const auto& link : links)
+    {
+        const auto result = run(rng, model, link, num_ticks);
+        const auto mean = [&result](const double total) {
+            return result.num_corrections > 0 ? total / result.num_corrections : 0.0;
+        };
+        std::printf("%8.0f %8d %5.0f%% %10d %5d (%4d) %10.1f %10d %11.3f ms %8.3f m %8.3f m\n",
+                    2.0 * link.latency_ticks * dt * 1000.0,
+                    link.jitter_ticks,
+                    100.0 * link.loss,
+                    result.num_snapshots,
+                    result.num_corrections,
+                    result.num_late_corrections,
+                    mean(result.total_resimulated),
+                    result.max_resimulated,
+                    result.max_rollback_ms,
+                    mean(result.total_jump),
+                    result.max_jump);
+
+        if (link.jitter_ticks == 0 && link.loss == 0.0f && result.num_late_corrections > 0)
+        {
+            std::printf("  the prediction diverged from the server over a perfect link\n");
+            ok = false;
+        }
+    }
+    std::printf("(corrections in brackets: after the first inputs got through)\n");
+
+    const auto codec = geometry::MotionStateCodec(Eigen::Vector3f::Zero(),
+                                                  8192.0f,
+                                                  { model.motion_limits.velocity,
+                                                    model.motion_limits.acceleration,
+                                                    model.motion_limits.angular_velocity,
+                                                    model.motion_limits.angular_acceleration });
+    std::printf("\n%14s %14s %14s\n", "rollback ticks", "mean ms", "of a frame");
+    for (const int rollback_ticks : { 1, 10, 30, 60, 120 })
+    {
+        const auto ms = time_rollback(rng, model, codec, rollback_ticks);
+        std::printf("%14d %14.4f %13.2f%%\n", rollback_ticks, ms, 100.0 * ms / frame_budget_ms);
+        ok &= rollback_ticks != 10 || ms < frame_budget_ms;
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,102 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "geometry/collision.h"
+#include "geometry/geometry.h"
+
+// Times testing a batch of laser rays against one fighter's box, one ray_aabb_test at a time
+// against one batched ray_obb_test call, and checks that both find the same hits. Rays start
+// around the box with random headings, so a fraction of them hit.
+
+namespace
+{
+constexpr float laser_speed = 1000.0f;
+constexpr float laser_length = 4.0f;
+constexpr float dt = 1.0f / 60.0f;
+
+struct Laser
+{
+    Eigen::Isometry3f pose;
+};
+
+template <typename Fn>
+double time_ns(Fn&& fn, const int repetitions)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; ++i)
+    {
+        fn();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / repetitions;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> pos(-15.0f, 15.0f);
+
+    const Eigen::Vector3f dimensions(8.4f, 8.2f, 10.2f);
+    const auto T_world_obb = geometry::make_pose(Eigen::Vector3f(100.0f, -20.0f, 5.0f),
+                                                 Eigen::Quaternionf::UnitRandom());
+    const float tmax = laser_length / 2.0f;
+    const float tmin = -laser_length / 2.0f - laser_speed * dt;
+
+    std::printf("%10s %16s %16s %10s %10s\n",
+                "rays",
+                "scalar (ns/ray)",
+                "batched (ns/ray)",
+                "hits",
+                "mismatch");
+
+    for (const int num_rays : { 8, 64, 1000, 10000, 100000 })
+    {
+        std::vector<Laser> lasers;
+        geometry::RayBatch rays;
+        for (int i = 0; i < num_rays; ++i)
+        {
+            const auto pose = geometry::make_pose(
+                T_world_obb.translation() + Eigen::Vector3f(pos(rng), pos(rng), pos(rng)),
+                Eigen::Quaternionf::UnitRandom());
+            lasers.push_back({ pose });
+            rays.push_back(pose.translation(), pose.linear().col(0), tmin, tmax);
+        }
+
+        const int repetitions = std::max(10, 1000000 / num_rays);
+
+        std::vector<bool> scalar_hits(num_rays);
+        const double scalar_ns = time_ns(
+            [&]() {
+                for (int i = 0; i < num_rays; ++i)
+                {
+                    scalar_hits[i] = geometry::ray_aabb_test(
+                        lasers[i].pose, tmax, tmin, T_world_obb, dimensions);
+                }
+            },
+            repetitions);
+
+        std::vector<std::uint64_t> hit_mask;
+        const double batched_ns = time_ns(
+            [&]() { geometry::ray_obb_test(rays, T_world_obb, dimensions, hit_mask); },
+            repetitions);
+
+        int hits = 0;
+        int mismatches = 0;
+        for (int i = 0; i < num_rays; ++i)
+        {
+            const bool hit = (hit_mask[i / 64] >> (i % 64)) & 1;
+            hits += hit;
+            mismatches += hit != scalar_hits[i];
+        }
+
+        std::printf("%10d %16.2f %16.2f %10d %10d\n",
+                    num_rays,
+                    scalar_ns / num_rays,
+                    batched_ns / num_rays,
+                    hits,
+                    mismatches);
+    }
+}
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ecs/scene.h"
+#include "net/client.h"
+#include "net/server.h"
+#include "urdf/fighter_input.h"
+
+// Runs a net::GameServer over loopback UDP for a growing number of bot clients in the same
+// process, which steer at random without firing, so that all of them stay alive. Server and bots
+// run in lockstep: every tick each bot handles what the server sent and sends its input, then the
+// server ticks. Reports the server's tick time and the bandwidth each client takes at 60 Hz, in
+// both directions, along with how many snapshots went out in full over the whole run. That should
+// be the first one of each client, as the others are delta encoded against the last one it
+// acknowledged, and the benchmark fails if it is more than twice that.
+//
+// Usage: server_benchmark [num_ticks] [max_clients]
+
+namespace
+{
+constexpr float dt = 1.0f / 60.0f;
+constexpr int num_warmup_ticks = 60;
+
+// How many ticks a bot holds its actions for, on average
+constexpr int mean_hold_ticks = 30;
+
+struct Result
+{
+    int num_clients;
+    double tick_mean_ms;
+    double tick_max_ms;
+    double down_bytes_per_tick;  // Per client
+    double up_bytes_per_tick;
+    std::uint64_t full_snapshots;
+};
+
+std::uint64_t total_bytes_sent(const net::GameServer& server)
+{
+    std::uint64_t bytes = 0;
+    for (const auto& client : server.get_client_stats())
+    {
+        bytes += client.bytes_sent;
+    }
+    return bytes;
+}
+
+std::uint64_t total_bytes_received(const net::GameServer& server)
+{
+    std::uint64_t bytes = 0;
+    for (const auto& client : server.get_client_stats())
+    {
+        bytes += client.bytes_received;
+    }
+    return bytes;
+}
+
+Result run(std::mt19937& rng, const int num_clients, const int num_ticks)
+{
+    auto options = net::GameServer::Options();
+    options.max_clients = static_cast<std::size_t>(num_clients);
+    auto server = net::GameServer(std::make_shared<ecs::Scene>(true), 0, dt, options);
+    const auto address = net::Address::loopback(server.get_port());
+
+    std::vector<std::unique_ptr<net::GameClient>> bots;
+    for (int i = 0; i < num_clients; ++i)
+    {
+        bots.push_back(std::make_unique<net::GameClient>(address));
+    }
+
+    const auto all_connected = [&bots]() {
+        return std::all_of(bots.begin(), bots.end(), [](const auto& bot) {
+            return bot->connected();
+        });
+    };
+    for (int attempt = 0; attempt < 100 && !all_connected(); ++attempt)
+    {
+        for (auto& bot : bots)
+        {
+            bot->connect();
+        }
+        server.update();
+        for (auto& bot : bots)
+        {
+            bot->poll();
+        }
+    }
+    if (!all_connected())
+    {
+        std::fprintf(stderr, "Not all %d clients could connect\n", num_clients);
+        std::exit(EXIT_FAILURE);
+    }
+
+    // Steering and throttle, but not the fire actions
+    std::uniform_int_distribution<unsigned long> random_actions(
+        0, (1ul << static_cast<int>(urdf::FighterInput::Action::FIRE)) - 1);
+    std::uniform_int_distribution<int> change(0, mean_hold_ticks - 1);
+    std::vector<urdf::FighterInput::Actions> actions(bots.size());
+
+    auto result = Result{ num_clients, 0.0, 0.0, 0.0, 0.0, 0 };
+    std::uint64_t bytes_sent = 0;
+    std::uint64_t bytes_received = 0;
+    for (int tick = -num_warmup_ticks; tick < num_ticks; ++tick)
+    {
+        if (tick == 0)
+        {
+            bytes_sent = total_bytes_sent(server);
+            bytes_received = total_bytes_received(server);
+        }
+
+        for (std::size_t i = 0; i < bots.size(); ++i)
+        {
+            bots[i]->poll();
+            if (change(rng) == 0)
+            {
+                actions[i] = urdf::FighterInput::Actions(random_actions(rng));
+            }
+            bots[i]->send_input(actions[i]);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        server.update();
+        const auto ms = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+
+        if (tick >= 0)
+        {
+            result.tick_mean_ms += ms / num_ticks;
+            result.tick_max_ms = std::max(result.tick_max_ms, ms);
+        }
+    }
+
+    const double per_client_tick = static_cast<double>(num_clients) * num_ticks;
+    result.down_bytes_per_tick = (total_bytes_sent(server) - bytes_sent) / per_client_tick;
+    result.up_bytes_per_tick = (total_bytes_received(server) - bytes_received) / per_client_tick;
+    for (const auto& client : server.get_client_stats())
+    {
+        result.full_snapshots += client.full_snapshots_sent;
+    }
+
+    return result;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_ticks = argc > 1 ? std::atoi(argv[1]) : 600;
+    const int max_clients = argc > 2 ? std::atoi(argv[2]) : 64;
+
+    std::mt19937 rng(1234);
+
+    const auto kbit_per_s = [](const double bytes_per_tick) {
+        return 8.0 * bytes_per_tick / dt / 1000.0;
+    };
+
+    std::printf("%8s %14s %14s %14s %14s %14s\n",
+                "clients",
+                "tick mean ms",
+                "tick max ms",
+                "down kbit/s",
+                "up kbit/s",
+                "full snapshots");
+    bool ok = true;
+    for (int num_clients = 1; num_clients <= max_clients; num_clients *= 4)
+    {
+        const auto result = run(rng, num_clients, num_ticks);
+        std::printf("%8d %14.3f %14.3f %14.1f %14.1f %14llu\n",
+                    result.num_clients,
+                    result.tick_mean_ms,
+                    result.tick_max_ms,
+                    kbit_per_s(result.down_bytes_per_tick),
+                    kbit_per_s(result.up_bytes_per_tick),
+                    static_cast<unsigned long long>(result.full_snapshots));
+
+        // A few clients may have to be sent another if loopback drops packets, but not every tick
+        if (result.full_snapshots > 2 * static_cast<std::uint64_t>(num_clients))
+        {
+            std::fprintf(stderr,
+                         "%d clients were sent %llu full snapshots, expected about one each\n",
+                         num_clients,
+                         static_cast<unsigned long long>(result.full_snapshots));
+            ok = false;
+        }
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ecs/command_buffer.h"
+#include "ecs/components.h"
+#include "ecs/scene.h"
+#include "ecs/systems.h"
+#include "geometry/geometry.h"
+
+// Times each phase of systems::integrate on synthetic headless scenes, for a grid of fighter and
+// laser counts. Fighters are spread at constant density, and lasers are scattered through the same
+// volume with random headings. Prints a table and writes the numbers as JSON, by default to
+// sim_benchmark.json, so runs on different commits can be compared.
+//
+// Usage: sim_benchmark [output.json] [num_ticks]
+
+namespace
+{
+constexpr float dt = 1.0f / 60.0f;
+constexpr int num_warmup_ticks = 3;
+
+// The phases of systems::integrate, run one after the other, plus the final command buffer flush
+constexpr std::array<const char*, 10> phase_names = {
+    "camera",     "motion", "sweep",         "fighters",   "control",
+    "collisions", "lasers", "sound_effects", "billboards", "sync"
+};
+
+struct PhaseStats
+{
+    double total_ms = 0.0;
+    double min_ms = 0.0;
+};
+
+struct Result
+{
+    int num_fighters;
+    int num_lasers;
+    int num_ticks;
+    std::array<PhaseStats, phase_names.size()> phases;
+    double tick_mean_ms;
+};
+
+Eigen::Vector3f random_position(std::mt19937& rng, const float extent)
+{
+    std::uniform_real_distribution<float> pos(-extent, extent);
+    return Eigen::Vector3f(pos(rng), pos(rng), pos(rng));
+}
+
+std::unique_ptr<ecs::Scene> create_scene(std::mt19937& rng,
+                                         const int num_fighters,
+                                         const int num_lasers)
+{
+    auto scene = std::make_unique<ecs::Scene>(true);
+
+    // A-wings and TIEs alternate, so about half of the fighter and laser pairs are on the same team
+    // and pruned by their collision filters
+    scene->friendly_fire = false;
+
+    // ~40 m between fighters on average, whatever the count
+    const float extent = 20.0f * std::cbrt(static_cast<float>(num_fighters));
+
+    std::vector<entt::entity> fighters;
+    for (int i = 0; i < num_fighters; ++i)
+    {
+        fighters.push_back(scene->register_ship("fighter_" + std::to_string(i),
+                                                i % 2 ? "tie.urdf" : "awing.urdf",
+                                                random_position(rng, extent),
+                                                Eigen::Quaternionf::UnitRandom()));
+    }
+    scene->player_uid = fighters.front();
+    scene->camera_uid =
+        scene->register_camera(geometry::perspective(M_PI / 2.0f, 4.0f / 3.0f, 5.0f, 8192.0f));
+
+    std::uniform_int_distribution<int> producer(0, num_fighters - 1);
+    for (int i = 0; i < num_lasers; ++i)
+    {
+        const auto entity = fighters[producer(rng)];
+        const auto& model = scene->registry.get<FighterComponent>(entity).model;
+        scene->register_laser(
+            random_position(rng, extent), Eigen::Quaternionf::UnitRandom(), model, 0.0f, entity);
+    }
+
+    return scene;
+}
+
+template <typename Fn>
+double time_ms(Fn&& fn)
+{
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    const auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+Result run(std::mt19937& rng, const int num_fighters, const int num_lasers, const int num_ticks)
+{
+    auto scene = create_scene(rng, num_fighters, num_lasers);
+    float t = 0.0f;
+
+    // The phases are timed one by one rather than through the scene's Scheduler, so they record
+    // into a buffer of their own
+    ecs::CommandBuffer commands;
+
+    for (int i = 0; i < num_warmup_ticks; ++i)
+    {
+        ecs::systems::integrate(*scene, t, dt);
+        t += dt;
+    }
+
+    auto result = Result{ num_fighters, num_lasers, num_ticks, {}, 0.0 };
+    for (int tick = 0; tick < num_ticks; ++tick)
+    {
+        const std::array<double, phase_names.size()> ms = {
+            time_ms([&]() { ecs::systems::update_camera(*scene, dt); }),
+            time_ms([&]() { ecs::systems::integrate_motion(*scene, dt); }),
+            time_ms([&]() { ecs::systems::sweep_collisions(*scene); }),
+            time_ms([&]() { ecs::systems::update_fighters(*scene, commands, t); }),
+            time_ms([&]() { ecs::systems::control_fighters(*scene, dt); }),
+            time_ms([&]() { ecs::systems::detect_collisions(*scene, commands, t, dt); }),
+            time_ms([&]() { ecs::systems::expire_lasers(*scene, t); }),
+            time_ms([&]() {
+                ecs::systems::remove_finished_sound_effects(*scene, commands);
+            }),
+            time_ms([&]() { ecs::systems::expire_billboards(*scene, commands, t); }),
+            time_ms([&]() { commands.flush(*scene); })
+        };
+        t += dt;
+
+        for (std::size_t i = 0; i < ms.size(); ++i)
+        {
+            auto& phase = result.phases[i];
+            phase.min_ms = tick == 0 ? ms[i] : std::min(phase.min_ms, ms[i]);
+            phase.total_ms += ms[i];
+            result.tick_mean_ms += ms[i] / num_ticks;
+        }
+    }
+
+    return result;
+}
+
+void write_json(const std::string& filename, const std::vector<Result>& results)
+{
+    FILE* file = std::fopen(filename.c_str(), "w");
+    if (!file)
+    {
+        std::fprintf(stderr, "Could not open %s for writing\n", filename.c_str());
+        return;
+    }
+
+    std::fprintf(file, "{\n  \"benchmark\": \"sim\",\n  \"dt\": %g,\n  \"results\": [\n", dt);
+    for (std::size_t r = 0; r < results.size(); ++r)
+    {
+        const auto& result = results[r];
+        std::fprintf(file,
+                     "    {\n      \"fighters\": %d,\n      \"lasers\": %d,\n      \"ticks\": %d,\n"
+                     "      \"tick_mean_ms\": %.6f,\n      \"phases\": {\n",
+                     result.num_fighters,
+                     result.num_lasers,
+                     result.num_ticks,
+                     result.tick_mean_ms);
+        for (std::size_t i = 0; i < phase_names.size(); ++i)
+        {
+            std::fprintf(file,
+                         "        \"%s\": { \"mean_ms\": %.6f, \"min_ms\": %.6f }%s\n",
+                         phase_names[i],
+                         result.phases[i].total_ms / result.num_ticks,
+                         result.phases[i].min_ms,
+                         i + 1 < phase_names.size() ? "," : "");
+        }
+        std::fprintf(file, "      }\n    }%s\n", r + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    std::fclose(file);
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const std::string output_filename = argc > 1 ? argv[1] : "sim_benchmark.json";
+    const int num_ticks = argc > 2 ? std::stoi(argv[2]) : 30;
+
+    std::mt19937 rng(1234);
+    std::vector<Result> results;
+
+    std::printf("%8s %8s", "fighters", "lasers");
+    for (const auto* name : phase_names)
+    {
+        std::printf(" %13s", name);
+    }
+    std::printf(" %13s\n", "tick (ms)");
+
+    for (const int num_fighters : { 10, 100, 1000, 10000 })
+    {
+        for (const int num_lasers : { 100, 1000, 10000, 100000 })
+        {
+            const auto& result =
+                results.emplace_back(run(rng, num_fighters, num_lasers, num_ticks));
+
+            std::printf("%8d %8d", num_fighters, num_lasers);
+            for (const auto& phase : result.phases)
+            {
+                std::printf(" %13.3f", phase.total_ms / num_ticks);
+            }
+            std::printf(" %13.3f\n", result.tick_mean_ms);
+        }
+    }
+
+    write_json(output_filename, results);
+    std::printf("Wrote %s\n", output_filename.c_str());
+}
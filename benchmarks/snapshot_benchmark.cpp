@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "ecs/components.h"
+#include "ecs/scene.h"
+#include "ecs/snapshot.h"
+#include "ecs/systems.h"
+#include "geometry/geometry.h"
+
+// Times saving and restoring snapshots of synthetic headless scenes, set up like sim_benchmark's,
+// after they have run for a few ticks. Restoring goes into the scene the snapshot was taken of,
+// after it ran on, like seeking back in a replay. Also checks that the restored motion states,
+// health, fighters and lasers are those that were saved, and fails if they aren't.
+//
+// Usage: snapshot_benchmark [num_repeats]
+
+namespace
+{
+constexpr float dt = 1.0f / 60.0f;
+constexpr int num_ticks = 10;
+
+Eigen::Vector3f random_position(std::mt19937& rng, const float extent)
+{
+    std::uniform_real_distribution<float> pos(-extent, extent);
+    return Eigen::Vector3f(pos(rng), pos(rng), pos(rng));
+}
+
+std::unique_ptr<ecs::Scene> create_scene(std::mt19937& rng,
+                                         const int num_fighters,
+                                         const int num_lasers)
+{
+    auto scene = std::make_unique<ecs::Scene>(true);
+    scene->friendly_fire = false;
+
+    const float extent = 20.0f * std::cbrt(static_cast<float>(num_fighters));
+
+    std::vector<entt::entity> fighters;
+    for (int i = 0; i < num_fighters; ++i)
+    {
+        fighters.push_back(scene->register_ship("fighter_" + std::to_string(i),
+                                                i % 2 ? "tie.urdf" : "awing.urdf",
+                                                random_position(rng, extent),
+                                                Eigen::Quaternionf::UnitRandom()));
+    }
+    scene->player_uid = fighters.front();
+    scene->camera_uid =
+        scene->register_camera(geometry::perspective(M_PI / 2.0f, 4.0f / 3.0f, 5.0f, 8192.0f));
+
+    std::uniform_int_distribution<int> producer(0, num_fighters - 1);
+    for (int i = 0; i < num_lasers; ++i)
+    {
+        const auto entity = fighters[producer(rng)];
+        const auto& model = scene->registry.get<FighterComponent>(entity).model;
+        scene->register_laser(
+            random_position(rng, extent), Eigen::Quaternionf::UnitRandom(), model, 0.0f, entity);
+    }
+
+    return scene;
+}
+
+template <typename Fn>
+double time_ms(Fn&& fn)
+{
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    const auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+// What is saved of a scene, in the order its views iterate it, comparable with ==
+struct SavedState
+{
+    std::vector<std::tuple<entt::entity,
+                           Eigen::Vector3f,
+                           Eigen::Vector4f,  // Orientation coefficients
+                           Eigen::Vector3f,
+                           Eigen::Vector3f,
+                           Eigen::Vector3f,
+                           Eigen::Vector3f>>
+        motion_states;
+    std::vector<std::tuple<entt::entity, float, float>> healths;
+    std::vector<std::tuple<entt::entity,
+                           std::string,  // Name
+                           std::string,  // Model URI
+                           unsigned long,  // Actions
+                           int,
+                           int,
+                           float,
+                           std::optional<float>>>
+        fighters;
+    std::vector<std::tuple<Eigen::Vector3f,
+                           Eigen::Vector4f,
+                           Eigen::Vector3f,
+                           float,
+                           float,
+                           float,
+                           float,
+                           entt::entity,
+                           std::uint32_t,
+                           std::string,  // Fighter model URI
+                           bool>>
+        lasers;
+
+    bool operator==(const SavedState& other) const
+    {
+        return motion_states == other.motion_states && healths == other.healths &&
+               fighters == other.fighters && lasers == other.lasers;
+    }
+};
+
+SavedState get_saved_state(const ecs::Scene& scene)
+{
+    SavedState out;
+    for (const auto [entity, state] : scene.registry.view<MotionStateComponent>().each())
+    {
+        out.motion_states.emplace_back(entity,
+                                       state.position,
+                                       state.orientation.coeffs(),
+                                       state.velocity,
+                                       state.acceleration,
+                                       state.angular_velocity,
+                                       state.angular_acceleration);
+    }
+    for (const auto [entity, health] : scene.registry.view<HealthComponent>().each())
+    {
+        out.healths.emplace_back(entity, health.shields, health.hull);
+    }
+    for (const auto [entity, fighter] : scene.registry.view<FighterComponent>().each())
+    {
+        out.fighters.emplace_back(entity,
+                                  fighter.name,
+                                  fighter.model->uri,
+                                  fighter.input.get_actions().to_ulong(),
+                                  fighter.current_fire_mode,
+                                  fighter.current_spawn_idx,
+                                  fighter.last_fired_time,
+                                  fighter.time_of_death);
+    }
+    for (const auto& laser : scene.lasers)
+    {
+        out.lasers.emplace_back(laser.origin,
+                                laser.orientation.coeffs(),
+                                laser.direction,
+                                laser.spawn_time,
+                                laser.speed,
+                                laser.lifetime,
+                                laser.length,
+                                laser.producer,
+                                laser.mask,
+                                laser.fighter_model->uri,
+                                laser.killed);
+    }
+    return out;
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    const int num_repeats = argc > 1 ? std::stoi(argv[1]) : 10;
+
+    std::mt19937 rng(1234);
+
+    bool ok = true;
+    std::printf("%8s %8s %12s %12s %12s %10s\n",
+                "fighters",
+                "lasers",
+                "size (KiB)",
+                "save (ms)",
+                "load (ms)",
+                "round trip");
+
+    for (const int num_fighters : { 100, 1000, 10000 })
+    {
+        const int num_lasers = 10 * num_fighters;
+        auto scene = create_scene(rng, num_fighters, num_lasers);
+
+        float t = 0.0f;
+        for (int i = 0; i < num_ticks; ++i)
+        {
+            ecs::systems::integrate(*scene, t, dt);
+            t += dt;
+        }
+
+        std::vector<char> snapshot;
+        double save_ms = 0.0;
+        double load_ms = 0.0;
+        bool identical = true;
+        for (int i = 0; i < num_repeats; ++i)
+        {
+            const auto saved_state = get_saved_state(*scene);
+            const auto save = time_ms([&]() { ecs::save_snapshot(*scene, t, snapshot); });
+
+            // Diverge from the snapshot before restoring it
+            ecs::systems::integrate(*scene, t, dt);
+
+            const auto load = time_ms([&]() { t = ecs::load_snapshot(*scene, snapshot); });
+
+            identical = identical && get_saved_state(*scene) == saved_state;
+
+            save_ms = i == 0 ? save : std::min(save_ms, save);
+            load_ms = i == 0 ? load : std::min(load_ms, load);
+        }
+
+        std::printf("%8d %8d %12.1f %12.3f %12.3f %10s\n",
+                    num_fighters,
+                    num_lasers,
+                    static_cast<double>(snapshot.size()) / 1024.0,
+                    save_ms,
+                    load_ms,
+                    identical ? "identical" : "DIFFERS");
+        ok &= identical;
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ecs
+{
+/**
+ * @brief Appends values to a byte buffer as they are laid out in memory, for the binary formats of
+ * snapshots and replays. Only meant for data read back by the same build on the same platform.
+ */
+class BinaryWriter
+{
+  public:
+    explicit BinaryWriter(std::vector<char>& out) : out(out)
+    {
+    }
+
+    void write_bytes(const void* data, const std::size_t size)
+    {
+        const auto* bytes = static_cast<const char*>(data);
+        out.insert(out.end(), bytes, bytes + size);
+    }
+
+    template <typename T>
+    void write(const T& value)
+    {
+        write_bytes(static_cast<const void*>(&value), sizeof(T));
+    }
+
+    void write_size(const std::size_t size)
+    {
+        write(static_cast<std::uint32_t>(size));
+    }
+
+    void write_string(const std::string& value)
+    {
+        write_size(value.size());
+        write_bytes(value.data(), value.size());
+    }
+
+  private:
+    std::vector<char>& out;
+};
+
+// Reads back what a BinaryWriter wrote, throwing std::runtime_error instead of reading past the end
+class BinaryReader
+{
+  public:
+    explicit BinaryReader(const std::vector<char>& data) : data(data)
+    {
+    }
+
+    void read_bytes(void* out, const std::size_t size)
+    {
+        if (size > data.size() - offset)
+        {
+            throw std::runtime_error("Unexpected end of binary data");
+        }
+        std::memcpy(out, data.data() + offset, size);
+        offset += size;
+    }
+
+    template <typename T>
+    T read()
+    {
+        T value;
+        read_bytes(static_cast<void*>(&value), sizeof(T));
+        return value;
+    }
+
+    // Checked against what is left, so that a corrupt count fails before allocating
+    template <typename T>
+    void read_array(std::vector<T>& values, const std::size_t count)
+    {
+        if (count > (data.size() - offset) / sizeof(T))
+        {
+            throw std::runtime_error("Unexpected end of binary data");
+        }
+        values.resize(count);
+        read_bytes(static_cast<void*>(values.data()), count * sizeof(T));
+    }
+
+    std::size_t read_size()
+    {
+        return read<std::uint32_t>();
+    }
+
+    std::string read_string()
+    {
+        std::vector<char> chars;
+        read_array(chars, read_size());
+        return std::string(chars.begin(), chars.end());
+    }
+
+    void seek(const std::size_t position)
+    {
+        if (position > data.size())
+        {
+            throw std::runtime_error("Seeking past the end of binary data");
+        }
+        offset = position;
+    }
+
+    std::size_t remaining() const
+    {
+        return data.size() - offset;
+    }
+
+  private:
+    const std::vector<char>& data;
+    std::size_t offset = 0;
+};
+
+void write_binary_file(const std::string& filename, const std::vector<char>& data);
+std::vector<char> read_binary_file(const std::string& filename);
+}  // namespace ecs
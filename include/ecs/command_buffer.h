@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+namespace ecs
+{
+class Scene;
+
+/**
+ * @brief Records spawns, component emplacements and despawns requested while systems iterate
+ * views, and applies them all at once when flushed at a sync point.
+ *
+ * Recorded commands are placement-constructed into fixed-size blocks that are kept between
+ * flushes, so once the busiest tick has been seen, recording allocates nothing.
+ */
+class CommandBuffer
+{
+  public:
+    CommandBuffer() = default;
+    ~CommandBuffer();
+
+    CommandBuffer(const CommandBuffer&) = delete;
+    CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+    // Defers fn(scene), typically a call to one of the Scene::register_* functions
+    template <typename Fn>
+    void spawn(Fn&& fn)
+    {
+        push(std::forward<Fn>(fn));
+    }
+
+    // Defers constructing (or replacing) a Component on an existing entity
+    template <typename Component, typename... Args>
+    void emplace(const entt::entity entity, Args... args)
+    {
+        push([entity, args...](auto& scene) {
+            scene.registry.template emplace_or_replace<Component>(entity, args...);
+        });
+    }
+
+    // Defers destroying the entity. Recording the same entity several times is fine.
+    void destroy(const entt::entity entity);
+
+    // Runs the recorded commands in order, then destroys the recorded entities. Commands must not
+    // record new commands into the buffer being flushed.
+    void flush(Scene& scene);
+
+    bool empty() const;
+
+  private:
+    static constexpr std::size_t block_size = 16 * 1024;
+
+    struct Block
+    {
+        alignas(std::max_align_t) std::byte data[block_size];
+    };
+
+    struct Command
+    {
+        void (*apply)(void* self, Scene& scene);
+        void (*dispose)(void* self);
+        void* self;
+    };
+
+    template <typename Fn>
+    void push(Fn&& fn)
+    {
+        using FnType = std::decay_t<Fn>;
+        static_assert(sizeof(FnType) <= block_size, "Command too large for a CommandBuffer block");
+        static_assert(alignof(FnType) <= alignof(std::max_align_t), "Over-aligned command");
+
+        void* self = new (allocate(sizeof(FnType), alignof(FnType))) FnType(std::forward<Fn>(fn));
+
+        commands.push_back(
+            { [](void* self, Scene& scene) { (*static_cast<FnType*>(self))(scene); },
+              [](void* self) { static_cast<FnType*>(self)->~FnType(); },
+              self });
+    }
+
+    void* allocate(const std::size_t size, const std::size_t alignment);
+    void clear_commands();
+
+    std::vector<Command> commands;
+    std::vector<entt::entity> to_destroy;
+
+    std::vector<std::unique_ptr<Block>> blocks;
+    std::size_t current_block = 0;
+    std::size_t block_offset = 0;
+};
+}  // namespace ecs
@@ -1,10 +1,12 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <optional>
 #include <entt/entt.hpp>
 #include <Eigen/Dense>
 
+#include "geometry/bvh.h"
 #include "geometry/geometry.h"
 #include "geometry/spline.h"
 #include "rendering/model.h"
@@ -44,10 +46,22 @@ struct CameraComponent
 
 struct FighterComponent
 {
-    FighterComponent(const std::string& name, entt::resource<const urdf::FighterModel> model);
+    FighterComponent(const std::string& name,
+                     entt::resource<const urdf::FighterModel> model,
+                     const bool with_audio = true);
+
+    // Reuses a collision shape already built for the model, e.g. when restoring many fighters
+    FighterComponent(const std::string& name,
+                     entt::resource<const urdf::FighterModel> model,
+                     const geometry::CollisionShape& collision_shape,
+                     const bool with_audio = true);
 
     std::string name;
     entt::resource<const urdf::FighterModel> model;
+
+    // A box of the model's dimensions around the fighter frame, swept against other shapes
+    geometry::CollisionShape collision_shape;
+
     urdf::FighterInput input;
     int current_fire_mode = 0;
     int current_spawn_idx = 0;
@@ -73,15 +87,55 @@ struct FighterComponent
      */
     geometry::MotionState get_target_state(const geometry::MotionState& motion_state) const;
 
+    // The same for any fighter of the model, e.g. one predicted outside of a scene
+    static geometry::MotionState get_target_state(const urdf::FighterModel& model,
+                                                  const urdf::FighterInput& input,
+                                                  const geometry::MotionState& motion_state);
+
+    // Null for fighters created without audio (headless scenes)
     std::unique_ptr<audio::AudioSource> fire_sound_source;
     std::unique_ptr<audio::AudioSource> engine_sound_source;
 };
 
-struct LaserComponent
+// A static scenario object, e.g. a capital ship
+struct ActorComponent
+{
+    std::string name;
+};
+
+// Collision model of a many-part entity, expressed in the entity frame
+struct CollisionComponent
+{
+    entt::resource<const geometry::Bvh> bvh;
+};
+
+/**
+ * @brief Which bodies are tested for collisions against each other. A pair is only tested if each
+ * one's layer is in the other's mask, and a laser only hits bodies whose layer is in the laser mask
+ * of the ship that fired it.
+ */
+struct CollisionFilterComponent
+{
+    std::uint32_t layer = ~0u;
+    std::uint32_t mask = ~0u;
+    std::uint32_t laser_mask = ~0u;
+
+    // Puts every team on its own layer. Ships collide with everything, and their lasers hit all
+    // but their own team unless friendly_fire.
+    static CollisionFilterComponent for_team(const int team, const bool friendly_fire);
+
+    bool collides_with(const CollisionFilterComponent& other) const
+    {
+        return (layer & other.mask) && (other.layer & mask);
+    }
+};
+
+// The pose at the start of the tick, so that collision shapes can be swept over it and renders
+// interpolated along it
+struct PreviousPoseComponent
 {
-    entt::entity producer;
-    entt::resource<const urdf::FighterModel> fighter_model;
-    float length;
+    Eigen::Vector3f position;
+    Eigen::Quaternionf orientation;
 };
 
 struct SkyboxComponent
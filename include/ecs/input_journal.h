@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "ecs/scene.h"
+
+namespace ecs
+{
+/**
+ * @brief Records the actions of every fighter at every tick of a match, run-length encoded per
+ * fighter, so that the match can be replayed by feeding them back into a scene created from the
+ * same scenario (see Playback, and ReplayRecorder for storing it along with checkpoints).
+ *
+ * Ticks are of a fixed length and the systems give the same results whatever threads they run on,
+ * so a scene's inputs are all it takes to reproduce it. Held actions cost one run however long they
+ * are held, and fighters that are never steered one run in total.
+ */
+class InputJournal
+{
+  public:
+    // A fighter's actions over a number of ticks in a row
+    struct Run
+    {
+        std::uint32_t num_ticks;
+        std::uint16_t actions;
+    };
+
+    // The actions of one fighter from the first tick it was recorded at to the last
+    struct Track
+    {
+        entt::entity entity;
+        std::uint32_t first_tick;
+        std::uint32_t end_tick;  // One past the last
+        std::vector<Run> runs;
+    };
+
+    // Feeds a journal's actions back into a scene, tick by tick
+    class Playback
+    {
+      public:
+        explicit Playback(const InputJournal& journal);
+
+        /**
+         * @brief Sets the actions of the journal's fighters to those recorded for the tick, i.e.
+         * call before each integrate(). Systems consume some actions (e.g. toggling the fire mode),
+         * so every fighter's are set, not just those that changed.
+         *
+         * Cheap for the tick after the last one applied, while any other tick scans the journal.
+         */
+        void apply(Scene& scene, const std::uint32_t tick);
+
+      private:
+        // The run a track is at, and the tick it started at
+        struct Cursor
+        {
+            std::size_t run = 0;
+            std::uint32_t run_start = 0;
+        };
+
+        void seek(const std::uint32_t tick);
+
+        const InputJournal& journal;
+        std::vector<Cursor> cursors;
+        std::uint32_t next_tick = 0;
+    };
+
+    InputJournal(const std::string& scenario_name, const float dt);
+
+    // Records the actions of every fighter for the next tick, i.e. call before each integrate()
+    void record(const Scene& scene);
+
+    const std::string& get_scenario_name() const;
+    float get_dt() const;
+    std::uint32_t get_num_ticks() const;
+    const std::vector<Track>& get_tracks() const;
+
+    // Stored in replay files, see ReplayRecorder
+    void serialize(std::vector<char>& out) const;
+
+    // @throws std::runtime_error if the data isn't a journal of this version
+    static InputJournal deserialize(const std::vector<char>& data);
+
+  private:
+    std::string scenario_name;
+    float dt;
+    std::uint32_t num_ticks = 0;
+    std::vector<Track> tracks;
+
+    // By entity index, 1 + the index of the last track of that entity, or 0 if it has none
+    std::vector<std::size_t> last_tracks;
+};
+}  // namespace ecs
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "ecs/render_snapshot.h"
+
+namespace ecs
+{
+/**
+ * @brief Draws an ImGui window with the rolling timings of every profiled section, tick and frame
+ * time histograms, and the number of entities in each component pool as of the snapshot.
+ *
+ * Must be called between ContextManager::imgui_new_frame() and ContextManager::imgui_render().
+ */
+void draw_profiler_overlay(const RenderSnapshot& snapshot);
+}  // namespace ecs
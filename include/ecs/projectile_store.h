@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <entt/entt.hpp>
+
+#include "urdf/fighter_model.h"
+
+namespace ecs
+{
+/**
+ * @brief Flat storage for lasers in flight, which are not entities.
+ *
+ * A laser flies in a straight line at constant speed, so it is fully described by where, when and
+ * in which direction it was fired. Its position is computed on demand instead of being integrated
+ * every tick, and a projectile costs nothing between spawning and being hit tested.
+ */
+class ProjectileStore
+{
+  public:
+    struct Projectile
+    {
+        Eigen::Vector3f origin;
+        Eigen::Quaternionf orientation;
+        Eigen::Vector3f direction;  // Unit length, the orientation's X axis
+        float spawn_time;
+        float speed;
+        float lifetime;
+        float length;
+        entt::entity producer;
+        std::uint32_t mask;  // Layers it hits, see CollisionFilterComponent
+        const urdf::FighterModel* fighter_model;  // Owned by the scene's ResourceManager
+        bool killed = false;
+
+        Eigen::Vector3f position(const float t) const;
+        Eigen::Isometry3f pose(const float t) const;
+        bool expired(const float t) const;
+    };
+
+    void spawn(const Eigen::Vector3f& origin,
+               const Eigen::Quaternionf& orientation,
+               const float spawn_time,
+               const urdf::FighterModel& fighter_model,
+               const entt::entity producer,
+               const std::uint32_t mask = ~0u);
+
+    // Adds a projectile as it was, e.g. when restoring a snapshot
+    void insert(const Projectile& projectile);
+
+    // Marks a projectile for removal by the next compact(). Its index stays valid until then.
+    void kill(const std::size_t i);
+
+    // Removes killed and expired projectiles, keeping the others in spawn order
+    void compact(const float t);
+
+    void clear();
+    std::size_t size() const;
+    const Projectile& operator[](const std::size_t i) const;
+
+    std::vector<Projectile>::const_iterator begin() const;
+    std::vector<Projectile>::const_iterator end() const;
+
+  private:
+    std::vector<Projectile> projectiles;
+};
+}  // namespace ecs
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+
+#include "rendering/model.h"
+#include "rendering/texture.h"
+
+namespace ecs
+{
+/**
+ * @brief Everything render() draws, copied out of a Scene after a tick by
+ * systems::publish_snapshot(), so that rendering never touches the registry and can run on another
+ * thread than the simulation.
+ *
+ * Poses are kept at both the start and the end of the tick, and drawn interpolated between them.
+ * Models and textures are owned by the scene's ResourceManager, which must outlive the snapshot.
+ */
+struct RenderSnapshot
+{
+    struct Pose
+    {
+        Eigen::Vector3f position;
+        Eigen::Quaternionf orientation;
+    };
+
+    struct Motion
+    {
+        Pose start;
+        Pose end;
+
+        // The pose at fraction alpha of the tick
+        Eigen::Isometry3f pose(const float alpha) const;
+    };
+
+    struct Visual
+    {
+        Motion motion;
+        const rendering::Model* model;
+        Eigen::Matrix4f scale;
+
+        // One per mesh, textures[textures_begin, textures_begin + number of meshes), if any
+        std::optional<std::size_t> textures_begin;
+        std::optional<Eigen::Vector3f> color;
+    };
+
+    struct Laser
+    {
+        Motion motion;
+        Eigen::Matrix4f scale;
+        Eigen::Vector3f color;
+    };
+
+    struct Billboard
+    {
+        Motion motion;
+        Eigen::Matrix4f scale;
+        float birth_time;
+    };
+
+    struct Skybox
+    {
+        const rendering::Model* model;
+        const rendering::Texture* texture;
+    };
+
+    float t = 0.0f;   // At the end of the tick
+    float dt = 0.0f;  // Length of the tick
+    std::chrono::steady_clock::time_point published_at;
+
+    Motion camera;
+    std::vector<Visual> visuals;
+    std::vector<const rendering::Texture*> textures;
+    std::vector<Laser> lasers;
+    std::vector<Billboard> billboards;
+    std::vector<Skybox> skyboxes;
+    std::vector<Eigen::Matrix<float, 4, 3>> splines;  // Control points
+
+    // Entities per component pool, for the profiler overlay
+    std::vector<std::pair<const char*, std::size_t>> pool_sizes;
+
+    // The time at fraction alpha of the tick
+    float time(const float alpha) const
+    {
+        return t - (1.0f - alpha) * dt;
+    }
+};
+}  // namespace ecs
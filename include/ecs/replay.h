@@ -0,0 +1,105 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ecs/input_journal.h"
+#include "ecs/scene.h"
+#include "ecs/snapshot.h"
+
+namespace ecs
+{
+/**
+ * @brief Records a match to a replay file: its input journal, plus a snapshot (see
+ * save_snapshot()) every checkpoint_interval seconds for Replay::seek() to start from.
+ *
+ * The simulation thread only copies the component pools into a recycled SceneCapture (see
+ * capture_scene()), and a thread of the recorder's own encodes it and appends it to the file, so
+ * checkpoints don't stall ticks on allocations, encoding or disk writes. The journal and the
+ * checkpoint index are written by finish().
+ */
+class ReplayRecorder
+{
+  public:
+    ReplayRecorder(const std::string& filename,
+                   const std::string& scenario_name,
+                   const float dt,
+                   const float checkpoint_interval = 10.0f);
+
+    // Calls finish() if it hasn't been
+    ~ReplayRecorder();
+
+    ReplayRecorder(const ReplayRecorder&) = delete;
+    ReplayRecorder& operator=(const ReplayRecorder&) = delete;
+
+    // Records the inputs of the next tick, starting at time t, and a checkpoint if one is due. Call
+    // before each integrate().
+    void record(const Scene& scene, const float t);
+
+    // Writes what is left and closes the file
+    void finish();
+
+  private:
+    struct PendingCheckpoint
+    {
+        std::uint32_t tick;
+        SceneCapture capture;
+    };
+
+    void run_writer();
+
+    std::ofstream file;
+    InputJournal journal;
+    std::uint32_t checkpoint_interval_ticks;
+
+    // (tick, file offset) of every checkpoint written so far
+    std::vector<std::pair<std::uint32_t, std::uint64_t>> index;
+
+    std::mutex mutex;
+    std::condition_variable wake_writer;
+    std::vector<PendingCheckpoint> pending;
+    std::vector<SceneCapture> free_captures;
+    bool finishing = false;
+    std::thread writer_thread;
+};
+
+/**
+ * @brief A match read back from a file written by ReplayRecorder.
+ */
+class Replay
+{
+  public:
+    // @throws std::runtime_error if the file isn't a replay of this version
+    static Replay read(const std::string& filename);
+
+    const InputJournal& get_journal() const;
+
+    // Ticks the checkpoints were taken at, in order
+    std::vector<std::uint32_t> get_checkpoint_ticks() const;
+
+    /**
+     * @brief Brings a scene created from the replay's scenario to the start of a tick: restores the
+     * last checkpoint at or before it, and re-simulates the ticks from there with playback, which
+     * is left to carry on from the tick. Returns the time at the start of the tick.
+     */
+    float seek(Scene& scene, InputJournal::Playback& playback, const std::uint32_t tick) const;
+
+  private:
+    struct Checkpoint
+    {
+        std::uint32_t tick;
+        std::vector<char> data;
+    };
+
+    explicit Replay(InputJournal journal);
+
+    InputJournal journal;
+    std::vector<Checkpoint> checkpoints;
+};
+}  // namespace ecs
@@ -7,6 +7,7 @@
 #include "rendering/shader_program.h"
 #include "urdf/fighter_model.h"
 #include "audio/audio.h"
+#include "geometry/bvh.h"
 #include "resources/load_model.h"
 #include "resources/load_texture.h"
 #include "resources/load_geometry.h"
@@ -85,7 +86,9 @@ struct fighter_model_loader final
 
     result_type operator()(const std::string& uri) const
     {
-        return std::make_shared<urdf::FighterModel>(urdf::parse_fighter_urdf(uri));
+        auto model = std::make_shared<urdf::FighterModel>(urdf::parse_fighter_urdf(uri));
+        model->uri = uri;
+        return model;
     }
 };
 
@@ -100,10 +103,22 @@ struct sound_loader final
     }
 };
 
+struct collision_model_loader final
+{
+    using result_type = std::shared_ptr<geometry::Bvh>;
+
+    result_type operator()(const std::string& uri) const
+    {
+        return std::make_shared<geometry::Bvh>(
+            geometry::CollisionShape(resources::load_geometry(uri)));
+    }
+};
+
 class ResourceManager
 {
   public:
-    ResourceManager();
+    // A headless manager skips the GL primitives, and is only meant for non-GPU resources
+    ResourceManager(const bool headless = false);
 
     void load_model(const std::string& uri);
     void load_primitive(const std::string& name);
@@ -115,6 +130,7 @@ class ResourceManager
                      const std::optional<std::string>& geom_filename = std::nullopt);
     void load_fighter_model(const std::string& uri);
     void load_sound(const std::string& uri);
+    void load_collision_model(const std::string& uri);
 
     void update_shaders(std::function<void(const entt::resource<rendering::ShaderProgram>&)> fn);
 
@@ -123,6 +139,7 @@ class ResourceManager
     entt::resource<const rendering::ShaderProgram> get_shader(const std::string& uri) const;
     entt::resource<const urdf::FighterModel> get_fighter_model(const std::string& uri) const;
     entt::resource<const audio::AudioBuffer> get_sound(const std::string& uri) const;
+    entt::resource<const geometry::Bvh> get_collision_model(const std::string& uri) const;
 
   private:
     entt::resource_cache<rendering::Model, model_loader> model_cache;
@@ -130,5 +147,6 @@ class ResourceManager
     entt::resource_cache<rendering::ShaderProgram, shader_loader> shader_cache;
     entt::resource_cache<urdf::FighterModel, fighter_model_loader> fighter_model_cache;
     entt::resource_cache<audio::AudioBuffer, sound_loader> sound_cache;
+    entt::resource_cache<geometry::Bvh, collision_model_loader> collision_model_cache;
 };
 }  // namespace ecs
@@ -1,40 +1,57 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <Eigen/Dense>
 #include <entt/entt.hpp>
 
 #include "control/camera_controller.h"
 #include "control/ship_controller.h"
+#include "geometry/broadphase.h"
+#include "geometry/motion_state_arrays.h"
+#include "jobs/thread_pool.h"
+#include "ecs/projectile_store.h"
 #include "ecs/resource_manager.h"
+#include "ecs/scheduler.h"
 
 namespace ecs
 {
 class Scene
 {
   public:
-    Scene();
+    /**
+     * @brief Creates an empty scene.
+     *
+     * @param headless if true, no shaders, models, textures or sounds are loaded and no audio
+     * sources are created, so that the scene can be simulated without a GL context or audio device
+     */
+    Scene(const bool headless = false);
     ~Scene() = default;
 
     entt::entity register_ship(const std::string& name,
                                const std::string& urdf_filename,
                                const Eigen::Vector3f& position,
-                               const Eigen::Quaternionf& orientation);
-    entt::entity register_camera(const Eigen::Matrix4f& perspective);
-    entt::entity register_laser(const Eigen::Vector3f& position,
+                               const Eigen::Quaternionf& orientation,
+                               const std::optional<int>& team = std::nullopt);
+    entt::entity register_actor(const std::string& name,
+                                const std::string& visual_filename,
+                                const std::optional<std::string>& geometry_filename,
+                                const Eigen::Vector3f& position,
                                 const Eigen::Quaternionf& orientation,
-                                const entt::resource<const urdf::FighterModel> model,
-                                const Eigen::Vector3f& size,
-                                const Eigen::Vector3f color,
-                                const float speed,
-                                entt::entity producer);
+                                const std::optional<int>& team = std::nullopt);
+    entt::entity register_camera(const Eigen::Matrix4f& perspective);
+    void register_laser(const Eigen::Vector3f& position,
+                        const Eigen::Quaternionf& orientation,
+                        const entt::resource<const urdf::FighterModel> model,
+                        const float birth_time,
+                        entt::entity producer);
     entt::entity register_billboard(const Eigen::Vector3f& position,
                                     const Eigen::Quaternionf& orientation,
                                     const Eigen::Vector3f& size,
                                     const float birth_time,
                                     const float duration);
     entt::entity register_skybox(const std::string& skybox_uri);
-    entt::entity register_sound_effect(const std::string buffer_name,
+    entt::entity register_sound_effect(const std::string& buffer_name,
                                        const Eigen::Vector3f,
                                        const Eigen::Quaternionf& orientation);
     entt::entity register_spline(const Eigen::Vector3f& c0,
@@ -42,13 +59,38 @@ class Scene
                                  const Eigen::Vector3f& c2,
                                  const Eigen::Vector3f& c3);
 
+    // Gives an entity a VisualComponent of the model, loading it and its textures if need be
+    void emplace_visual(const entt::entity entity, const std::string& visual_filename);
+
+    const bool headless;
+
     entt::registry registry;
     ecs::ResourceManager resource_manager;  // Could be made shared_ptr to allow scenes to share
                                             // same mgr
 
+    // Whether lasers hit ships on the team that fired them. Only applies to ships registered after
+    // it is set.
+    bool friendly_fire = true;
+
     entt::entity player_uid = entt::null;
     entt::entity camera_uid = entt::null;
     control::CameraController camera_controller;
     control::ShipController ship_controller;
+
+    // Rebuilt every tick from the world AABBs of the volumes the fighters swept over it. Ids are
+    // entt::entity values.
+    geometry::UniformGrid fighter_grid = geometry::UniformGrid(32.0f);
+
+    // Shared by all systems for splitting per-entity updates across cores
+    jobs::ThreadPool thread_pool;
+
+    // Scratch SoA copy of every MotionStateComponent, for the batched integration kernel
+    geometry::MotionStateArrays motion_state_arrays;
+
+    // The systems integrate() runs, added on its first call
+    Scheduler scheduler;
+
+    // Lasers in flight. They are not entities (see ProjectileStore).
+    ProjectileStore lasers;
 };
 }  // namespace ecs
@@ -9,6 +9,7 @@ namespace ecs
 {
 struct SceneFactory
 {
-    static std::shared_ptr<Scene> create_from_scenario(const std::string& scenario_name);
+    static std::shared_ptr<Scene> create_from_scenario(const std::string& scenario_name,
+                                                       const bool headless = false);
 };
 }  // namespace ecs
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "ecs/command_buffer.h"
+#include "jobs/task_graph.h"
+
+namespace ecs
+{
+class Scene;
+
+// The components, or other parts of a scene (e.g. ProjectileStore), that a system reads or writes
+template <typename... Types>
+struct Reads
+{
+};
+
+template <typename... Types>
+struct Writes
+{
+};
+
+/**
+ * @brief Runs the systems that make up a tick, each declaring what it reads and writes, at the
+ * same time where their declarations allow (see jobs::TaskGraph), and as if one after the other
+ * in the order they were added otherwise.
+ *
+ * Every system records its structural changes into a command buffer of its own, and the buffers
+ * are flushed at the end of the tick in the order the systems were added, so the outcome doesn't
+ * depend on which systems happened to run at the same time.
+ */
+class Scheduler
+{
+  public:
+    using SystemFn = std::function<void(Scene& scene, CommandBuffer& commands, float t, float dt)>;
+
+    // Exclusive systems split their own work across scene.thread_pool, so never share it
+    template <typename... Read, typename... Write>
+    void add(const char* name,
+             SystemFn fn,
+             Reads<Read...>,
+             Writes<Write...>,
+             const bool exclusive = false)
+    {
+        add(name,
+            std::move(fn),
+            { std::type_index(typeid(Read))... },
+            { std::type_index(typeid(Write))... },
+            exclusive);
+    }
+
+    bool empty() const;
+
+    // Runs every system once, then flushes their commands
+    void run(Scene& scene, const float t, const float dt);
+
+    const jobs::TaskGraph& get_graph() const;
+    const char* get_name(const std::size_t system) const;
+
+  private:
+    void add(const char* name,
+             SystemFn fn,
+             const jobs::TaskGraph::Access& reads,
+             const jobs::TaskGraph::Access& writes,
+             const bool exclusive);
+
+    struct System
+    {
+        const char* name;
+        SystemFn fn;
+        std::unique_ptr<CommandBuffer> commands;
+    };
+
+    std::vector<System> systems;
+    jobs::TaskGraph graph;
+};
+}  // namespace ecs
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "ecs/components.h"
+#include "ecs/scene.h"
+
+namespace ecs
+{
+/**
+ * @brief What save_snapshot() saves of a scene, copied out of it as is by capture_scene() for
+ * write_snapshot() to encode later, e.g. on another thread. A capture that is reused keeps the
+ * capacity of its arrays.
+ */
+struct SceneCapture
+{
+    // A component pool in the order its view iterates it
+    template <typename Component>
+    struct Pool
+    {
+        std::vector<entt::entity> entities;
+        std::vector<Component> components;
+    };
+
+    // All of a FighterComponent but its collision shape and audio sources
+    struct Fighter
+    {
+        entt::resource<const urdf::FighterModel> model;
+        std::string name;
+        std::uint32_t actions;
+        int current_fire_mode;
+        int current_spawn_idx;
+        float last_fired_time;
+        std::optional<float> time_of_death;
+    };
+
+    float t = 0;
+    entt::entity player_uid = entt::null;
+    entt::entity camera_uid = entt::null;
+
+    Pool<MotionStateComponent> motion_states;
+    Pool<PreviousPoseComponent> previous_poses;
+    Pool<HealthComponent> healths;
+    Pool<CollisionFilterComponent> collision_filters;
+    Pool<BillboardComponent> billboards;
+    Pool<Eigen::Matrix<float, 4, 3>> splines;  // By their control points
+    Pool<Fighter> fighters;
+    std::vector<entt::entity> roaming_entities;
+    std::vector<ProjectileStore::Projectile> lasers;
+};
+
+/**
+ * @brief Copies the state of a running scene that save_snapshot() saves into a capture, without
+ * allocating once the capture has held a scene of the same size.
+ */
+void capture_scene(const Scene& scene, const float t, SceneCapture& capture);
+
+/**
+ * @brief Encodes a capture as save_snapshot() does a scene. Only reads the capture, and the fighter
+ * models it refers to, so it may run on another thread while the scene moves on.
+ *
+ * @param out overwritten, reusing its capacity
+ */
+void write_snapshot(const SceneCapture& capture, std::vector<char>& out);
+
+/**
+ * @brief Saves the state of a running scene to a flat binary buffer: motion states, previous
+ * poses, health, collision filters, fighters (all but their audio sources), billboards, splines
+ * and lasers in flight, along with the time it was taken at.
+ *
+ * Each component pool is stored as an array of entity ids followed by an array of fixed-size
+ * records, written field by field so that no padding or pointer ends up in the buffer. Resources
+ * are stored by the hash of their URI, with a table of the URIs to load them from. Sound effects
+ * aren't saved.
+ *
+ * @param out overwritten, reusing its capacity
+ */
+void save_snapshot(const Scene& scene, const float t, std::vector<char>& out);
+
+/**
+ * @brief Restores a snapshot into a scene created from the same scenario, e.g. one that has run
+ * on since the snapshot was saved, and returns the time it was taken at.
+ *
+ * Fighters, billboards, splines and sound effects in the scene are replaced by those of the
+ * snapshot, with the same entity ids. Other entities (cameras, capital ships, the skybox) are
+ * kept, and the saved components of those with the same ids overwritten. Pools are restored by
+ * bulk inserting their records, without replaying any Scene::register_* call, and fighter models
+ * are only loaded if the scene's ResourceManager doesn't hold them yet.
+ *
+ * @throws std::runtime_error if the data isn't a snapshot of this version, or one of its entities
+ * is held by another entity the scene keeps. The scene is left untouched then.
+ */
+float load_snapshot(Scene& scene, const std::vector<char>& data);
+}  // namespace ecs
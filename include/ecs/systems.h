@@ -1,9 +1,36 @@
 #pragma once
+#include "ecs/command_buffer.h"
+#include "ecs/render_snapshot.h"
 #include "ecs/scene.h"
 #include "input/key_event.h"
 namespace ecs::systems
 {
+// Copies what render() draws out of the scene, at time t at the end of a tick of length dt. Only
+// reads the scene, and leaves all GL calls to render().
+void publish_snapshot(const Scene& scene, const float t, const float dt, RenderSnapshot& snapshot);
+
+// Draws a snapshot at fraction alpha of its tick. Only reads the shaders and primitive models of
+// the resource manager, so can run on another thread than the one updating the scene.
+void render(const RenderSnapshot& snapshot,
+            const ResourceManager& resource_manager,
+            const float alpha);
+
+// Publishes and renders the scene at time t, for when both run on the same thread
 void render(const Scene& scene, const float t);
+
+// Runs one tick of length dt from time t, through scene.scheduler
 void integrate(Scene& scene, const float t, const float dt);
 void handle_key_events(Scene& scene, const std::vector<KeyEvent>& key_events);
+
+// The phases of integrate(), in the order it adds them to scene.scheduler. Structural changes are
+// recorded in the given command buffer, and left to the caller to flush.
+void update_camera(Scene& scene, const float dt);
+void integrate_motion(Scene& scene, const float dt);
+void sweep_collisions(Scene& scene);
+void update_fighters(Scene& scene, CommandBuffer& commands, const float t);
+void control_fighters(Scene& scene, const float dt);
+void detect_collisions(Scene& scene, CommandBuffer& commands, const float t, const float dt);
+void expire_lasers(Scene& scene, const float t);
+void remove_finished_sound_effects(Scene& scene, CommandBuffer& commands);
+void expire_billboards(Scene& scene, CommandBuffer& commands, const float t);
 }  // namespace ecs::systems
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+
+namespace geometry
+{
+/**
+ * @brief Uniform grid broadphase. Bodies are inserted by their world AABB into every cell they
+ * overlap, and queries return the ids of all bodies sharing a cell with the query volume.
+ *
+ * Cells are kept as a flat array of (cell key, id) entries sorted by key, so rebuilding the grid
+ * every tick reuses the same storage.
+ */
+class UniformGrid
+{
+  public:
+    explicit UniformGrid(const float cell_size);
+
+    void clear();
+    void insert(const std::uint32_t id, const Eigen::Vector3f& min, const Eigen::Vector3f& max);
+
+    // Must be called after the last insert and before any query
+    void build();
+
+    // Appends the ids of bodies in cells crossed by the segment [from, to]. Sorted and unique.
+    void query_segment(const Eigen::Vector3f& from,
+                       const Eigen::Vector3f& to,
+                       std::vector<std::uint32_t>& out) const;
+
+    // Appends the ids of bodies in cells overlapped by the box [min, max]. Sorted and unique.
+    void query_aabb(const Eigen::Vector3f& min,
+                    const Eigen::Vector3f& max,
+                    std::vector<std::uint32_t>& out) const;
+
+    float get_cell_size() const;
+    std::size_t num_entries() const;
+
+  private:
+    struct Entry
+    {
+        std::uint64_t key;
+        std::uint32_t id;
+    };
+
+    Eigen::Vector3i to_cell(const Eigen::Vector3f& point) const;
+    static std::uint64_t to_key(const Eigen::Vector3i& cell);
+    void append_cell(const Eigen::Vector3i& cell, std::vector<std::uint32_t>& out) const;
+
+    float cell_size;
+    std::vector<Entry> entries;
+};
+
+// World-frame AABB (min, max) of a box with the given dimensions, centered at the pose origin
+std::pair<Eigen::Vector3f, Eigen::Vector3f> world_aabb(const Eigen::Isometry3f& pose,
+                                                       const Eigen::Vector3f& dimensions);
+}  // namespace geometry
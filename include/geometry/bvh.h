@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+
+#include "geometry/collision.h"
+
+namespace geometry
+{
+/**
+ * @brief A bounding volume hierarchy over the convex leaves of a CollisionShape tree, for testing
+ * rays and shapes against large models made of many parts (e.g. capital ships).
+ *
+ * The leaves are regrouped into a balanced binary tree by splitting them along the longest axis of
+ * their centers, rather than following the hierarchy of the model file. Every node bounds its
+ * leaves with both an AABB and a fitted OBB, and is only descended into if a query overlaps both.
+ * Everything is expressed in the frame of the model.
+ */
+class Bvh
+{
+  public:
+    static constexpr std::uint32_t max_leaves_per_node = 2;
+
+    struct Obb
+    {
+        Eigen::Matrix3f rotation;  // Columns are the box axes
+        Eigen::Vector3f center;
+        Eigen::Vector3f half_extents;
+    };
+
+    struct Node
+    {
+        Eigen::AlignedBox3f aabb;
+        Obb obb;
+
+        // Leaves [first_leaf, first_leaf + num_leaves) are under this node
+        std::uint32_t first_leaf;
+        std::uint32_t num_leaves;
+
+        // Index of the first child, the second one follows it. 0 (the root) for leaf nodes.
+        std::uint32_t child = 0;
+
+        bool is_leaf() const
+        {
+            return child == 0;
+        }
+    };
+
+    // A part, as the points x within its bounds for which
+    // lo[i] <= shape.face_normals.col(i).dot(x) <= hi[i]. Clipping to the bounds keeps parts that
+    // are not closed and convex from reaching beyond their vertices.
+    struct Leaf
+    {
+        CollisionShape shape;
+        Eigen::AlignedBox3f aabb;
+        Obb obb;
+        Eigen::VectorXf lo;
+        Eigen::VectorXf hi;
+    };
+
+    struct RayHit
+    {
+        std::size_t leaf;
+        float t;
+    };
+
+    explicit Bvh(const CollisionShape& root);
+
+    // The closest hit of origin + t * direction for t in [tmin, tmax], if any
+    std::optional<RayHit> raycast(const Eigen::Vector3f& origin,
+                                  const Eigen::Vector3f& direction,
+                                  const float tmin,
+                                  const float tmax) const;
+
+    // As raycast, but stops at the first leaf hit instead of looking for the closest one
+    bool raycast_any(const Eigen::Vector3f& origin,
+                     const Eigen::Vector3f& direction,
+                     const float tmin,
+                     const float tmax) const;
+
+    // The first leaf found to intersect shape, where relative_pose brings shape into the model
+    // frame. Like the ray queries, allocates nothing.
+    const Leaf* intersect(const CollisionShape& shape,
+                          const Eigen::Isometry3f& relative_pose) const;
+
+    // Appends the indices of the leaves whose AABBs overlap box, expressed in the model frame
+    void query_aabb(const Eigen::AlignedBox3f& box, std::vector<std::uint32_t>& out) const;
+
+    const std::vector<Node>& get_nodes() const;
+    const std::vector<Leaf>& get_leaves() const;
+
+  private:
+    // Fits the bounds of every node to those of the leaves below it
+    void refit();
+
+    template <bool any_hit>
+    std::optional<RayHit> traverse(const Eigen::Vector3f& origin,
+                                   const Eigen::Vector3f& direction,
+                                   const float tmin,
+                                   float tmax) const;
+
+    std::vector<Node> nodes;
+    std::vector<Leaf> leaves;
+};
+}  // namespace geometry
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <optional>
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+
+#include "geometry/collision.h"
+#include "geometry/gjk.h"
+
+namespace geometry
+{
+// The motion of a shape over a tick, from its pose at the start to its pose at the end. Positions
+// are interpolated linearly and orientations spherically in between.
+struct Sweep
+{
+    Eigen::Vector3f start_position;
+    Eigen::Quaternionf start_orientation;
+    Eigen::Vector3f end_position;
+    Eigen::Quaternionf end_orientation;
+
+    // The pose at fraction s of the tick
+    Eigen::Isometry3f pose(const float s) const;
+};
+
+struct TimeOfImpact
+{
+    float s;  // Fraction of the tick at which the shapes touch
+
+    // In world, at s
+    Eigen::Vector3f normal;  // From a towards b
+    Eigen::Vector3f point;   // On a
+
+    // False if the shapes were still further apart than the tolerance at s when the advancement
+    // ran out of iterations, e.g. for a grazing pair. Stopping them at s is then safe, but they
+    // didn't touch.
+    bool contact;
+};
+
+/**
+ * @brief The first time two sweeping shapes come within tolerance of each other, by conservative
+ * advancement (Mirtich): the gap between them is measured with gjk(), and the shapes are advanced
+ * by as much of the tick as they can't possibly close that gap in.
+ *
+ * Like gjk(), only the convex hulls of the vertices are swept, children are not descended into.
+ *
+ * @param simplex warm starts the gjk() queries, one per step, from each other
+ * @return std::nullopt if the shapes stay apart, or already touch or intersect at the start of the
+ * tick
+ */
+std::optional<TimeOfImpact> time_of_impact(const CollisionShape& a,
+                                           const Sweep& sweep_a,
+                                           const CollisionShape& b,
+                                           const Sweep& sweep_b,
+                                           GjkSimplex& simplex,
+                                           const float tolerance = 0.01f);
+
+// World AABB (min, max) of everything a shape sweeps, given the radius of a sphere around its
+// frame origin that holds it
+std::pair<Eigen::Vector3f, Eigen::Vector3f> swept_aabb(const Sweep& sweep, const float radius);
+
+// Radius of the sphere around the frame origin that holds all vertices of a shape
+float bounding_radius(const CollisionShape& shape);
+}  // namespace geometry
@@ -1,6 +1,8 @@
 #pragma once
 
-#include <optional>
+#include <cstdint>
+#include <string>
+#include <vector>
 
 #include <Eigen/Dense>
 #include <Eigen/Geometry>
@@ -34,13 +36,24 @@ struct CollisionShape
 
     CollisionShape(const resources::GeometryData& data);
 
+    std::string name;
+
     Eigen::Matrix3Xf vertices;
     Eigen::Matrix3Xf face_normals;
     Eigen::Matrix3Xf edges;
 
+    // Hill climbing adjacency of the vertices, see Hull. Empty unless the mesh is closed and
+    // convex.
+    std::vector<std::uint32_t> neighbour_offsets;
+    std::vector<std::uint32_t> neighbours;
+
     Eigen::Vector3f min;
     Eigen::Vector3f max;
 
+    // Whether this is the box [min, max], as are shapes made from extents and the inner nodes of
+    // trees. Two boxes are tested against each other in closed form.
+    bool is_box = false;
+
     Eigen::Vector3f scale() const
     {
         return max - min;
@@ -58,6 +71,10 @@ struct CollisionShape
         return edges.cols();
     }
 
+    // Index of the vertex furthest along direction. Hill climbs from start if the vertices have
+    // adjacency, which is fastest when start is the answer to a similar earlier query.
+    std::uint32_t support(const Eigen::Vector3f& direction, const std::uint32_t start = 0) const;
+
     std::vector<CollisionShape> children;
 };
 
@@ -70,6 +87,32 @@ bool ray_aabb_test(const Eigen::Isometry3f& T_world_ray,
                    const Eigen::Isometry3f& T_world_aabb,
                    const Eigen::Vector3f& aabb_dimensions);
 
+/**
+ * @brief Rays packed one array per coordinate, for testing many rays against one box at a time.
+ *
+ * Ray i covers origin + t * direction for t in [tmin[i], tmax[i]].
+ */
+struct RayBatch
+{
+    std::vector<float> origin_x, origin_y, origin_z;
+    std::vector<float> direction_x, direction_y, direction_z;
+    std::vector<float> tmin, tmax;
+
+    void clear();
+    void push_back(const Eigen::Vector3f& origin,
+                   const Eigen::Vector3f& direction,
+                   const float tmin,
+                   const float tmax);
+    std::size_t size() const;
+};
+
+// Tests every ray of the batch, expressed in world, against a box of the given dimensions centered
+// at T_world_obb. Bit i % 64 of hit_mask[i / 64] is set if ray i hits. Eight rays per instruction.
+void ray_obb_test(const RayBatch& rays,
+                  const Eigen::Isometry3f& T_world_obb,
+                  const Eigen::Vector3f& obb_dimensions,
+                  std::vector<std::uint64_t>& hit_mask);
+
 // When ray and AABB are both expressed in the AABB frame
 bool ray_aabb_test(const Eigen::Vector3f& ray_dir,
                    const Eigen::Vector3f& ray_origin,
@@ -77,9 +120,26 @@ bool ray_aabb_test(const Eigen::Vector3f& ray_dir,
                    float tmin,
                    const Eigen::Vector3f& extents);
 
-std::optional<CollisionShape> intersect_test(const CollisionShape& a,
-                                             const CollisionShape& b,
-                                             const Eigen::Isometry3f& relative_pose);
+/**
+ * @brief Tests shape b, and then its children, against shape a. Allocates nothing.
+ *
+ * @param relative_pose brings b into the frame of a
+ * @return the leaf of b found to intersect a (b itself if it has no children), or null
+ */
+const CollisionShape* intersect_test(const CollisionShape& a,
+                                     const CollisionShape& b,
+                                     const Eigen::Isometry3f& relative_pose);
+
+// Whether two boxes centered at their frames intersect, where relative_pose brings B into A's frame
+bool obb_intersect_test(const Eigen::Vector3f& half_extents_a,
+                        const Eigen::Vector3f& half_extents_b,
+                        const Eigen::Isometry3f& relative_pose);
+
+// When both boxes are expressed in world, e.g. two fighters
+bool obb_intersect_test(const Eigen::Isometry3f& T_world_a,
+                        const Eigen::Vector3f& dimensions_a,
+                        const Eigen::Isometry3f& T_world_b,
+                        const Eigen::Vector3f& dimensions_b);
 
 bool intersects(const Ray& ray,
                 const Eigen::Vector3f& extents,          // Extents of AABB
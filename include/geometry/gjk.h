@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+
+#include "geometry/collision.h"
+
+namespace geometry
+{
+/**
+ * @brief The simplex a GJK query ended on, as indices into the vertices of the two shapes.
+ *
+ * Shapes are rigid, so the indices stay valid as the shapes move. Keeping one per pair of shapes
+ * and passing it to the next query warm starts it from where the last one ended, which usually
+ * leaves only an iteration or two when the shapes moved little since.
+ */
+struct GjkSimplex
+{
+    std::array<std::uint32_t, 4> index_a;
+    std::array<std::uint32_t, 4> index_b;
+    int size = 0;
+};
+
+struct GjkResult
+{
+    bool intersecting;
+    float distance;  // 0 if intersecting
+
+    // Closest points of the two shapes, in the frame of a. Only meaningful if not intersecting.
+    Eigen::Vector3f point_a;
+    Eigen::Vector3f point_b;
+
+    int num_iterations;
+};
+
+struct Contact
+{
+    Eigen::Vector3f normal;  // In the frame of a, from a towards b
+    float depth;             // Moving b by depth along normal separates the shapes
+
+    // Deepest points of the two shapes, in the frame of a
+    Eigen::Vector3f point_a;
+    Eigen::Vector3f point_b;
+};
+
+/**
+ * @brief Distance between, or intersection of, the convex hulls of the vertices of a and b.
+ *
+ * Children are not descended into. Allocates nothing.
+ *
+ * @param relative_pose brings b into the frame of a
+ * @param simplex warm starts the query if not empty, and is set to the simplex it ended on
+ */
+GjkResult gjk(const CollisionShape& a,
+              const CollisionShape& b,
+              const Eigen::Isometry3f& relative_pose,
+              GjkSimplex& simplex);
+
+/**
+ * @brief Penetration of intersecting shapes, by expanding the simplex a gjk() query reported them
+ * intersecting with (EPA).
+ *
+ * @return std::nullopt if the shapes only touch
+ */
+std::optional<Contact> epa(const CollisionShape& a,
+                           const CollisionShape& b,
+                           const Eigen::Isometry3f& relative_pose,
+                           const GjkSimplex& simplex);
+
+// gjk(), followed by epa() if the shapes intersect
+std::optional<Contact> contact_test(const CollisionShape& a,
+                                    const CollisionShape& b,
+                                    const Eigen::Isometry3f& relative_pose,
+                                    GjkSimplex& simplex);
+}  // namespace geometry
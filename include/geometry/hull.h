@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include <Eigen/Dense>
+
+namespace geometry
+{
+/**
+ * @brief The collision attributes of a triangle mesh, cooked once at load time.
+ *
+ * Meshes come triangulated, with every flat face split into triangles and every triangle edge
+ * stored. SAT only needs one axis per direction, so the triangle normals and edges are
+ * deduplicated down to those of the hull's actual faces.
+ */
+struct Hull
+{
+    // One per face plane, merging coplanar triangles and parallel faces (opposite sides of a box)
+    Eigen::Matrix3Xf face_normals;
+
+    // One per edge direction, leaving out the edges between coplanar triangles
+    Eigen::Matrix3Xf edges;
+
+    // Vertex i is connected to neighbours[neighbour_offsets[i], neighbour_offsets[i + 1]). Only
+    // filled in if the mesh is closed and convex, as hill climbing over it finds the support
+    // point of such meshes only.
+    std::vector<std::uint32_t> neighbour_offsets;
+    std::vector<std::uint32_t> neighbours;
+};
+
+Hull cook_hull(const Eigen::Matrix3Xf& vertices,
+               const std::vector<std::tuple<int, int, int>>& triangles);
+}  // namespace geometry
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "geometry/geometry.h"
+
+namespace geometry
+{
+// Appends values of up to 32 bits to a byte buffer, least significant bit first
+class BitWriter
+{
+  public:
+    explicit BitWriter(std::vector<std::uint8_t>& out);
+
+    // Writes the lowest num_bits of value
+    void write(const std::uint32_t value, const int num_bits);
+    void write_bool(const bool value);
+
+    // Pads the last byte with zeros. Call once done, before reading out.
+    void flush();
+
+    std::size_t num_bits() const;
+
+  private:
+    std::vector<std::uint8_t>& out;
+    std::uint64_t scratch = 0;
+    int scratch_bits = 0;
+    std::size_t bits_written = 0;
+};
+
+// Reads back what a BitWriter wrote, throwing std::runtime_error instead of reading past the end
+class BitReader
+{
+  public:
+    BitReader(const std::uint8_t* data, const std::size_t size);
+    explicit BitReader(const std::vector<std::uint8_t>& data);
+
+    std::uint32_t read(const int num_bits);
+    bool read_bool();
+
+  private:
+    const std::uint8_t* data;
+    std::size_t size;
+    std::size_t byte = 0;
+    std::uint64_t scratch = 0;
+    int scratch_bits = 0;
+};
+
+/**
+ * @brief Compresses MotionStates for storing and sending many of them every tick.
+ *
+ * Positions are stored in fixed point relative to the origin of a sector, orientations as their
+ * three smallest quaternion components, and the other vectors per component in a range set by the
+ * ship's motion limits (see urdf::FighterModel::MotionLimits). All of it is lossy, but a state
+ * that is quantized once doesn't change again through encoding and decoding, so both ends of a
+ * connection can delta encode against the same quantized baseline. A field that hasn't changed
+ * since the baseline costs a bit, and one that changed a little a few more than half its size.
+ *
+ * Values out of range are clamped: positions outside the sector, and vectors longer than their
+ * limits. A clamped position no longer follows from the velocity, so states that may leave the
+ * sector should be kept in it with keep_in_sector() before they are quantized.
+ */
+class MotionStateCodec
+{
+  public:
+    // The largest magnitude of each vector
+    struct Limits
+    {
+        float velocity;
+        float acceleration;
+        float angular_velocity;
+        float angular_acceleration;
+    };
+
+    struct Precision
+    {
+        float position_resolution = 1.0f / 128.0f;  // In metres
+        int orientation_bits = 12;  // Per stored component
+        int velocity_bits = 14;     // Per component, and so on
+        int acceleration_bits = 10;
+        int angular_velocity_bits = 12;
+        int angular_acceleration_bits = 10;
+    };
+
+    // A MotionState as integers, in the ranges and resolutions of a codec
+    struct Quantized
+    {
+        std::array<std::int32_t, 3> position;
+
+        // The index of the largest component, then the three others
+        std::uint32_t orientation_index;
+        std::array<std::int32_t, 3> orientation;
+
+        std::array<std::int32_t, 3> velocity;
+        std::array<std::int32_t, 3> acceleration;
+        std::array<std::int32_t, 3> angular_velocity;
+        std::array<std::int32_t, 3> angular_acceleration;
+
+        bool operator==(const Quantized& other) const;
+        bool operator!=(const Quantized& other) const;
+    };
+
+    /**
+     * @param sector_origin the centre of the cube positions are stored relative to
+     * @param sector_extent half the side of that cube
+     */
+    MotionStateCodec(const Eigen::Vector3f& sector_origin,
+                     const float sector_extent,
+                     const Limits& limits,
+                     const Precision& precision);
+    MotionStateCodec(const Eigen::Vector3f& sector_origin,
+                     const float sector_extent,
+                     const Limits& limits);
+
+    /**
+     * @brief Stops a state at the faces of the sector, as a wall would: a position outside it is
+     * moved back onto the nearest face, and velocity and acceleration towards that face are zeroed.
+     *
+     * @return whether the state was outside
+     */
+    bool keep_in_sector(MotionState& state) const;
+
+    Quantized quantize(const MotionState& state) const;
+    MotionState dequantize(const Quantized& state) const;
+
+    // Appends a state to the writer, delta encoded against baseline unless it is null. It has to
+    // be decoded with the same baseline.
+    void encode(const Quantized& state, const Quantized* baseline, BitWriter& writer) const;
+    Quantized decode(const Quantized* baseline, BitReader& reader) const;
+
+    // The most bits a state can take without a baseline
+    int max_bits() const;
+
+    // The most bits a state can take delta encoded against one, more than without: fields that
+    // changed too much are written in full, after the flags that say so
+    int max_delta_bits() const;
+
+    // Worst case round trip errors of values in range: per position and vector component, and the
+    // rotation angle between orientations in radians
+    float max_position_error() const;
+    float max_orientation_error() const;
+    float max_velocity_error() const;
+    float max_acceleration_error() const;
+    float max_angular_velocity_error() const;
+    float max_angular_acceleration_error() const;
+
+  private:
+    // How to store each component of a vector: as an integer in [-max, max] taking num_bits, or
+    // as a difference from the baseline in [-max_delta, max_delta] taking delta_bits
+    struct Field
+    {
+        float scale;  // Integer units per unit of the value
+        int num_bits;
+        std::int32_t max;
+        int delta_bits;
+        std::int32_t max_delta;
+
+        static Field from_bits(const float range, const int num_bits);
+        static Field from_resolution(const float range, const float resolution);
+
+        std::int32_t quantize(const float value) const;
+        float dequantize(const std::int32_t value) const;
+
+        void encode(const std::array<std::int32_t, 3>& value,
+                    const std::array<std::int32_t, 3>* baseline,
+                    BitWriter& writer) const;
+        std::array<std::int32_t, 3> decode(const std::array<std::int32_t, 3>* baseline,
+                                           BitReader& reader) const;
+    };
+
+    Eigen::Vector3f sector_origin;
+    Field position;
+    Field orientation;
+    Field velocity;
+    Field acceleration;
+    Field angular_velocity;
+    Field angular_acceleration;
+};
+}  // namespace geometry
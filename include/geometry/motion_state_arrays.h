@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "geometry/geometry.h"
+
+namespace geometry
+{
+/**
+ * @brief Structure-of-arrays storage for many MotionStates, one float array per component, so
+ * that integration can run on 8 entities per instruction.
+ *
+ * MotionState stays the component everybody reads and writes. States are copied in with load()
+ * and back out with store() around the batched integrate().
+ */
+class MotionStateArrays
+{
+  public:
+    void resize(const std::size_t size);
+    std::size_t size() const;
+
+    void load(const std::size_t i, const MotionState& state);
+    void store(const std::size_t i, MotionState& state) const;
+
+    // Same update as MotionState::integrate, applied to entries [begin, end)
+    void integrate(const float dt, const std::size_t begin, const std::size_t end);
+    void integrate(const float dt);
+
+    std::vector<float> px, py, pz;
+    std::vector<float> qw, qx, qy, qz;
+    std::vector<float> vx, vy, vz;
+    std::vector<float> ax, ay, az;
+    std::vector<float> wx, wy, wz;
+    std::vector<float> alpha_x, alpha_y, alpha_z;
+};
+
+// Integrates a single MotionState with the exact arithmetic of the batched kernel
+void integrate_motion_state(MotionState& state, const float dt);
+}  // namespace geometry
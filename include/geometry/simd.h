@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+// Helpers for kernels written once against GCC vector extensions. Only meant to be included by
+// the translation units implementing such kernels.
+
+// Every function marked with this is compiled twice, for AVX2 and for the baseline (SSE2 on
+// x86-64), and the right one is picked at load time
+#if defined(__GNUC__) && defined(__x86_64__)
+#define AWING_TARGET_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define AWING_TARGET_CLONES
+#endif
+
+// The helpers below are always inlined into the clones, so no vector ever crosses a call
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+namespace geometry::simd
+{
+typedef float float8 __attribute__((vector_size(32)));
+typedef int int8 __attribute__((vector_size(32)));
+constexpr std::size_t lanes = sizeof(float8) / sizeof(float);
+
+template <typename T>
+__attribute__((always_inline)) inline T load(const float* p)
+{
+    T out;
+    std::memcpy(&out, p, sizeof(T));
+    return out;
+}
+
+template <typename T>
+__attribute__((always_inline)) inline void store(float* p, const T& v)
+{
+    std::memcpy(p, &v, sizeof(T));
+}
+}  // namespace geometry::simd
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <typeindex>
+#include <vector>
+
+#include "jobs/thread_pool.h"
+
+namespace jobs
+{
+/**
+ * @brief Runs a fixed list of tasks, each declaring the data it reads and writes, as if one after
+ * the other in the order they were added, but with tasks that don't conflict at the same time.
+ *
+ * Two tasks conflict if either writes something the other reads or writes, and the later one then
+ * depends on the earlier one. Data is identified by type, e.g. a component type. Tasks are packed
+ * into waves that run one after the other, each wave's tasks across the pool, and every task in a
+ * wave after those it depends on. Exclusive tasks, typically ones that split their own work across
+ * the pool, get a wave to themselves.
+ */
+class TaskGraph
+{
+  public:
+    using Access = std::vector<std::type_index>;
+
+    // Returns the index the task is run by
+    std::size_t add(const Access& reads, const Access& writes, const bool exclusive = false);
+
+    std::size_t size() const;
+
+    // Indices of the tasks each task depends on
+    const std::vector<std::size_t>& get_dependencies(const std::size_t task) const;
+
+    // Indices of the tasks that run at the same time, wave by wave
+    const std::vector<std::vector<std::size_t>>& get_waves() const;
+
+    // Calls run_task(i) for every task i, wave by wave. Waves of a single task run on the calling
+    // thread, so that the task can use the whole pool itself.
+    template <typename Fn>
+    void run(ThreadPool& thread_pool, Fn&& run_task) const
+    {
+        for (const auto& wave : waves)
+        {
+            if (wave.size() == 1)
+            {
+                run_task(wave.front());
+                continue;
+            }
+
+            thread_pool.parallel_for(
+                wave.size(), 1, [&wave, &run_task](const std::size_t begin, const std::size_t end) {
+                    for (auto i = begin; i < end; ++i)
+                    {
+                        run_task(wave[i]);
+                    }
+                });
+        }
+    }
+
+  private:
+    struct Task
+    {
+        Access reads;
+        Access writes;
+        std::vector<std::size_t> dependencies;
+        std::size_t wave;
+    };
+
+    std::vector<Task> tasks;
+    std::vector<std::vector<std::size_t>> waves;
+    std::vector<bool> exclusive_waves;
+};
+}  // namespace jobs
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace jobs
+{
+/**
+ * @brief Fixed set of worker threads that split index ranges into chunks. Idle threads keep
+ * claiming the next unclaimed chunk until none are left, so uneven chunks balance out.
+ *
+ * The calling thread takes part in the work and parallel_for only returns once every chunk has
+ * run. Chunk boundaries depend only on the count and grain size, never on timing.
+ */
+class ThreadPool
+{
+  public:
+    // num_threads includes the calling thread. 0 means one per hardware thread.
+    explicit ThreadPool(std::size_t num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t num_threads() const;
+
+    // Calls fn(begin, end) for consecutive chunks of at most grain_size indices covering
+    // [0, count). Called from inside a chunk, runs all of the chunks on the calling thread.
+    template <typename Fn>
+    void parallel_for(const std::size_t count, const std::size_t grain_size, Fn&& fn)
+    {
+        using FnType = std::remove_reference_t<Fn>;
+        run(count,
+            grain_size,
+            [](void* ctx, std::size_t begin, std::size_t end) {
+                (*static_cast<FnType*>(ctx))(begin, end);
+            },
+            const_cast<void*>(static_cast<const void*>(&fn)));
+    }
+
+  private:
+    using ChunkFn = void (*)(void*, std::size_t, std::size_t);
+
+    void run(const std::size_t count, const std::size_t grain_size, ChunkFn fn, void* ctx);
+    void work_loop();
+    void execute_chunks();
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+    bool stopping = false;
+    std::size_t generation = 0;
+    std::size_t active_workers = 0;
+
+    // Current job. Only written while no worker is active.
+    ChunkFn job_fn = nullptr;
+    void* job_ctx = nullptr;
+    std::size_t job_count = 0;
+    std::size_t job_grain_size = 1;
+    std::size_t job_num_chunks = 0;
+    std::atomic<std::size_t> next_chunk = 0;
+    std::atomic<std::size_t> completed_chunks = 0;
+};
+}  // namespace jobs
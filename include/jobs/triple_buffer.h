@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace jobs
+{
+/**
+ * @brief Hands the latest of a stream of values from one writer thread to one reader thread
+ * without either of them ever waiting on the other.
+ *
+ * The writer fills write_buffer() and publish()es it, the reader picks up the most recently
+ * published one with read(). Of the three buffers, one is owned by the writer, one by the reader,
+ * and the third holds the latest published value until one of them swaps it for its own. Values
+ * published while the reader isn't looking are overwritten, never queued. Buffers are reused, so
+ * the writer should overwrite all of write_buffer() before publishing it.
+ */
+template <typename T>
+class TripleBuffer
+{
+  public:
+    TripleBuffer() = default;
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Writer thread only
+    T& write_buffer()
+    {
+        return buffers[back];
+    }
+
+    // Writer thread only. Makes write_buffer() the latest value, and hands the writer another.
+    void publish()
+    {
+        back = middle.exchange(back | fresh_bit, std::memory_order_acq_rel) & index_mask;
+    }
+
+    // Reader thread only. The latest published value, or the one read last time if none has been
+    // published since (value-initialized until the first publish()). Stays valid and unchanged
+    // until the next read().
+    const T& read()
+    {
+        if (middle.load(std::memory_order_relaxed) & fresh_bit)
+        {
+            front = middle.exchange(front, std::memory_order_acq_rel) & index_mask;
+        }
+        return buffers[front];
+    }
+
+  private:
+    static constexpr std::uint8_t index_mask = 0x3;
+    static constexpr std::uint8_t fresh_bit = 0x4;  // Set in middle until the reader takes it
+
+    std::array<T, 3> buffers = {};
+
+    // On separate cache lines, so the two threads only share middle
+    alignas(64) std::uint8_t back = 0;
+    alignas(64) std::atomic<std::uint8_t> middle{ 1 };
+    alignas(64) std::uint8_t front = 2;
+};
+}  // namespace jobs
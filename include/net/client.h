@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <vector>
+
+#include "geometry/motion_codec.h"
+#include "net/protocol.h"
+#include "net/udp_socket.h"
+#include "urdf/fighter_input.h"
+
+namespace net
+{
+/**
+ * @brief Connects to a GameServer, sends it the actions of the client's fighter every tick and
+ * decodes the snapshots it sends back.
+ *
+ * Holds on to the snapshots of the last second or so, any of which the server may have encoded
+ * the latest against, and keeps resending the inputs the server hasn't applied yet. Snapshots that
+ * came in several parts are put together, and dropped if a newer one is complete first.
+ */
+class GameClient
+{
+  public:
+    explicit GameClient(const Address& server);
+
+    // Says hello unless already welcomed. Either packet may be lost, so call it every tick until
+    // connected().
+    void connect();
+    bool connected() const;
+
+    // Handles the packets received since the last call, and returns whether a newer snapshot was
+    // among them
+    bool poll();
+
+    // Sends the actions for the client's next tick, and returns its sequence
+    std::uint32_t send_input(const urdf::FighterInput::Actions& actions);
+
+    // Only valid once connected
+    const Welcome& get_welcome() const;
+    const geometry::MotionStateCodec& get_codec() const;
+
+    // Null until the first snapshot arrives
+    const Snapshot* get_latest_snapshot() const;
+
+    std::uint64_t get_bytes_sent() const;
+    std::uint64_t get_bytes_received() const;
+
+  private:
+    static constexpr std::size_t history_size = 64;
+
+    // A snapshot with parts yet to arrive
+    struct Assembly
+    {
+        Snapshot snapshot;
+        std::vector<bool> received;
+        std::size_t num_received = 0;
+    };
+
+    // Of the few ticks before a snapshot is given up on
+    static constexpr std::size_t max_assemblies = 4;
+
+    void handle_snapshot_part();
+    void complete(Snapshot snapshot);
+
+    UdpSocket socket;
+    const Address server;
+
+    std::optional<Welcome> welcome;
+    std::optional<geometry::MotionStateCodec> codec;
+
+    // The snapshots received lately, by tick modulo the size
+    std::array<Snapshot, history_size> received;
+    std::uint32_t latest_tick = no_tick;
+    std::vector<Assembly> assemblies;  // Oldest first
+
+    // The actions of the inputs the server hasn't applied yet, up to the last one sent
+    std::uint32_t next_sequence = 0;
+    std::deque<std::uint16_t> unapplied_inputs;
+
+    std::uint64_t bytes_sent = 0;
+    std::uint64_t bytes_received = 0;
+
+    std::vector<char> incoming;
+    std::vector<char> outgoing;
+};
+}  // namespace net
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include <entt/entt.hpp>
+
+#include "control/ship_controller.h"
+#include "geometry/geometry.h"
+#include "geometry/motion_codec.h"
+#include "net/protocol.h"
+#include "urdf/fighter_input.h"
+#include "urdf/fighter_model.h"
+
+namespace net
+{
+/**
+ * @brief Predicts a client's own fighter ahead of the snapshots a GameServer sends, so that it
+ * responds to the client's inputs at once rather than a round trip later.
+ *
+ * Runs the server's tick for that one fighter on every input the client sends: integration, then
+ * the ship controller, then keeping it in the sector and quantizing, like the server does. The
+ * inputs and the states they led to are kept until a snapshot says the server has applied them. If
+ * the server's state after an input is not the one predicted for it, e.g. because the fighter was
+ * hit, an input was lost or arrived late, the prediction rolls back to the server's state and
+ * re-simulates the inputs it hasn't applied yet.
+ *
+ * Only motion is predicted. Collisions, lasers and death are left to the server's corrections.
+ */
+class FighterPrediction
+{
+  public:
+    FighterPrediction(const urdf::FighterModel& model,
+                      const geometry::MotionStateCodec& codec,
+                      const float dt);
+
+    // Runs the client's next tick with the actions it sent as input sequence. Before the first
+    // server state arrives there is nothing to predict from, and the input is only kept.
+    void predict(const std::uint32_t sequence, const urdf::FighterInput::Actions& actions);
+
+    /**
+     * @brief Checks the prediction against the entity's state in a snapshot, which must be newer
+     * than the last one reconciled, and corrects it if need be.
+     *
+     * @return the number of ticks re-simulated, 0 if the prediction was right or the entity
+     * isn't in the snapshot
+     */
+    std::size_t reconcile(const Snapshot& snapshot, const entt::entity entity);
+
+    // Null until the first snapshot with the fighter is reconciled
+    const geometry::MotionState* get_state() const;
+
+    // Inputs predicted but not yet applied by the server
+    std::size_t get_num_pending() const;
+
+    std::uint64_t get_num_corrections() const;
+
+  private:
+    // More than a second of inputs at 60 Hz. Older ones are dropped when it fills up.
+    static constexpr std::size_t capacity = 128;
+
+    struct Entry
+    {
+        std::uint32_t sequence;
+        std::uint16_t actions;
+        geometry::MotionStateCodec::Quantized state;  // After the tick, if predicted
+    };
+
+    // One server tick of the fighter, from and to a quantized state
+    geometry::MotionStateCodec::Quantized step(const geometry::MotionState& from,
+                                               const std::uint16_t actions);
+
+    Entry& at(const std::size_t i);
+
+    const urdf::FighterModel model;
+    const geometry::MotionStateCodec codec;
+    const float dt;
+    control::ShipController ship_controller;
+    urdf::FighterInput input;
+
+    // A ring of the pending inputs, oldest first
+    std::array<Entry, capacity> entries;
+    std::size_t first = 0;
+    std::size_t num_entries = 0;
+
+    std::optional<geometry::MotionState> state;
+    std::uint64_t num_corrections = 0;
+};
+}  // namespace net
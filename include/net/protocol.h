@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "geometry/motion_codec.h"
+
+namespace net
+{
+/**
+ * @brief The datagrams exchanged by GameServer and GameClient.
+ *
+ * Every datagram starts with a PacketType byte. Fields are written as they are laid out in memory
+ * (see ecs::BinaryWriter), so both ends have to share a byte order. A client says Hello until it
+ * is Welcomed, then sends its Input every tick, along with the last Snapshot it received, which
+ * the server delta encodes the following ones against.
+ *
+ * Inputs are numbered per client, and each Input packet repeats those the server hasn't applied
+ * yet, so that a lost packet costs nothing as long as one of the next few arrives.
+ *
+ * Snapshots are split into parts that each fit in a datagram small enough not to be fragmented,
+ * and that each decode on their own. A snapshot is only complete, and only acknowledged, once all
+ * of its parts arrived.
+ */
+constexpr std::uint32_t protocol_magic = 0x314e5741;  // "AWN1"
+constexpr std::size_t max_packet_size = 65507;
+constexpr std::uint32_t no_tick = ~0u;
+constexpr std::size_t max_inputs_per_packet = 32;
+constexpr std::size_t max_snapshot_packet_size = 1200;  // Within the MTU of about any path
+
+enum class PacketType : std::uint8_t
+{
+    HELLO,
+    WELCOME,
+    INPUT,
+    SNAPSHOT
+};
+
+struct Welcome
+{
+    std::uint32_t client_id;
+    entt::entity entity;  // The client's fighter
+    float dt;
+
+    // What the server's MotionStateCodec was made from
+    float sector_extent;
+    geometry::MotionStateCodec::Limits limits;
+};
+
+struct Input
+{
+    std::uint32_t client_id;
+    std::uint32_t acked_tick;  // Of the last snapshot received, or no_tick
+
+    // urdf::FighterInput::Actions of consecutive client ticks, the last one numbered sequence.
+    // Sequences count up from 0.
+    std::uint32_t sequence;
+    std::vector<std::uint16_t> actions;
+};
+
+// The motion states of every fighter at the end of a server tick
+struct Snapshot
+{
+    std::uint32_t tick;
+    std::uint32_t last_input;  // The sequence of the last input applied from the client, or no_tick
+    std::vector<std::pair<entt::entity, geometry::MotionStateCodec::Quantized>> states;  // By id
+};
+
+// One datagram of a snapshot
+struct SnapshotPart
+{
+    Snapshot snapshot;  // With a run of the snapshot's states
+    std::uint16_t index;
+    std::uint16_t num_parts;
+};
+
+std::optional<PacketType> read_packet_type(const std::vector<char>& packet);
+
+void write_hello(std::vector<char>& out);
+bool read_hello(const std::vector<char>& packet);
+
+void write_welcome(const Welcome& welcome, std::vector<char>& out);
+Welcome read_welcome(const std::vector<char>& packet);
+
+void write_input(const Input& input, std::vector<char>& out);
+Input read_input(const std::vector<char>& packet);
+
+// Delta encoded against baseline, unless it is null, into as many packets as it takes
+void write_snapshot(const Snapshot& snapshot,
+                    const Snapshot* baseline,
+                    const geometry::MotionStateCodec& codec,
+                    std::vector<std::vector<char>>& packets);
+
+// Null if the part was encoded against a baseline that find_baseline doesn't have any more
+std::optional<SnapshotPart>
+read_snapshot_part(const std::vector<char>& packet,
+                   const std::function<const Snapshot*(std::uint32_t tick)>& find_baseline,
+                   const geometry::MotionStateCodec& codec);
+}  // namespace net
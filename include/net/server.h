@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "ecs/scene.h"
+#include "geometry/motion_codec.h"
+#include "net/protocol.h"
+#include "net/udp_socket.h"
+
+namespace net
+{
+/**
+ * @brief Runs the authoritative simulation of a headless scene for clients connected over UDP.
+ *
+ * Every client that says hello gets a fighter of its own, steered by the actions it sends, and
+ * after every tick a snapshot of all fighters' motion states, delta encoded against the last one
+ * it acknowledged. Inputs are applied one per tick in sequence order, so that a client can predict
+ * its fighter by running the same ticks on the same inputs (see GameClient).
+ *
+ * The fighters' states are quantized after every tick and the server carries on from what it sent,
+ * which is therefore exactly what clients simulate from. Only fighter motion is replicated; lasers,
+ * health and the rest of the scene are not.
+ *
+ * The sector the codec stores positions in is the play area: fighters that reach one of its faces
+ * are stopped there (see geometry::MotionStateCodec::keep_in_sector()), on the server and in the
+ * clients' predictions alike.
+ */
+class GameServer
+{
+  public:
+    struct Options
+    {
+        std::string ship_urdf = "awing.urdf";  // What clients fly
+        float sector_extent = 8192.0f;  // Half the side of the cube around the origin fighters
+                                        // are kept in, see geometry::MotionStateCodec
+        float client_timeout = 5.0f;    // Seconds without a packet before a client is dropped
+        std::size_t max_queued_inputs = 8;  // Older ones are skipped to catch up
+        std::size_t max_clients = 64;       // Hellos from further addresses are ignored
+    };
+
+    // Bytes counted as UDP payloads
+    struct ClientStats
+    {
+        std::uint32_t client_id;
+        Address address;
+        entt::entity entity;
+        std::uint64_t bytes_sent;
+        std::uint64_t bytes_received;
+        std::uint64_t full_snapshots_sent;  // Those without a baseline
+    };
+
+    GameServer(std::shared_ptr<ecs::Scene> scene,
+               const std::uint16_t port,
+               const float dt,
+               const Options& options);
+    GameServer(std::shared_ptr<ecs::Scene> scene, const std::uint16_t port, const float dt);
+
+    // Handles the packets received since the last call, runs a tick and sends every client a
+    // snapshot of its end
+    void update();
+
+    std::uint16_t get_port() const;
+    std::uint32_t get_tick() const;
+    float get_time() const;
+    const ecs::Scene& get_scene() const;
+    const geometry::MotionStateCodec& get_codec() const;
+    std::vector<ClientStats> get_client_stats() const;
+
+  private:
+    // Enough to cover a round trip of a second at 60 Hz
+    static constexpr std::size_t history_size = 64;
+
+    struct Client
+    {
+        std::uint32_t id;
+        Address address;
+        entt::entity entity;
+
+        std::deque<std::uint16_t> queued_inputs;
+        std::uint32_t next_input = 0;           // The sequence of the first of queued_inputs
+        std::uint32_t last_applied = no_tick;  // The sequence of the last input applied
+        std::uint16_t actions = 0;             // Held until the next input arrives
+
+        std::uint32_t acked_tick = no_tick;
+        std::uint32_t last_heard_tick = 0;
+
+        std::uint64_t bytes_sent = 0;
+        std::uint64_t bytes_received = 0;
+        std::uint64_t full_snapshots_sent = 0;
+    };
+
+    void receive();
+    void handle_hello(const Address& from);
+    void handle_input(const Address& from, const Input& input, const std::size_t size);
+    void apply_inputs();
+    void capture_snapshot();
+    void send_snapshots();
+    void drop_timed_out_clients();
+
+    Client* find_client(const std::uint32_t id, const Address& address);
+
+    std::shared_ptr<ecs::Scene> scene;
+    UdpSocket socket;
+    const float dt;
+    const Options options;
+    const geometry::MotionStateCodec::Limits limits;
+    const geometry::MotionStateCodec codec;
+
+    std::uint32_t tick = 0;
+    float t = 0.0f;
+
+    std::uint32_t next_client_id = 0;
+    std::vector<Client> clients;
+
+    // The snapshots of the last ticks, by tick modulo the size
+    std::array<Snapshot, history_size> history;
+
+    std::vector<char> incoming;
+    std::vector<char> outgoing;
+    std::vector<std::vector<char>> snapshot_packets;
+};
+}  // namespace net
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace net
+{
+// An IPv4 address and port, both in host byte order
+struct Address
+{
+    std::uint32_t host = 0;
+    std::uint16_t port = 0;
+
+    static Address loopback(const std::uint16_t port);
+
+    bool operator==(const Address& other) const;
+    bool operator!=(const Address& other) const;
+    std::string to_string() const;
+};
+
+/**
+ * @brief A non-blocking IPv4 UDP socket.
+ *
+ * @throws std::runtime_error from the constructor and send() if the OS call fails
+ */
+class UdpSocket
+{
+  public:
+    // Binds to the port on all interfaces, or to one the OS picks if it is 0
+    explicit UdpSocket(const std::uint16_t port = 0);
+    ~UdpSocket();
+
+    UdpSocket(UdpSocket&& other) noexcept;
+    UdpSocket& operator=(UdpSocket&& other) noexcept;
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    void send(const Address& to, const void* data, const std::size_t size);
+
+    // The size of the next pending datagram, copied into buffer and cut to its capacity, if any
+    std::optional<std::size_t> receive(Address& from, void* buffer, const std::size_t capacity);
+
+    Address get_local_address() const;
+
+  private:
+    int fd = -1;
+};
+}  // namespace net
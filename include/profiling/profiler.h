@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "profiling/trace.h"
+
+namespace profiling
+{
+/**
+ * @brief Keeps a rolling history of the last few hundred durations of every named section.
+ *
+ * Sections are identified by string literals and created on first use. Fed by ScopedTimer (see
+ * AWING_PROFILE_SCOPE) from any thread, taking a lock per sample, so it is meant for whole systems
+ * and frames rather than per-chunk work.
+ */
+class Profiler
+{
+  public:
+    static constexpr std::size_t history_size = 240;
+
+    struct Section
+    {
+        const char* name;
+        std::array<float, history_size> samples_ms = {};
+        std::size_t num_samples = 0;
+        std::size_t next = 0;
+
+        float last_ms() const;
+        float mean_ms() const;
+        float max_ms() const;
+
+        // Samples in the order they were recorded, oldest first
+        std::vector<float> history() const;
+    };
+
+    static Profiler& get();
+
+    void record(const char* name, const float ms);
+
+    // Copies, as sections keep being recorded into from other threads
+    std::vector<Section> get_sections() const;
+    std::optional<Section> find(const char* name) const;
+
+  private:
+    Profiler() = default;
+
+    mutable std::mutex mutex;
+    std::vector<Section> sections;
+};
+
+// Records its lifetime in the Profiler and, if tracing is enabled, as a TraceRecorder event with
+// an optional detail string (e.g. the uri of a resource being loaded)
+class ScopedTimer
+{
+  public:
+    explicit ScopedTimer(const char* name, const char* detail = nullptr);
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+  private:
+    const char* name;
+    const char* detail;
+    std::chrono::steady_clock::time_point start;
+};
+}  // namespace profiling
+
+// Times the rest of the enclosing scope under the given name (a string literal). The _DETAIL
+// variant attaches a string to the trace event, and AWING_TRACE_SCOPE only records a trace event,
+// which unlike the others takes no lock, so is fine in per-chunk work. All compile to nothing
+// unless AWING_PROFILING is defined (see BUILD_AWINGALLIANCE_PROFILING in CMakeLists.txt).
+#ifdef AWING_PROFILING
+#define AWING_PROFILE_CONCAT_IMPL(a, b) a##b
+#define AWING_PROFILE_CONCAT(a, b) AWING_PROFILE_CONCAT_IMPL(a, b)
+#define AWING_PROFILE_SCOPE(name) \
+    const ::profiling::ScopedTimer AWING_PROFILE_CONCAT(awing_profile_scope_, __LINE__)(name)
+#define AWING_PROFILE_SCOPE_DETAIL(name, detail)                                         \
+    const ::profiling::ScopedTimer AWING_PROFILE_CONCAT(awing_profile_scope_, __LINE__)( \
+        name, detail)
+#define AWING_TRACE_SCOPE(name) \
+    const ::profiling::ScopedTraceEvent AWING_PROFILE_CONCAT(awing_trace_scope_, __LINE__)(name)
+#else
+#define AWING_PROFILE_SCOPE(name) static_cast<void>(0)
+#define AWING_PROFILE_SCOPE_DETAIL(name, detail) static_cast<void>(0)
+#define AWING_TRACE_SCOPE(name) static_cast<void>(0)
+#endif
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace profiling
+{
+/**
+ * @brief Records timed events from any thread and writes them as a chrome://tracing (and
+ * Perfetto) compatible JSON trace.
+ *
+ * Every thread records into its own fixed-size ring buffer, so recording takes no lock and never
+ * allocates, and only the most recent events_per_thread events of each thread are kept. Nothing is
+ * recorded until enable() has been called.
+ */
+class TraceRecorder
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t events_per_thread = 1 << 14;
+    static constexpr std::size_t max_detail_length = 47;
+
+    static TraceRecorder& get();
+
+    // Starts recording. Events are written to filename by write().
+    void enable(const std::string& filename);
+    bool enabled() const
+    {
+        return is_enabled.load(std::memory_order_relaxed);
+    }
+
+    // name must outlive the recorder (a string literal). detail (may be null) is copied, truncated
+    // to max_detail_length characters.
+    void record(const char* name,
+                const char* detail,
+                const Clock::time_point start,
+                const Clock::time_point end);
+
+    // Names the calling thread in the trace
+    void set_thread_name(const std::string& name);
+
+    // Writes the events held by every thread's buffer. Should be called while no other thread is
+    // recording, e.g. at shutdown. Returns false if tracing is disabled or the file can't be
+    // opened.
+    bool write() const;
+
+  private:
+    TraceRecorder();
+
+    struct Event
+    {
+        const char* name;
+        std::array<char, max_detail_length + 1> detail;
+        std::int64_t start_ns;
+        std::int64_t duration_ns;
+    };
+
+    struct ThreadBuffer
+    {
+        int tid;
+        std::string name;
+        std::array<Event, events_per_thread> events;
+        std::atomic<std::uint64_t> num_recorded{ 0 };
+    };
+
+    ThreadBuffer& thread_buffer();
+
+    std::atomic<bool> is_enabled{ false };
+    std::string filename;
+    const Clock::time_point epoch;
+
+    // Guards registering buffers and naming threads, never taken while recording
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+/**
+ * @brief Enables tracing if requested with "--trace <file>" (or "--trace=<file>") on the command
+ * line, or with the AWING_TRACE environment variable, and names the calling thread "main".
+ *
+ * @return whether tracing was enabled
+ */
+bool init_tracing(int argc, char* argv[]);
+
+// Records a trace event covering its lifetime. Unlike ScopedTimer, can be used from any thread.
+class ScopedTraceEvent
+{
+  public:
+    explicit ScopedTraceEvent(const char* name);
+    ~ScopedTraceEvent();
+
+    ScopedTraceEvent(const ScopedTraceEvent&) = delete;
+    ScopedTraceEvent& operator=(const ScopedTraceEvent&) = delete;
+
+  private:
+    const char* name;
+    TraceRecorder::Clock::time_point start;
+};
+}  // namespace profiling
@@ -1,10 +1,10 @@
 #pragma once
 
 #include <optional>
-#include <set>
 #include <map>
 #include <vector>
 #include <array>
+#include <tuple>
 
 namespace resources
 {
@@ -25,14 +25,14 @@ struct GeometryData
     std::string name;
     Type type;
 
-    // BOUNDINGBOX
+    // Leaf extents
     std::optional<std::array<float, 3>> min;
     std::optional<std::array<float, 3>> max;
 
-    // CONVEXHULL
+    // Leaf hull, of either type
     std::vector<float> vertices;
+    // Triangles, from which CollisionShape cooks the face normals and edges it needs
     std::vector<std::tuple<int, int, int>> face_indices;
-    std::set<std::tuple<int, int>> edge_indices;
 
     std::map<std::string, GeometryData> children;
 };
@@ -25,6 +25,8 @@ class FighterInput
         count
     };
 
+    using Actions = std::bitset<static_cast<int>(Action::count)>;
+
     bool test(const Action action) const;
     void set(const Action action, const bool value);
     void handle_key_event(const KeyEvent& key_event);
@@ -42,8 +44,11 @@ class FighterInput
 
     Actuation current_actuation() const;
 
+    // All actions at once, e.g. for saving and restoring them
+    const Actions& get_actions() const;
+    void set_actions(const Actions& value);
+
   private:
-    static constexpr int num_actions = static_cast<int>(Action::count);
-    std::bitset<num_actions> actions;
+    Actions actions;
 };
 }  // namespace urdf
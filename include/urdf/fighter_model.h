@@ -8,9 +8,13 @@ namespace urdf
 {
 struct FighterModel
 {
+    std::string uri;  // The URDF it was parsed from, set by whoever loads it
     std::string visual_name;
     Eigen::Vector3f dimensions;
 
+    // Side the fighter is on, unless the scenario puts it on another. At most 31.
+    int team = 0;
+
     std::vector<Eigen::Isometry3f> laser_spawn_poses;
     std::vector<Eigen::Isometry3f> camera_poses;
     std::vector<Eigen::Isometry3f> exhaust_poses;
@@ -19,6 +23,7 @@ struct FighterModel
     {
         float damage;
         float speed;
+        float range = 2000.0f;  // Lasers that have not hit anything are removed after this far
         Eigen::Vector3f color;
         Eigen::Vector3f size;
 
@@ -28,6 +33,11 @@ struct FighterModel
             float duration;
         };
         ImpactInfo impact_info;
+
+        float lifetime() const
+        {
+            return range / speed;
+        }
     };
     LaserInfo laser_info;
 
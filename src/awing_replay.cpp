@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ecs/components.h"
+#include "ecs/input_journal.h"
+#include "ecs/replay.h"
+#include "ecs/scene_factory.h"
+#include "ecs/systems.h"
+#include "profiling/trace.h"
+
+namespace
+{
+// FNV-1a over the fighters' poses, for telling whether two replays of a journal ended up the same
+std::uint64_t hash_fighter_poses(const ecs::Scene& scene)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+    const auto add = [&hash](const void* data, const std::size_t size) {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    };
+
+    for (const auto [entity, fighter, motion_state] :
+         scene.registry.view<const FighterComponent, const MotionStateComponent>().each())
+    {
+        add(&entity, sizeof(entity));
+        add(motion_state.position.data(), 3 * sizeof(float));
+        add(motion_state.orientation.coeffs().data(), 4 * sizeof(float));
+    }
+    return hash;
+}
+}  // namespace
+
+// Replays a match recorded by awing --record headless (no window, GL context or audio device), as
+// fast as possible, and reports the achieved speedup over real time along with a hash of where the
+// fighters ended up. Given a time, it seeks to it from the last checkpoint before it, or with
+// --from-start re-simulates the whole match up to it, which should end up with the same hash.
+int main(int argc, char* argv[])
+{
+    const bool tracing = profiling::init_tracing(argc, argv);
+
+    auto positional_args = std::vector<std::string>();
+    bool from_start = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        const auto arg = std::string(argv[i]);
+        if (arg == "--trace")
+        {
+            ++i;
+        }
+        else if (arg == "--from-start")
+        {
+            from_start = true;
+        }
+        else if (arg.rfind("--trace=", 0) != 0)
+        {
+            positional_args.push_back(arg);
+        }
+    }
+
+    if (positional_args.empty())
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " <replay> [seconds] [--from-start] [--trace <file>]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const auto replay = ecs::Replay::read(positional_args[0]);
+    const auto& journal = replay.get_journal();
+    const float dt = journal.get_dt();
+
+    auto num_ticks = journal.get_num_ticks();
+    if (positional_args.size() > 1)
+    {
+        const auto ticks = static_cast<std::uint32_t>(std::stof(positional_args[1]) / dt);
+        num_ticks = std::min(num_ticks, ticks);
+    }
+    else
+    {
+        from_start = true;
+    }
+
+    auto scene = ecs::SceneFactory::create_from_scenario(journal.get_scenario_name(), true);
+    auto playback = ecs::InputJournal::Playback(journal);
+    float t = 0.0f;
+
+    const auto start = std::chrono::steady_clock::now();
+    if (from_start)
+    {
+        for (std::uint32_t tick = 0; tick < num_ticks; ++tick)
+        {
+            playback.apply(*scene, tick);
+            ecs::systems::integrate(*scene, t, dt);
+            t += dt;
+        }
+    }
+    else
+    {
+        t = replay.seek(*scene, playback, num_ticks);
+    }
+    const auto elapsed =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "scenario: " << journal.get_scenario_name() << std::endl;
+    std::cout << "tracks: " << journal.get_tracks().size() << std::endl;
+    std::cout << "checkpoints: " << replay.get_checkpoint_ticks().size() << std::endl;
+    std::cout << "ticks: " << num_ticks << " of " << journal.get_num_ticks() << " (" << t
+              << " s simulated, " << (from_start ? "from the start" : "from a checkpoint")
+              << ")" << std::endl;
+    std::cout << "wall time: " << elapsed << " s" << std::endl;
+    std::cout << "speedup: " << (elapsed > 0.0 ? t / elapsed : 0.0) << "x" << std::endl;
+    std::cout << "fighter pose hash: " << std::hex << hash_fighter_poses(*scene) << std::dec
+              << std::endl;
+
+    if (tracing && profiling::TraceRecorder::get().write())
+    {
+        std::cout << "wrote trace" << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
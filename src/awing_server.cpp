@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ecs/scene_factory.h"
+#include "net/server.h"
+#include "profiling/trace.h"
+
+// Hosts a scenario headless (no window, GL context or audio device) for clients connecting over
+// UDP, ticking in real time, and every few seconds reports the tick time and the bandwidth each
+// client takes.
+int main(int argc, char* argv[])
+{
+    const bool tracing = profiling::init_tracing(argc, argv);
+
+    auto positional_args = std::vector<std::string>();
+    for (int i = 1; i < argc; ++i)
+    {
+        const auto arg = std::string(argv[i]);
+        if (arg == "--trace")
+        {
+            ++i;
+        }
+        else if (arg.rfind("--trace=", 0) != 0)
+        {
+            positional_args.push_back(arg);
+        }
+    }
+
+    if (positional_args.empty())
+    {
+        std::cerr << "Usage: " << argv[0] << " <scenario> [port] [seconds] [--trace <file>]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::string scenario_name = positional_args[0];
+    const auto port =
+        static_cast<std::uint16_t>(positional_args.size() > 1 ? std::stoi(positional_args[1]) : 0);
+    const double duration = positional_args.size() > 2 ? std::stod(positional_args[2]) : 0.0;
+
+    const float dt = 1.0f / 60.0f;
+    auto server = net::GameServer(ecs::SceneFactory::create_from_scenario(scenario_name, true),
+                                  port,
+                                  dt);
+    std::cout << "serving " << scenario_name << " on port " << server.get_port() << std::endl;
+
+    using Clock = std::chrono::steady_clock;
+    const auto tick_duration =
+        std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(dt));
+    const auto report_interval_ticks = static_cast<std::uint32_t>(5.0f / dt);
+
+    const auto start = Clock::now();
+    auto next_tick = start;
+    double report_tick_ms = 0.0;
+    double report_max_tick_ms = 0.0;
+    std::uint64_t report_bytes_sent = 0;
+    while (duration <= 0.0 || server.get_time() < duration)
+    {
+        std::this_thread::sleep_until(next_tick);
+        next_tick += tick_duration;
+
+        const auto tick_start = Clock::now();
+        server.update();
+        const auto tick_ms =
+            std::chrono::duration<double, std::milli>(Clock::now() - tick_start).count();
+        report_tick_ms += tick_ms;
+        report_max_tick_ms = std::max(report_max_tick_ms, tick_ms);
+
+        if (server.get_tick() % report_interval_ticks != 0)
+        {
+            continue;
+        }
+
+        const auto clients = server.get_client_stats();
+        std::uint64_t bytes_sent = 0;
+        for (const auto& client : clients)
+        {
+            bytes_sent += client.bytes_sent;
+        }
+
+        // Shared between the clients connected now. Those that left take their counts with them.
+        const auto interval_bytes = bytes_sent - std::min(bytes_sent, report_bytes_sent);
+        const double seconds = report_interval_ticks * dt;
+        const double kbit_per_client =
+            clients.empty() ? 0.0
+                            : 8.0 * static_cast<double>(interval_bytes) / seconds / 1000.0 /
+                                  static_cast<double>(clients.size());
+        std::cout << "t " << server.get_time() << " s, clients " << clients.size()
+                  << ", tick mean " << report_tick_ms / report_interval_ticks << " ms, max "
+                  << report_max_tick_ms << " ms, " << kbit_per_client << " kbit/s per client"
+                  << std::endl;
+
+        report_tick_ms = 0.0;
+        report_max_tick_ms = 0.0;
+        report_bytes_sent = bytes_sent;
+    }
+
+    if (tracing && profiling::TraceRecorder::get().write())
+    {
+        std::cout << "wrote trace" << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,68 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ecs/components.h"
+#include "ecs/scene_factory.h"
+#include "ecs/systems.h"
+#include "profiling/trace.h"
+
+// Runs a scenario headless (no window, GL context or audio device) for a fixed number of ticks, as
+// fast as possible, and reports the achieved tick rate.
+int main(int argc, char* argv[])
+{
+    const bool tracing = profiling::init_tracing(argc, argv);
+
+    auto positional_args = std::vector<std::string>();
+    for (int i = 1; i < argc; ++i)
+    {
+        const auto arg = std::string(argv[i]);
+        if (arg == "--trace")
+        {
+            ++i;
+        }
+        else if (arg.rfind("--trace=", 0) != 0)
+        {
+            positional_args.push_back(arg);
+        }
+    }
+
+    if (positional_args.size() < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <scenario> <num_ticks> [--trace <file>]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::string scenario_name = positional_args[0];
+    const long num_ticks = std::stol(positional_args[1]);
+
+    auto scene = ecs::SceneFactory::create_from_scenario(scenario_name, true);
+
+    const float dt = 1.0f / 60.0f;
+    float t = 0.0f;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (long tick = 0; tick < num_ticks; ++tick)
+    {
+        ecs::systems::integrate(*scene, t, dt);
+        t += dt;
+    }
+    const auto elapsed =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "scenario: " << scenario_name << std::endl;
+    std::cout << "fighters: " << scene->registry.view<FighterComponent>().size() << std::endl;
+    std::cout << "ticks: " << num_ticks << " (" << t << " s simulated)" << std::endl;
+    std::cout << "wall time: " << elapsed << " s" << std::endl;
+    std::cout << "ticks per second: " << (elapsed > 0.0 ? num_ticks / elapsed : 0.0) << std::endl;
+
+    if (tracing && profiling::TraceRecorder::get().write())
+    {
+        std::cout << "wrote trace" << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,28 @@
+#include "ecs/binary_io.h"
+
+#include <fstream>
+#include <iterator>
+
+namespace ecs
+{
+void write_binary_file(const std::string& filename, const std::vector<char>& data)
+{
+    auto file = std::ofstream(filename, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("Failed to open " + filename + " for writing");
+    }
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+std::vector<char> read_binary_file(const std::string& filename)
+{
+    auto file = std::ifstream(filename, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("Failed to open " + filename);
+    }
+    return std::vector<char>(std::istreambuf_iterator<char>(file),
+                             std::istreambuf_iterator<char>());
+}
+}  // namespace ecs
@@ -0,0 +1,74 @@
+#include "ecs/command_buffer.h"
+
+#include <algorithm>
+
+#include "ecs/scene.h"
+
+namespace ecs
+{
+CommandBuffer::~CommandBuffer()
+{
+    clear_commands();
+}
+
+void CommandBuffer::destroy(const entt::entity entity)
+{
+    to_destroy.push_back(entity);
+}
+
+void CommandBuffer::flush(Scene& scene)
+{
+    for (const auto& command : commands)
+    {
+        command.apply(command.self, scene);
+    }
+    clear_commands();
+
+    std::sort(to_destroy.begin(), to_destroy.end());
+    to_destroy.erase(std::unique(to_destroy.begin(), to_destroy.end()), to_destroy.end());
+    for (const auto entity : to_destroy)
+    {
+        if (scene.registry.valid(entity))
+        {
+            scene.registry.destroy(entity);
+        }
+    }
+    to_destroy.clear();
+}
+
+bool CommandBuffer::empty() const
+{
+    return commands.empty() && to_destroy.empty();
+}
+
+void* CommandBuffer::allocate(const std::size_t size, const std::size_t alignment)
+{
+    auto offset = (block_offset + alignment - 1) / alignment * alignment;
+    if (blocks.empty() || offset + size > block_size)
+    {
+        if (!blocks.empty())
+        {
+            ++current_block;
+        }
+        if (current_block == blocks.size())
+        {
+            blocks.push_back(std::make_unique<Block>());
+        }
+        offset = 0;
+    }
+
+    block_offset = offset + size;
+    return blocks[current_block]->data + offset;
+}
+
+void CommandBuffer::clear_commands()
+{
+    for (const auto& command : commands)
+    {
+        command.dispose(command.self);
+    }
+    commands.clear();
+    current_block = 0;
+    block_offset = 0;
+}
+}  // namespace ecs
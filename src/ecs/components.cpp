@@ -1,5 +1,8 @@
 #include "ecs/components.h"
 
+#include <stdexcept>
+#include <string>
+
 geometry::MotionState
 CameraComponent::get_target_state(const geometry::MotionState& tracked_entity_state,
                                   const Eigen::Isometry3f& relative_offset_pose)
@@ -15,13 +18,41 @@ CameraComponent::get_target_state(const geometry::MotionState& tracked_entity_st
     return target_state;
 }
 
+CollisionFilterComponent CollisionFilterComponent::for_team(const int team,
+                                                            const bool friendly_fire)
+{
+    if (team < 0 || team > 31)
+    {
+        throw std::runtime_error("Team " + std::to_string(team) + " is not in [0, 31]");
+    }
+
+    const std::uint32_t team_layer = 1u << team;
+    return CollisionFilterComponent{ team_layer,
+                                     ~0u,
+                                     friendly_fire ? ~0u : ~team_layer };
+}
+
+FighterComponent::FighterComponent(const std::string& name,
+                                   entt::resource<const urdf::FighterModel> model,
+                                   const bool with_audio)
+  : FighterComponent(name,
+                     model,
+                     geometry::CollisionShape(-model->dimensions / 2.0f, model->dimensions / 2.0f),
+                     with_audio)
+{
+}
+
 FighterComponent::FighterComponent(const std::string& name,
-                                   entt::resource<const urdf::FighterModel> model)
-  : name(name),
-    model(model),
-    fire_sound_source(std::make_unique<audio::AudioSource>(1.0f, false)),
-    engine_sound_source(std::make_unique<audio::AudioSource>(1.0f, true))
+                                   entt::resource<const urdf::FighterModel> model,
+                                   const geometry::CollisionShape& collision_shape,
+                                   const bool with_audio)
+  : name(name), model(model), collision_shape(collision_shape)
 {
+    if (with_audio)
+    {
+        fire_sound_source = std::make_unique<audio::AudioSource>(1.0f, false);
+        engine_sound_source = std::make_unique<audio::AudioSource>(1.0f, true);
+    }
 }
 
 bool FighterComponent::alive() const
@@ -91,14 +122,21 @@ void FighterComponent::try_toggle_fire_mode()
 
 geometry::MotionState
 FighterComponent::get_target_state(const geometry::MotionState& motion_state) const
+{
+    return get_target_state(*model, input, motion_state);
+}
+
+geometry::MotionState FighterComponent::get_target_state(const urdf::FighterModel& model,
+                                                         const urdf::FighterInput& input,
+                                                         const geometry::MotionState& motion_state)
 {
     auto target_state = MotionStateComponent(motion_state.position, motion_state.orientation);
     target_state.velocity =
         target_state.orientation *
-        Eigen::Vector3f(model->motion_limits.velocity * input.current_actuation().d_v, 0.0f, 0.0f);
+        Eigen::Vector3f(model.motion_limits.velocity * input.current_actuation().d_v, 0.0f, 0.0f);
 
     target_state.angular_velocity = motion_state.orientation * input.current_actuation().d_w *
-                                    model->motion_limits.angular_velocity;
+                                    model.motion_limits.angular_velocity;
 
     return target_state;
 }
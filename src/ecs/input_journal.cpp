@@ -0,0 +1,229 @@
+#include "ecs/input_journal.h"
+
+#include <stdexcept>
+
+#include "ecs/binary_io.h"
+#include "ecs/components.h"
+#include "profiling/profiler.h"
+
+namespace ecs
+{
+namespace
+{
+constexpr std::uint32_t journal_magic = 0x4e4a5741;  // "AWJN"
+constexpr std::uint32_t journal_version = 1;
+
+static_assert(urdf::FighterInput::Actions().size() <= 16, "Actions no longer fit a Run");
+}  // namespace
+
+InputJournal::Playback::Playback(const InputJournal& journal)
+  : journal(journal), cursors(journal.tracks.size())
+{
+}
+
+void InputJournal::Playback::apply(Scene& scene, const std::uint32_t tick)
+{
+    if (tick != next_tick)
+    {
+        seek(tick);
+    }
+
+    for (std::size_t i = 0; i < journal.tracks.size(); ++i)
+    {
+        const auto& track = journal.tracks[i];
+        if (tick < track.first_tick || tick >= track.end_tick)
+        {
+            continue;
+        }
+
+        auto& cursor = cursors[i];
+        if (tick == track.first_tick)
+        {
+            cursor = Cursor{ 0, tick };
+        }
+        else if (tick - cursor.run_start >= track.runs[cursor.run].num_ticks)
+        {
+            cursor.run_start += track.runs[cursor.run].num_ticks;
+            ++cursor.run;
+        }
+
+        if (auto* fighter = scene.registry.try_get<FighterComponent>(track.entity))
+        {
+            fighter->input.set_actions(urdf::FighterInput::Actions(track.runs[cursor.run].actions));
+        }
+    }
+
+    next_tick = tick + 1;
+}
+
+// Leaves every track's cursor at the run of the tick before, for apply() to advance from
+void InputJournal::Playback::seek(const std::uint32_t tick)
+{
+    for (std::size_t i = 0; i < journal.tracks.size(); ++i)
+    {
+        const auto& track = journal.tracks[i];
+        auto& cursor = cursors[i];
+        cursor = Cursor{ 0, track.first_tick };
+
+        if (tick <= track.first_tick || tick > track.end_tick)
+        {
+            continue;
+        }
+        while (tick - 1 - cursor.run_start >= track.runs[cursor.run].num_ticks)
+        {
+            cursor.run_start += track.runs[cursor.run].num_ticks;
+            ++cursor.run;
+        }
+    }
+    next_tick = tick;
+}
+
+InputJournal::InputJournal(const std::string& scenario_name, const float dt)
+  : scenario_name(scenario_name), dt(dt)
+{
+}
+
+void InputJournal::record(const Scene& scene)
+{
+    AWING_PROFILE_SCOPE("record_inputs");
+
+    const auto tick = num_ticks;
+    for (const auto [entity, fighter] : scene.registry.view<FighterComponent>().each())
+    {
+        const auto actions = static_cast<std::uint16_t>(fighter.input.get_actions().to_ulong());
+
+        const auto index = static_cast<std::size_t>(entt::to_entity(entity));
+        if (index >= last_tracks.size())
+        {
+            last_tracks.resize(index + 1, 0);
+        }
+
+        // Continues the fighter's track if it was recorded the tick before, so a destroyed fighter
+        // whose entity is reused starts a new one
+        auto& last_track = last_tracks[index];
+        if (last_track != 0 && tracks[last_track - 1].entity == entity &&
+            tracks[last_track - 1].end_tick == tick)
+        {
+            auto& track = tracks[last_track - 1];
+            if (track.runs.back().actions == actions)
+            {
+                ++track.runs.back().num_ticks;
+            }
+            else
+            {
+                track.runs.push_back(Run{ 1, actions });
+            }
+            track.end_tick = tick + 1;
+        }
+        else
+        {
+            tracks.push_back(Track{ entity, tick, tick + 1, { Run{ 1, actions } } });
+            last_track = tracks.size();
+        }
+    }
+
+    ++num_ticks;
+}
+
+const std::string& InputJournal::get_scenario_name() const
+{
+    return scenario_name;
+}
+
+float InputJournal::get_dt() const
+{
+    return dt;
+}
+
+std::uint32_t InputJournal::get_num_ticks() const
+{
+    return num_ticks;
+}
+
+const std::vector<InputJournal::Track>& InputJournal::get_tracks() const
+{
+    return tracks;
+}
+
+void InputJournal::serialize(std::vector<char>& out) const
+{
+    out.clear();
+    auto writer = BinaryWriter(out);
+
+    writer.write(journal_magic);
+    writer.write(journal_version);
+    writer.write_string(scenario_name);
+    writer.write(dt);
+    writer.write(num_ticks);
+
+    writer.write_size(tracks.size());
+    for (const auto& track : tracks)
+    {
+        writer.write(track.entity);
+        writer.write(track.first_tick);
+        writer.write_size(track.runs.size());
+
+        // Field by field, six bytes a run rather than a padded eight
+        for (const auto& run : track.runs)
+        {
+            writer.write(run.num_ticks);
+            writer.write(run.actions);
+        }
+    }
+}
+
+InputJournal InputJournal::deserialize(const std::vector<char>& data)
+{
+    auto reader = BinaryReader(data);
+
+    if (reader.read<std::uint32_t>() != journal_magic)
+    {
+        throw std::runtime_error("Not an input journal");
+    }
+    if (const auto version = reader.read<std::uint32_t>(); version != journal_version)
+    {
+        throw std::runtime_error("Input journal version " + std::to_string(version) +
+                                 " is not supported, expected " +
+                                 std::to_string(journal_version));
+    }
+
+    const auto scenario_name = reader.read_string();
+    auto journal = InputJournal(scenario_name, reader.read<float>());
+    journal.num_ticks = reader.read<std::uint32_t>();
+
+    // Counts are checked against the smallest their elements could take, before allocating
+    const auto check_count = [&reader](const std::size_t count, const std::size_t min_size) {
+        if (count > reader.remaining() / min_size)
+        {
+            throw std::runtime_error("Input journal is truncated");
+        }
+        return count;
+    };
+
+    journal.tracks.resize(check_count(reader.read_size(), 12));
+    for (auto& track : journal.tracks)
+    {
+        track.entity = reader.read<entt::entity>();
+        track.first_tick = reader.read<std::uint32_t>();
+        track.end_tick = track.first_tick;
+        track.runs.resize(check_count(reader.read_size(), 6));
+        for (auto& run : track.runs)
+        {
+            run.num_ticks = reader.read<std::uint32_t>();
+            run.actions = reader.read<std::uint16_t>();
+            if (run.num_ticks == 0)
+            {
+                throw std::runtime_error("Input journal has an empty run");
+            }
+            track.end_tick += run.num_ticks;
+        }
+
+        if (track.runs.empty() || track.end_tick > journal.num_ticks)
+        {
+            throw std::runtime_error("Input journal track is out of bounds");
+        }
+    }
+
+    return journal;
+}
+}  // namespace ecs
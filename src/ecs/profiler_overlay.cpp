@@ -0,0 +1,103 @@
+#include "ecs/profiler_overlay.h"
+
+#include "imgui/imgui.h"
+#include "implot/implot.h"
+
+#include "profiling/profiler.h"
+
+namespace
+{
+void histogram(const char* title, const std::optional<profiling::Profiler::Section>& section)
+{
+    if (!section)
+    {
+        return;
+    }
+
+    const auto samples = section->history();
+    if (ImPlot::BeginPlot(title, ImVec2(-1, 150)))
+    {
+        ImPlot::SetupAxes("ms", "count", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+        ImPlot::PlotHistogram(section->name, samples.data(), static_cast<int>(samples.size()));
+        ImPlot::EndPlot();
+    }
+}
+}  // namespace
+
+namespace ecs
+{
+void draw_profiler_overlay(const RenderSnapshot& snapshot)
+{
+    const auto& profiler = profiling::Profiler::get();
+    const auto sections = profiler.get_sections();
+
+    ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(460, 720), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowBgAlpha(0.8f);
+    ImGui::Begin("Profiler", nullptr, ImGuiWindowFlags_NoFocusOnAppearing);
+
+    if (sections.empty())
+    {
+        ImGui::TextUnformatted("No timings recorded (is BUILD_AWINGALLIANCE_PROFILING on?)");
+    }
+
+    if (ImGui::CollapsingHeader("Systems", ImGuiTreeNodeFlags_DefaultOpen) &&
+        ImGui::BeginTable("sections", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("section");
+        ImGui::TableSetupColumn("last (ms)");
+        ImGui::TableSetupColumn("mean (ms)");
+        ImGui::TableSetupColumn("max (ms)");
+        ImGui::TableHeadersRow();
+        for (const auto& section : sections)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(section.name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", section.last_ms());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", section.mean_ms());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", section.max_ms());
+        }
+        ImGui::EndTable();
+    }
+
+    if (ImGui::CollapsingHeader("Timeline") && ImPlot::BeginPlot("##timeline", ImVec2(-1, 200)))
+    {
+        ImPlot::SetupAxes("sample", "ms", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+        for (const auto& section : sections)
+        {
+            const auto samples = section.history();
+            ImPlot::PlotLine(section.name, samples.data(), static_cast<int>(samples.size()));
+        }
+        ImPlot::EndPlot();
+    }
+
+    if (ImGui::CollapsingHeader("Histograms"))
+    {
+        histogram("Tick time", profiler.find("integrate"));
+        histogram("Frame time", profiler.find("frame"));
+    }
+
+    if (ImGui::CollapsingHeader("Entities", ImGuiTreeNodeFlags_DefaultOpen) &&
+        ImGui::BeginTable("pools", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("component");
+        ImGui::TableSetupColumn("entities");
+        ImGui::TableHeadersRow();
+        for (const auto& [name, size] : snapshot.pool_sizes)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", size);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+}  // namespace ecs
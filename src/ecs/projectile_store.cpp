@@ -0,0 +1,90 @@
+#include "ecs/projectile_store.h"
+
+#include <algorithm>
+
+#include "geometry/geometry.h"
+
+namespace ecs
+{
+Eigen::Vector3f ProjectileStore::Projectile::position(const float t) const
+{
+    return origin + direction * (speed * (t - spawn_time));
+}
+
+Eigen::Isometry3f ProjectileStore::Projectile::pose(const float t) const
+{
+    return geometry::make_pose(position(t), orientation);
+}
+
+bool ProjectileStore::Projectile::expired(const float t) const
+{
+    return spawn_time + lifetime < t;
+}
+
+void ProjectileStore::spawn(const Eigen::Vector3f& origin,
+                            const Eigen::Quaternionf& orientation,
+                            const float spawn_time,
+                            const urdf::FighterModel& fighter_model,
+                            const entt::entity producer,
+                            const std::uint32_t mask)
+{
+    const auto& laser_info = fighter_model.laser_info;
+
+    auto& projectile = projectiles.emplace_back();
+    projectile.origin = origin;
+    projectile.orientation = orientation;
+    projectile.direction = orientation * Eigen::Vector3f::UnitX();
+    projectile.spawn_time = spawn_time;
+    projectile.speed = laser_info.speed;
+    projectile.lifetime = laser_info.lifetime();
+    projectile.length = laser_info.size.x();
+    projectile.producer = producer;
+    projectile.mask = mask;
+    projectile.fighter_model = &fighter_model;
+}
+
+void ProjectileStore::insert(const Projectile& projectile)
+{
+    projectiles.push_back(projectile);
+}
+
+void ProjectileStore::kill(const std::size_t i)
+{
+    projectiles[i].killed = true;
+}
+
+void ProjectileStore::compact(const float t)
+{
+    projectiles.erase(std::remove_if(projectiles.begin(),
+                                     projectiles.end(),
+                                     [t](const Projectile& projectile) {
+                                         return projectile.killed || projectile.expired(t);
+                                     }),
+                      projectiles.end());
+}
+
+void ProjectileStore::clear()
+{
+    projectiles.clear();
+}
+
+std::size_t ProjectileStore::size() const
+{
+    return projectiles.size();
+}
+
+const ProjectileStore::Projectile& ProjectileStore::operator[](const std::size_t i) const
+{
+    return projectiles[i];
+}
+
+std::vector<ProjectileStore::Projectile>::const_iterator ProjectileStore::begin() const
+{
+    return projectiles.begin();
+}
+
+std::vector<ProjectileStore::Projectile>::const_iterator ProjectileStore::end() const
+{
+    return projectiles.end();
+}
+}  // namespace ecs
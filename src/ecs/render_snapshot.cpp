@@ -0,0 +1,12 @@
+#include "ecs/render_snapshot.h"
+
+#include "geometry/geometry.h"
+
+namespace ecs
+{
+Eigen::Isometry3f RenderSnapshot::Motion::pose(const float alpha) const
+{
+    return geometry::make_pose(geometry::lerp(start.position, end.position, alpha),
+                               geometry::slerp(start.orientation, end.orientation, alpha));
+}
+}  // namespace ecs
@@ -0,0 +1,278 @@
+#include "ecs/replay.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include "ecs/binary_io.h"
+#include "ecs/systems.h"
+#include "profiling/profiler.h"
+
+namespace ecs
+{
+namespace
+{
+constexpr std::uint32_t replay_magic = 0x50525741;  // "AWRP"
+constexpr std::uint32_t replay_version = 1;
+
+// At the very end of the file, where finish() writes it
+struct Footer
+{
+    std::uint64_t journal_offset;
+    std::uint64_t index_offset;
+    std::uint32_t magic;
+    std::uint32_t version;
+};
+
+void write(std::ofstream& file, const std::vector<char>& bytes)
+{
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+}  // namespace
+
+ReplayRecorder::ReplayRecorder(const std::string& filename,
+                               const std::string& scenario_name,
+                               const float dt,
+                               const float checkpoint_interval)
+  : file(filename, std::ios::binary),
+    journal(scenario_name, dt),
+    checkpoint_interval_ticks(
+        std::max(1u, static_cast<std::uint32_t>(std::lround(checkpoint_interval / dt))))
+{
+    if (!file)
+    {
+        throw std::runtime_error("Failed to open " + filename + " for writing");
+    }
+
+    std::vector<char> header;
+    auto writer = BinaryWriter(header);
+    writer.write(replay_magic);
+    writer.write(replay_version);
+    write(file, header);
+
+    writer_thread = std::thread(&ReplayRecorder::run_writer, this);
+}
+
+ReplayRecorder::~ReplayRecorder()
+{
+    finish();
+}
+
+void ReplayRecorder::record(const Scene& scene, const float t)
+{
+    const auto tick = journal.get_num_ticks();
+    journal.record(scene);
+
+    if (tick % checkpoint_interval_ticks != 0)
+    {
+        return;
+    }
+
+    AWING_PROFILE_SCOPE("capture_checkpoint");
+
+    auto capture = SceneCapture();
+    {
+        const auto lock = std::lock_guard(mutex);
+        if (!free_captures.empty())
+        {
+            capture = std::move(free_captures.back());
+            free_captures.pop_back();
+        }
+    }
+
+    // Into the capacity of an earlier checkpoint once the writer is done with it
+    capture_scene(scene, t, capture);
+
+    {
+        const auto lock = std::lock_guard(mutex);
+        pending.push_back(PendingCheckpoint{ tick, std::move(capture) });
+    }
+    wake_writer.notify_one();
+}
+
+void ReplayRecorder::finish()
+{
+    if (!writer_thread.joinable())
+    {
+        return;
+    }
+
+    {
+        const auto lock = std::lock_guard(mutex);
+        finishing = true;
+    }
+    wake_writer.notify_one();
+    writer_thread.join();
+
+    auto footer = Footer{ 0, 0, replay_magic, replay_version };
+
+    std::vector<char> bytes;
+    footer.journal_offset = static_cast<std::uint64_t>(file.tellp());
+    journal.serialize(bytes);
+    write(file, bytes);
+
+    footer.index_offset = static_cast<std::uint64_t>(file.tellp());
+    bytes.clear();
+    auto writer = BinaryWriter(bytes);
+    writer.write_size(index.size());
+    for (const auto& [tick, offset] : index)
+    {
+        writer.write(tick);
+        writer.write(offset);
+    }
+    writer.write(footer);
+    write(file, bytes);
+
+    file.close();
+}
+
+void ReplayRecorder::run_writer()
+{
+    std::vector<PendingCheckpoint> batch;
+    std::vector<char> chunk_header;
+    std::vector<char> data;
+
+    while (true)
+    {
+        {
+            auto lock = std::unique_lock(mutex);
+            wake_writer.wait(lock, [this]() { return finishing || !pending.empty(); });
+            if (pending.empty())
+            {
+                return;
+            }
+            std::swap(batch, pending);
+        }
+
+        for (const auto& checkpoint : batch)
+        {
+            write_snapshot(checkpoint.capture, data);
+
+            index.emplace_back(checkpoint.tick, static_cast<std::uint64_t>(file.tellp()));
+
+            chunk_header.clear();
+            auto writer = BinaryWriter(chunk_header);
+            writer.write(checkpoint.tick);
+            writer.write(static_cast<std::uint64_t>(data.size()));
+            write(file, chunk_header);
+            write(file, data);
+        }
+
+        {
+            const auto lock = std::lock_guard(mutex);
+            for (auto& checkpoint : batch)
+            {
+                free_captures.push_back(std::move(checkpoint.capture));
+            }
+        }
+        batch.clear();
+    }
+}
+
+Replay::Replay(InputJournal journal) : journal(std::move(journal))
+{
+}
+
+Replay Replay::read(const std::string& filename)
+{
+    const auto data = read_binary_file(filename);
+    auto reader = BinaryReader(data);
+
+    if (reader.read<std::uint32_t>() != replay_magic)
+    {
+        throw std::runtime_error(filename + " is not a replay");
+    }
+    if (const auto version = reader.read<std::uint32_t>(); version != replay_version)
+    {
+        throw std::runtime_error("Replay version " + std::to_string(version) +
+                                 " is not supported, expected " + std::to_string(replay_version));
+    }
+
+    // A recording that was cut short has no footer, nor a journal to replay
+    if (data.size() < sizeof(Footer))
+    {
+        throw std::runtime_error(filename + " is truncated");
+    }
+    reader.seek(data.size() - sizeof(Footer));
+    const auto footer = reader.read<Footer>();
+    if (footer.magic != replay_magic || footer.version != replay_version ||
+        footer.journal_offset > footer.index_offset || footer.index_offset > data.size())
+    {
+        throw std::runtime_error(filename + " is truncated");
+    }
+
+    auto replay = Replay(InputJournal::deserialize(
+        std::vector<char>(data.begin() + static_cast<std::ptrdiff_t>(footer.journal_offset),
+                          data.begin() + static_cast<std::ptrdiff_t>(footer.index_offset))));
+
+    reader.seek(footer.index_offset);
+    const auto num_checkpoints = reader.read_size();
+    std::vector<std::pair<std::uint32_t, std::uint64_t>> index;
+    for (std::size_t i = 0; i < num_checkpoints; ++i)
+    {
+        const auto tick = reader.read<std::uint32_t>();
+        index.emplace_back(tick, reader.read<std::uint64_t>());
+    }
+
+    for (const auto& [tick, offset] : index)
+    {
+        reader.seek(offset);
+        if (reader.read<std::uint32_t>() != tick)
+        {
+            throw std::runtime_error(filename + " has a corrupt checkpoint index");
+        }
+        auto& checkpoint = replay.checkpoints.emplace_back(Checkpoint{ tick, {} });
+        reader.read_array(checkpoint.data, reader.read<std::uint64_t>());
+    }
+
+    return replay;
+}
+
+const InputJournal& Replay::get_journal() const
+{
+    return journal;
+}
+
+std::vector<std::uint32_t> Replay::get_checkpoint_ticks() const
+{
+    std::vector<std::uint32_t> ticks;
+    for (const auto& checkpoint : checkpoints)
+    {
+        ticks.push_back(checkpoint.tick);
+    }
+    return ticks;
+}
+
+float Replay::seek(Scene& scene, InputJournal::Playback& playback, const std::uint32_t tick) const
+{
+    AWING_PROFILE_SCOPE("seek_replay");
+
+    const auto checkpoint =
+        std::upper_bound(checkpoints.begin(),
+                         checkpoints.end(),
+                         tick,
+                         [](const std::uint32_t value, const Checkpoint& checkpoint) {
+                             return value < checkpoint.tick;
+                         });
+    if (checkpoint == checkpoints.begin())
+    {
+        throw std::runtime_error("Replay has no checkpoint to seek to tick " +
+                                 std::to_string(tick) + " from");
+    }
+
+    const auto& start = *std::prev(checkpoint);
+    float t = load_snapshot(scene, start.data);
+
+    const float dt = journal.get_dt();
+    for (auto i = start.tick; i < tick; ++i)
+    {
+        playback.apply(scene, i);
+        systems::integrate(scene, t, dt);
+        t += dt;
+    }
+
+    return t;
+}
+}  // namespace ecs
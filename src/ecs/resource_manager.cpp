@@ -1,21 +1,27 @@
 #include "ecs/resource_manager.h"
 
+#include "profiling/profiler.h"
+
 namespace
 {
 }  // namespace
 
 namespace ecs
 {
-ResourceManager::ResourceManager()
+ResourceManager::ResourceManager(const bool headless)
 {
-    load_primitive("box");
-    load_primitive("quad");
+    if (!headless)
+    {
+        load_primitive("box");
+        load_primitive("quad");
+    }
 }
 
 void ResourceManager::load_model(const std::string& uri)
 {
     if (auto uri_hash = entt::hashed_string(uri.data()); !model_cache.contains(uri_hash))
     {
+        AWING_PROFILE_SCOPE_DETAIL("load_model", uri.c_str());
         model_cache.load(uri_hash, uri);
 
         for (const auto& mesh : model_cache[uri_hash]->get_meshes())
@@ -37,6 +43,8 @@ void ResourceManager::load_primitive(const std::string& name)
         return;
     }
 
+    AWING_PROFILE_SCOPE_DETAIL("load_primitive", name.c_str());
+
     if (name == "box")
     {
         model_cache.load(entt::hashed_string(name.c_str()), &rendering::primitives::box);
@@ -55,6 +63,7 @@ void ResourceManager::load_texture(const std::string& uri, const bool as_cubemap
 {
     if (auto texture_uri = entt::hashed_string(uri.c_str()); !texture_cache.contains(texture_uri))
     {
+        AWING_PROFILE_SCOPE_DETAIL("load_texture", uri.c_str());
         texture_cache.load(texture_uri, uri, as_cubemap);
     }
 }
@@ -69,6 +78,7 @@ void ResourceManager::load_shader(const std::string& uri,
                                   const std::string& frag_filename,
                                   const std::optional<std::string>& geom_filename)
 {
+    AWING_PROFILE_SCOPE_DETAIL("load_shader", uri.c_str());
     shader_cache.load(
         entt::hashed_string(uri.c_str()), uri, vert_filename, frag_filename, geom_filename);
 }
@@ -77,6 +87,7 @@ void ResourceManager::load_fighter_model(const std::string& uri)
 {
     if (auto uri_hash = entt::hashed_string(uri.data()); !fighter_model_cache.contains(uri_hash))
     {
+        AWING_PROFILE_SCOPE_DETAIL("load_fighter_model", uri.c_str());
         fighter_model_cache.load(uri_hash, uri);
 
         if (const auto& visual_name = fighter_model_cache[uri_hash]->visual_name;
@@ -91,10 +102,20 @@ void ResourceManager::load_sound(const std::string& uri)
 {
     if (auto uri_hash = entt::hashed_string(uri.data()); !sound_cache.contains(uri_hash))
     {
+        AWING_PROFILE_SCOPE_DETAIL("load_sound", uri.c_str());
         sound_cache.load(uri_hash, uri);
     }
 }
 
+void ResourceManager::load_collision_model(const std::string& uri)
+{
+    if (auto uri_hash = entt::hashed_string(uri.data()); !collision_model_cache.contains(uri_hash))
+    {
+        AWING_PROFILE_SCOPE_DETAIL("load_collision_model", uri.c_str());
+        collision_model_cache.load(uri_hash, uri);
+    }
+}
+
 void ResourceManager::update_shaders(
     std::function<void(const entt::resource<rendering::ShaderProgram>&)> fn)
 {
@@ -134,4 +155,10 @@ entt::resource<const audio::AudioBuffer> ResourceManager::get_sound(const std::s
 {
     return sound_cache[entt::hashed_string(uri.c_str())];
 }
+
+entt::resource<const geometry::Bvh>
+ResourceManager::get_collision_model(const std::string& uri) const
+{
+    return collision_model_cache[entt::hashed_string(uri.c_str())];
+}
 }  // namespace ecs
@@ -7,13 +7,19 @@
 #include "rendering/primitives.h"
 #include "rendering/compile_shader_program.h"
 #include "ecs/components.h"
+#include "profiling/profiler.h"
 
 #include "yaml-cpp/yaml.h"
 
 namespace ecs
 {
-Scene::Scene()
+Scene::Scene(const bool headless) : headless(headless), resource_manager(headless)
 {
+    if (headless)
+    {
+        return;
+    }
+
     resource_manager.load_shader("model", "model.vert", "model.frag");
     resource_manager.load_shader("skybox", "sky.vert", "sky.frag");
     resource_manager.load_shader("spark", "model.vert", "spark.frag");
@@ -29,28 +35,33 @@ Scene::Scene()
 entt::entity Scene::register_ship(const std::string& name,
                                   const std::string& urdf_filename,
                                   const Eigen::Vector3f& position,
-                                  const Eigen::Quaternionf& orientation)
+                                  const Eigen::Quaternionf& orientation,
+                                  const std::optional<int>& team)
 {
+    AWING_PROFILE_SCOPE_DETAIL("register_ship", urdf_filename.c_str());
+
     resource_manager.load_fighter_model(urdf_filename);
     auto fighter_model_handle = resource_manager.get_fighter_model(urdf_filename);
 
-    resource_manager.load_model(fighter_model_handle->visual_name);
-    auto model_handle = resource_manager.get_model(fighter_model_handle->visual_name);
-
-    auto texture_handles = std::vector<entt::resource<const rendering::Texture>>();
-    for (const auto& mesh : model_handle->get_meshes())
-    {
-        texture_handles.push_back(resource_manager.get_texture(mesh.get_texture_name()));
-    }
-
     const auto entity = registry.create();
-    registry.emplace<FighterComponent>(entity, name, fighter_model_handle);
-    registry.emplace<VisualComponent>(entity, model_handle, texture_handles);
+    registry.emplace<FighterComponent>(entity, name, fighter_model_handle, !headless);
     registry.emplace<MotionStateComponent>(entity, position, orientation);
+    registry.emplace<PreviousPoseComponent>(entity, position, orientation);
+    registry.emplace<CollisionFilterComponent>(
+        entity,
+        CollisionFilterComponent::for_team(team.value_or(fighter_model_handle->team),
+                                           friendly_fire));
     registry.emplace<HealthComponent>(entity,
                                       fighter_model_handle->health_info.shields_max,
                                       fighter_model_handle->health_info.hull_max);
 
+    if (headless)
+    {
+        return entity;
+    }
+
+    emplace_visual(entity, fighter_model_handle->visual_name);
+
     if (!fighter_model_handle->sounds.laser.empty())
     {
         resource_manager.load_sound(fighter_model_handle->sounds.laser);
@@ -68,40 +79,94 @@ entt::entity Scene::register_ship(const std::string& name,
     return entity;
 }
 
-entt::entity Scene::register_camera(const Eigen::Matrix4f& perspective)
+entt::entity Scene::register_actor(const std::string& name,
+                                   const std::string& visual_filename,
+                                   const std::optional<std::string>& geometry_filename,
+                                   const Eigen::Vector3f& position,
+                                   const Eigen::Quaternionf& orientation,
+                                   const std::optional<int>& team)
 {
-    auto entity = registry.create();
+    AWING_PROFILE_SCOPE_DETAIL("register_actor", visual_filename.c_str());
 
-    resource_manager.update_shaders(
-        [&perspective](const entt::resource<rendering::ShaderProgram>& program) {
-            program->use();
-            program->setUniformMatrix4fv("perspective", perspective);
-        });
+    const auto entity = registry.create();
+    registry.emplace<ActorComponent>(entity, name);
+    registry.emplace<MotionStateComponent>(entity, position, orientation);
 
-    registry.emplace<MotionStateComponent>(entity);
-    registry.emplace<CameraComponent>(entity, perspective);
+    if (geometry_filename)
+    {
+        resource_manager.load_collision_model(*geometry_filename);
+        registry.emplace<CollisionComponent>(
+            entity, resource_manager.get_collision_model(*geometry_filename));
+        registry.emplace<PreviousPoseComponent>(entity, position, orientation);
+
+        // Actors don't fire, so only their layer matters
+        if (team)
+        {
+            registry.emplace<CollisionFilterComponent>(
+                entity, CollisionFilterComponent::for_team(*team, friendly_fire));
+        }
+    }
+
+    if (headless)
+    {
+        return entity;
+    }
+
+    emplace_visual(entity, visual_filename);
 
     return entity;
 }
 
-entt::entity Scene::register_laser(const Eigen::Vector3f& position,
-                                   const Eigen::Quaternionf& orientation,
-                                   const entt::resource<const urdf::FighterModel> model,
-                                   const Eigen::Vector3f& size,
-                                   const Eigen::Vector3f color,
-                                   const float speed,
-                                   entt::entity producer)
+void Scene::emplace_visual(const entt::entity entity, const std::string& visual_filename)
+{
+    resource_manager.load_model(visual_filename);
+    auto model_handle = resource_manager.get_model(visual_filename);
+
+    auto texture_handles = std::vector<entt::resource<const rendering::Texture>>();
+    for (const auto& mesh : model_handle->get_meshes())
+    {
+        texture_handles.push_back(resource_manager.get_texture(mesh.get_texture_name()));
+    }
+
+    registry.emplace<VisualComponent>(entity, model_handle, texture_handles);
+}
+
+entt::entity Scene::register_camera(const Eigen::Matrix4f& perspective)
 {
     auto entity = registry.create();
-    auto& motion_state = registry.emplace<MotionStateComponent>(entity, position, orientation);
-    motion_state.velocity = orientation * Eigen::Vector3f(speed, 0, 0);
-    registry.emplace<LaserComponent>(entity, producer, model, size(0));
-    registry.emplace<VisualComponent>(
-        entity, resource_manager.get_model("box"), std::nullopt, color, size);
+
+    if (!headless)
+    {
+        resource_manager.update_shaders(
+            [&perspective](const entt::resource<rendering::ShaderProgram>& program) {
+                program->use();
+                program->setUniformMatrix4fv("perspective", perspective);
+            });
+    }
+
+    const auto& motion_state = registry.emplace<MotionStateComponent>(entity);
+    registry.emplace<PreviousPoseComponent>(
+        entity, motion_state.position, motion_state.orientation);
+    registry.emplace<CameraComponent>(entity, perspective);
 
     return entity;
 }
 
+void Scene::register_laser(const Eigen::Vector3f& position,
+                           const Eigen::Quaternionf& orientation,
+                           const entt::resource<const urdf::FighterModel> model,
+                           const float birth_time,
+                           entt::entity producer)
+{
+    const auto* filter = registry.try_get<CollisionFilterComponent>(producer);
+    lasers.spawn(position,
+                 orientation,
+                 birth_time,
+                 *model,
+                 producer,
+                 filter ? filter->laser_mask : CollisionFilterComponent().laser_mask);
+}
+
 entt::entity Scene::register_billboard(const Eigen::Vector3f& position,
                                        const Eigen::Quaternionf& orientation,
                                        const Eigen::Vector3f& size,
@@ -127,7 +192,7 @@ entt::entity Scene::register_skybox(const std::string& skybox_uri)
     return entity;
 }
 
-entt::entity Scene::register_sound_effect(const std::string buffer_name,
+entt::entity Scene::register_sound_effect(const std::string& buffer_name,
                                           const Eigen::Vector3f position,
                                           const Eigen::Quaternionf& orientation)
 {
@@ -4,6 +4,7 @@
 #include "ecs/components.h"
 #include "geometry/geometry.h"
 #include "resources/locator.h"
+#include "profiling/profiler.h"
 
 namespace
 {
@@ -17,22 +18,35 @@ Eigen::Quaternionf to_quat(const YAML::Node& node)
     return Eigen::Quaternionf(
         node[0].as<float>(), node[1].as<float>(), node[2].as<float>(), node[3].as<float>());
 }
+
+std::optional<int> to_team(const YAML::Node& node)
+{
+    return node ? std::make_optional(node.as<int>()) : std::nullopt;
+}
 }  // namespace
 
 namespace ecs
 {
-std::shared_ptr<Scene> SceneFactory::create_from_scenario(const std::string& scenario_name)
+std::shared_ptr<Scene> SceneFactory::create_from_scenario(const std::string& scenario_name,
+                                                          const bool headless)
 {
+    AWING_PROFILE_SCOPE_DETAIL("create_from_scenario", scenario_name.c_str());
+
     YAML::Node node = YAML::LoadFile(resources::locator::ROOT_PATH + scenario_name + ".yaml");
 
-    auto ret = std::make_shared<Scene>();
+    auto ret = std::make_shared<Scene>(headless);
+    if (node["friendly_fire"])
+    {
+        ret->friendly_fire = node["friendly_fire"].as<bool>();
+    }
 
     for (const auto& actor_node : node["ships"])
     {
         auto entity = ret->register_ship(actor_node["name"].as<std::string>(),
                                          actor_node["urdf_filename"].as<std::string>(),
                                          to_vec3(actor_node["position"]),
-                                         to_quat(actor_node["orientation"]));
+                                         to_quat(actor_node["orientation"]),
+                                         to_team(actor_node["team"]));
 
         if (actor_node["player"] && actor_node["player"].as<bool>())
         {
@@ -49,6 +63,18 @@ std::shared_ptr<Scene> SceneFactory::create_from_scenario(const std::string& sce
         throw std::runtime_error("Scenario file does not specify which ship is the player");
     }
 
+    for (const auto& actor_node : node["actors"])
+    {
+        ret->register_actor(actor_node["name"].as<std::string>(),
+                            actor_node["visual"].as<std::string>(),
+                            actor_node["geometry"] ?
+                                std::make_optional(actor_node["geometry"].as<std::string>()) :
+                                std::nullopt,
+                            to_vec3(actor_node["position"]),
+                            to_quat(actor_node["orientation"]),
+                            to_team(actor_node["team"]));
+    }
+
     for (const auto& camera_node : node["cameras"])
     {
         auto entity = ret->register_camera(
@@ -68,7 +94,10 @@ std::shared_ptr<Scene> SceneFactory::create_from_scenario(const std::string& sce
         throw std::runtime_error("Scenario file does not specify a main/active camera");
     }
 
-    ret->register_skybox(node["skybox"].as<std::string>());
+    if (!headless)
+    {
+        ret->register_skybox(node["skybox"].as<std::string>());
+    }
 
     return ret;
 }
@@ -0,0 +1,47 @@
+#include "ecs/scheduler.h"
+
+#include "ecs/scene.h"
+#include "profiling/profiler.h"
+
+namespace ecs
+{
+void Scheduler::add(const char* name,
+                    SystemFn fn,
+                    const jobs::TaskGraph::Access& reads,
+                    const jobs::TaskGraph::Access& writes,
+                    const bool exclusive)
+{
+    graph.add(reads, writes, exclusive);
+    systems.push_back(System{ name, std::move(fn), std::make_unique<CommandBuffer>() });
+}
+
+bool Scheduler::empty() const
+{
+    return systems.empty();
+}
+
+void Scheduler::run(Scene& scene, const float t, const float dt)
+{
+    graph.run(scene.thread_pool, [this, &scene, t, dt](const std::size_t i) {
+        auto& system = systems[i];
+        system.fn(scene, *system.commands, t, dt);
+    });
+
+    // Sync point
+    AWING_PROFILE_SCOPE("flush_commands");
+    for (auto& system : systems)
+    {
+        system.commands->flush(scene);
+    }
+}
+
+const jobs::TaskGraph& Scheduler::get_graph() const
+{
+    return graph;
+}
+
+const char* Scheduler::get_name(const std::size_t system) const
+{
+    return systems[system].name;
+}
+}  // namespace ecs
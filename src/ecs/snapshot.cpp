@@ -0,0 +1,654 @@
+#include "ecs/snapshot.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include "ecs/binary_io.h"
+#include "ecs/components.h"
+#include "profiling/profiler.h"
+
+namespace ecs
+{
+namespace
+{
+constexpr std::uint32_t snapshot_magic = 0x50414e53;  // "SNAP"
+constexpr std::uint32_t snapshot_version = 2;
+
+struct Header
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    float t;
+    entt::entity player_uid;
+    entt::entity camera_uid;
+};
+
+// What a FighterComponent holds besides its model and collision shape, which follow from the
+// model, and its audio sources, which are recreated
+struct FighterRecord
+{
+    entt::id_type model;
+    std::uint32_t name_begin;  // Into the blob of all fighter names
+    std::uint32_t name_size;
+    std::uint32_t actions;
+    std::int32_t current_fire_mode;
+    std::int32_t current_spawn_idx;
+    float last_fired_time;
+    float time_of_death;  // NaN while alive
+};
+
+// A ProjectileStore::Projectile, with its fighter model's hash in place of the pointer
+struct LaserRecord
+{
+    std::array<float, 3> origin;
+    std::array<float, 4> orientation;  // x, y, z, w
+    std::array<float, 3> direction;
+    float spawn_time;
+    float speed;
+    float lifetime;
+    float length;
+    entt::entity producer;
+    std::uint32_t mask;
+    entt::id_type model;
+    std::uint32_t killed;
+};
+
+// Records are written whole, so any padding would put whatever bytes were there into the file
+static_assert(sizeof(Header) == 5 * 4 && sizeof(FighterRecord) == 8 * 4 &&
+                  sizeof(LaserRecord) == 18 * 4,
+              "Snapshot records must not have padding");
+
+entt::id_type hash_uri(const std::string& uri)
+{
+    return entt::hashed_string(uri.data()).value();
+}
+
+// Components are written field by field, as those with Eigen members are padded for alignment
+void write_component(BinaryWriter& writer, const MotionStateComponent& state)
+{
+    writer.write(state.position);
+    writer.write(state.orientation.coeffs());
+    writer.write(state.velocity);
+    writer.write(state.acceleration);
+    writer.write(state.angular_velocity);
+    writer.write(state.angular_acceleration);
+}
+
+void read_component(BinaryReader& reader, MotionStateComponent& state)
+{
+    state.position = reader.read<Eigen::Vector3f>();
+    state.orientation.coeffs() = reader.read<Eigen::Vector4f>();
+    state.velocity = reader.read<Eigen::Vector3f>();
+    state.acceleration = reader.read<Eigen::Vector3f>();
+    state.angular_velocity = reader.read<Eigen::Vector3f>();
+    state.angular_acceleration = reader.read<Eigen::Vector3f>();
+}
+
+void write_component(BinaryWriter& writer, const PreviousPoseComponent& pose)
+{
+    writer.write(pose.position);
+    writer.write(pose.orientation.coeffs());
+}
+
+void read_component(BinaryReader& reader, PreviousPoseComponent& pose)
+{
+    pose.position = reader.read<Eigen::Vector3f>();
+    pose.orientation.coeffs() = reader.read<Eigen::Vector4f>();
+}
+
+void write_component(BinaryWriter& writer, const HealthComponent& health)
+{
+    writer.write(health.shields);
+    writer.write(health.hull);
+}
+
+void read_component(BinaryReader& reader, HealthComponent& health)
+{
+    health.shields = reader.read<float>();
+    health.hull = reader.read<float>();
+}
+
+void write_component(BinaryWriter& writer, const CollisionFilterComponent& filter)
+{
+    writer.write(filter.layer);
+    writer.write(filter.mask);
+    writer.write(filter.laser_mask);
+}
+
+void read_component(BinaryReader& reader, CollisionFilterComponent& filter)
+{
+    filter.layer = reader.read<std::uint32_t>();
+    filter.mask = reader.read<std::uint32_t>();
+    filter.laser_mask = reader.read<std::uint32_t>();
+}
+
+void write_component(BinaryWriter& writer, const BillboardComponent& billboard)
+{
+    writer.write(billboard.size);
+    writer.write(billboard.birth_time);
+    writer.write(billboard.duration);
+}
+
+void read_component(BinaryReader& reader, BillboardComponent& billboard)
+{
+    billboard.size = reader.read<Eigen::Matrix4f>();
+    billboard.birth_time = reader.read<float>();
+    billboard.duration = reader.read<float>();
+}
+
+template <typename Component>
+using Pool = SceneCapture::Pool<Component>;
+
+template <typename Component>
+void capture_pool(const entt::registry& registry, Pool<Component>& pool)
+{
+    const auto view = registry.view<Component>();
+    pool.entities.assign(view.begin(), view.end());
+    pool.components.clear();
+    for (const auto entity : view)
+    {
+        pool.components.push_back(view.template get<Component>(entity));
+    }
+}
+
+// Ids, then the components
+template <typename Component>
+void write_pool(const Pool<Component>& pool, BinaryWriter& writer)
+{
+    writer.write_size(pool.entities.size());
+    for (const auto entity : pool.entities)
+    {
+        writer.write(entity);
+    }
+    for (const auto& component : pool.components)
+    {
+        write_component(writer, component);
+    }
+}
+
+template <typename Component>
+Pool<Component> read_pool(BinaryReader& reader)
+{
+    auto pool = Pool<Component>();
+    reader.read_array(pool.entities, reader.read_size());
+
+    // Every component takes at least 4 bytes, which bounds a corrupt count
+    if (pool.entities.size() > reader.remaining() / 4)
+    {
+        throw std::runtime_error("Unexpected end of binary data");
+    }
+    pool.components.resize(pool.entities.size());
+    for (auto& component : pool.components)
+    {
+        read_component(reader, component);
+    }
+    return pool;
+}
+
+template <typename Component>
+void load_pool(entt::registry& registry, const Pool<Component>& pool)
+{
+    // Views iterate pools back to front, so records go in reversed to restore the order they were
+    // saved from, which later iterations, and so the simulation, depend on
+    registry.clear<Component>();
+    registry.insert<Component>(
+        pool.entities.rbegin(), pool.entities.rend(), pool.components.rbegin());
+}
+
+void write_entities(const std::vector<entt::entity>& entities, BinaryWriter& writer)
+{
+    writer.write_size(entities.size());
+    for (const auto entity : entities)
+    {
+        writer.write(entity);
+    }
+}
+
+std::vector<entt::entity> read_entities(BinaryReader& reader)
+{
+    std::vector<entt::entity> entities;
+    reader.read_array(entities, reader.read_size());
+    return entities;
+}
+
+// Sorted entities owning any of the components
+template <typename... Component>
+std::vector<entt::entity> collect_entities(const entt::registry& registry)
+{
+    std::vector<entt::entity> entities;
+    (
+        [&registry, &entities]() {
+            const auto view = registry.view<Component>();
+            entities.insert(entities.end(), view.begin(), view.end());
+        }(),
+        ...);
+
+    std::sort(entities.begin(), entities.end());
+    entities.erase(std::unique(entities.begin(), entities.end()), entities.end());
+    return entities;
+}
+
+// Everything in a snapshot, read and checked before any of it goes into the scene
+struct ParsedSnapshot
+{
+    Header header;
+    std::vector<entt::entity> entities;  // Sorted
+
+    Pool<MotionStateComponent> motion_states;
+    Pool<PreviousPoseComponent> previous_poses;
+    Pool<HealthComponent> healths;
+    Pool<CollisionFilterComponent> collision_filters;
+    Pool<BillboardComponent> billboards;
+
+    std::vector<entt::entity> spline_entities;
+    std::vector<Eigen::Matrix<float, 4, 3>> spline_control_points;
+
+    std::vector<entt::entity> fighter_entities;
+    std::vector<FighterRecord> fighter_records;
+    std::string fighter_names;
+
+    std::vector<entt::entity> roaming_entities;
+
+    std::vector<ProjectileStore::Projectile> lasers;
+
+    std::unordered_map<entt::id_type, entt::resource<const urdf::FighterModel>> models;
+};
+
+ParsedSnapshot parse_snapshot(Scene& scene, const std::vector<char>& data)
+{
+    auto reader = BinaryReader(data);
+    auto snapshot = ParsedSnapshot();
+
+    snapshot.header = reader.read<Header>();
+    if (snapshot.header.magic != snapshot_magic)
+    {
+        throw std::runtime_error("Not a snapshot");
+    }
+    if (snapshot.header.version != snapshot_version)
+    {
+        throw std::runtime_error("Snapshot version " + std::to_string(snapshot.header.version) +
+                                 " is not supported, expected " +
+                                 std::to_string(snapshot_version));
+    }
+
+    snapshot.entities = read_entities(reader);
+    if (!std::is_sorted(snapshot.entities.begin(), snapshot.entities.end()))
+    {
+        throw std::runtime_error("Snapshot entities are not sorted");
+    }
+
+    // Loading a model only fills the ResourceManager's cache, which is no part of the scene's state
+    const auto num_uris = reader.read_size();
+    for (std::size_t i = 0; i < num_uris; ++i)
+    {
+        const auto hash = reader.read<entt::id_type>();
+        const auto uri = reader.read_string();
+        scene.resource_manager.load_fighter_model(uri);
+        snapshot.models.emplace(hash, scene.resource_manager.get_fighter_model(uri));
+    }
+    const auto get_model = [&snapshot](const entt::id_type hash) {
+        const auto it = snapshot.models.find(hash);
+        if (it == snapshot.models.end())
+        {
+            throw std::runtime_error("Snapshot refers to a fighter model it has no URI for");
+        }
+        return it->second;
+    };
+
+    snapshot.motion_states = read_pool<MotionStateComponent>(reader);
+    snapshot.previous_poses = read_pool<PreviousPoseComponent>(reader);
+    snapshot.healths = read_pool<HealthComponent>(reader);
+    snapshot.collision_filters = read_pool<CollisionFilterComponent>(reader);
+    snapshot.billboards = read_pool<BillboardComponent>(reader);
+
+    const auto num_splines = reader.read_size();
+    reader.read_array(snapshot.spline_entities, num_splines);
+    reader.read_array(snapshot.spline_control_points, num_splines);
+
+    const auto num_fighters = reader.read_size();
+    reader.read_array(snapshot.fighter_entities, num_fighters);
+    reader.read_array(snapshot.fighter_records, num_fighters);
+    snapshot.fighter_names = reader.read_string();
+    for (const auto& record : snapshot.fighter_records)
+    {
+        if (static_cast<std::size_t>(record.name_begin) + record.name_size >
+            snapshot.fighter_names.size())
+        {
+            throw std::runtime_error("Snapshot fighter name is out of bounds");
+        }
+        get_model(record.model);
+    }
+
+    snapshot.roaming_entities = read_entities(reader);
+
+    std::vector<LaserRecord> lasers;
+    reader.read_array(lasers, reader.read_size());
+    for (const auto& laser : lasers)
+    {
+        auto& projectile = snapshot.lasers.emplace_back();
+        projectile.origin = Eigen::Vector3f(laser.origin.data());
+        projectile.orientation.coeffs() = Eigen::Vector4f(laser.orientation.data());
+        projectile.direction = Eigen::Vector3f(laser.direction.data());
+        projectile.spawn_time = laser.spawn_time;
+        projectile.speed = laser.speed;
+        projectile.lifetime = laser.lifetime;
+        projectile.length = laser.length;
+        projectile.producer = laser.producer;
+        projectile.mask = laser.mask;
+        projectile.fighter_model = &*get_model(laser.model);
+        projectile.killed = laser.killed != 0;
+    }
+
+    return snapshot;
+}
+
+// Throws unless every entity the snapshot's pools refer to is among those it lists
+void check_listed(const ParsedSnapshot& snapshot, const std::vector<entt::entity>& entities)
+{
+    for (const auto entity : entities)
+    {
+        if (!std::binary_search(snapshot.entities.begin(), snapshot.entities.end(), entity))
+        {
+            throw std::runtime_error("Snapshot entity " +
+                                     std::to_string(entt::to_integral(entity)) +
+                                     " is missing from its entity list");
+        }
+    }
+}
+
+// Throws if an entity of the snapshot can't be recreated with its id, because another entity of
+// the scene that load_snapshot keeps holds the same index
+void check_available(const entt::registry& registry,
+                     const std::vector<entt::entity>& entities,
+                     const std::vector<entt::entity>& transient)
+{
+    using traits = entt::entt_traits<entt::entity>;
+    for (const auto entity : entities)
+    {
+        if (registry.valid(entity))
+        {
+            continue;
+        }
+
+        const auto holder = traits::construct(traits::to_entity(entity), registry.current(entity));
+        if (registry.valid(holder) &&
+            !std::binary_search(transient.begin(), transient.end(), holder))
+        {
+            throw std::runtime_error("Snapshot entity " +
+                                     std::to_string(entt::to_integral(entity)) +
+                                     " is taken by another entity of the scene");
+        }
+    }
+}
+}  // namespace
+
+void capture_scene(const Scene& scene, const float t, SceneCapture& capture)
+{
+    AWING_PROFILE_SCOPE("capture_scene");
+
+    const auto& registry = scene.registry;
+    capture.t = t;
+    capture.player_uid = scene.player_uid;
+    capture.camera_uid = scene.camera_uid;
+
+    capture_pool(registry, capture.motion_states);
+    capture_pool(registry, capture.previous_poses);
+    capture_pool(registry, capture.healths);
+    capture_pool(registry, capture.collision_filters);
+    capture_pool(registry, capture.billboards);
+
+    // The samples follow from the control points
+    {
+        const auto view = registry.view<SplineComponent>();
+        capture.splines.entities.assign(view.begin(), view.end());
+        capture.splines.components.clear();
+        for (const auto [entity, spline] : view.each())
+        {
+            capture.splines.components.push_back(spline.curve.C);
+        }
+    }
+
+    // Assigned in place, so that names reuse the capacity of those of an earlier capture
+    {
+        const auto view = registry.view<FighterComponent>();
+        capture.fighters.entities.assign(view.begin(), view.end());
+        capture.fighters.components.resize(view.size());
+        auto fighter = capture.fighters.components.begin();
+        for (const auto [entity, component] : view.each())
+        {
+            fighter->model = component.model;
+            fighter->name = component.name;
+            fighter->actions = static_cast<std::uint32_t>(component.input.get_actions().to_ulong());
+            fighter->current_fire_mode = component.current_fire_mode;
+            fighter->current_spawn_idx = component.current_spawn_idx;
+            fighter->last_fired_time = component.last_fired_time;
+            fighter->time_of_death = component.time_of_death;
+            ++fighter;
+        }
+    }
+
+    // Its context holds nothing that outlives a tick, so a fresh one is made on load
+    {
+        const auto view = registry.view<RoamingStateMachineComponent>();
+        capture.roaming_entities.assign(view.begin(), view.end());
+    }
+
+    capture.lasers.assign(scene.lasers.begin(), scene.lasers.end());
+}
+
+void write_snapshot(const SceneCapture& capture, std::vector<char>& out)
+{
+    AWING_PROFILE_SCOPE("write_snapshot");
+
+    out.clear();
+    auto writer = BinaryWriter(out);
+
+    writer.write(Header{
+        snapshot_magic, snapshot_version, capture.t, capture.player_uid, capture.camera_uid });
+
+    // Every entity a pool below refers to, for the loader to recreate with the same ids
+    std::vector<entt::entity> entities;
+    for (const auto* pool_entities : { &capture.motion_states.entities,
+                                       &capture.previous_poses.entities,
+                                       &capture.healths.entities,
+                                       &capture.collision_filters.entities,
+                                       &capture.billboards.entities,
+                                       &capture.splines.entities,
+                                       &capture.fighters.entities,
+                                       &capture.roaming_entities })
+    {
+        entities.insert(entities.end(), pool_entities->begin(), pool_entities->end());
+    }
+    std::sort(entities.begin(), entities.end());
+    entities.erase(std::unique(entities.begin(), entities.end()), entities.end());
+    write_entities(entities, writer);
+
+    // The fighter models of fighters and lasers, by hash
+    std::map<entt::id_type, const std::string*> uris;
+    for (const auto& fighter : capture.fighters.components)
+    {
+        uris.emplace(hash_uri(fighter.model->uri), &fighter.model->uri);
+    }
+    for (const auto& laser : capture.lasers)
+    {
+        uris.emplace(hash_uri(laser.fighter_model->uri), &laser.fighter_model->uri);
+    }
+    writer.write_size(uris.size());
+    for (const auto& [hash, uri] : uris)
+    {
+        writer.write(hash);
+        writer.write_string(*uri);
+    }
+
+    write_pool(capture.motion_states, writer);
+    write_pool(capture.previous_poses, writer);
+    write_pool(capture.healths, writer);
+    write_pool(capture.collision_filters, writer);
+    write_pool(capture.billboards, writer);
+
+    write_entities(capture.splines.entities, writer);
+    for (const auto& control_points : capture.splines.components)
+    {
+        writer.write(control_points);
+    }
+
+    // Fighters as records, their names in a blob after them
+    write_entities(capture.fighters.entities, writer);
+    std::string names;
+    for (const auto& fighter : capture.fighters.components)
+    {
+        writer.write(FighterRecord{
+            hash_uri(fighter.model->uri),
+            static_cast<std::uint32_t>(names.size()),
+            static_cast<std::uint32_t>(fighter.name.size()),
+            fighter.actions,
+            fighter.current_fire_mode,
+            fighter.current_spawn_idx,
+            fighter.last_fired_time,
+            fighter.time_of_death.value_or(std::numeric_limits<float>::quiet_NaN()) });
+        names += fighter.name;
+    }
+    writer.write_string(names);
+
+    write_entities(capture.roaming_entities, writer);
+
+    writer.write_size(capture.lasers.size());
+    for (const auto& laser : capture.lasers)
+    {
+        const auto& q = laser.orientation;
+        writer.write(LaserRecord{ { laser.origin.x(), laser.origin.y(), laser.origin.z() },
+                                  { q.x(), q.y(), q.z(), q.w() },
+                                  { laser.direction.x(), laser.direction.y(), laser.direction.z() },
+                                  laser.spawn_time,
+                                  laser.speed,
+                                  laser.lifetime,
+                                  laser.length,
+                                  laser.producer,
+                                  laser.mask,
+                                  hash_uri(laser.fighter_model->uri),
+                                  laser.killed });
+    }
+}
+
+void save_snapshot(const Scene& scene, const float t, std::vector<char>& out)
+{
+    AWING_PROFILE_SCOPE("save_snapshot");
+
+    auto capture = SceneCapture();
+    capture_scene(scene, t, capture);
+    write_snapshot(capture, out);
+}
+
+float load_snapshot(Scene& scene, const std::vector<char>& data)
+{
+    AWING_PROFILE_SCOPE("load_snapshot");
+
+    auto& registry = scene.registry;
+
+    // Nothing in the scene changes until the whole snapshot has been read and checked, so that one
+    // that fails to load leaves the scene as it was
+    const auto snapshot = parse_snapshot(scene, data);
+    check_listed(snapshot, snapshot.motion_states.entities);
+    check_listed(snapshot, snapshot.previous_poses.entities);
+    check_listed(snapshot, snapshot.healths.entities);
+    check_listed(snapshot, snapshot.collision_filters.entities);
+    check_listed(snapshot, snapshot.billboards.entities);
+    check_listed(snapshot, snapshot.spline_entities);
+    check_listed(snapshot, snapshot.fighter_entities);
+    check_listed(snapshot, snapshot.roaming_entities);
+
+    // Replaced by those of the snapshot
+    const auto transient = collect_entities<FighterComponent,
+                                            BillboardComponent,
+                                            SplineComponent,
+                                            SoundEffectComponent>(registry);
+    check_available(registry, snapshot.entities, transient);
+
+    registry.destroy(transient.begin(), transient.end());
+    for (const auto entity : snapshot.entities)
+    {
+        if (!registry.valid(entity))
+        {
+            registry.create(entity);
+        }
+    }
+
+    load_pool(registry, snapshot.motion_states);
+    load_pool(registry, snapshot.previous_poses);
+    load_pool(registry, snapshot.healths);
+    load_pool(registry, snapshot.collision_filters);
+    load_pool(registry, snapshot.billboards);
+
+    for (std::size_t i = snapshot.spline_entities.size(); i-- > 0;)
+    {
+        const auto& C = snapshot.spline_control_points[i];
+        registry.emplace<SplineComponent>(
+            snapshot.spline_entities[i],
+            geometry::CubicBezierCurve(C.row(0), C.row(1), C.row(2), C.row(3)));
+    }
+
+    // One collision shape per model, copied into all of its fighters
+    std::unordered_map<entt::id_type, geometry::CollisionShape> shapes;
+    for (std::size_t i = snapshot.fighter_entities.size(); i-- > 0;)
+    {
+        const auto& record = snapshot.fighter_records[i];
+        const auto& model = snapshot.models.at(record.model);
+        auto shape = shapes.find(record.model);
+        if (shape == shapes.end())
+        {
+            shape = shapes
+                        .emplace(record.model,
+                                 geometry::CollisionShape(-model->dimensions / 2.0f,
+                                                          model->dimensions / 2.0f))
+                        .first;
+        }
+
+        auto& fighter = registry.emplace<FighterComponent>(
+            snapshot.fighter_entities[i],
+            snapshot.fighter_names.substr(record.name_begin, record.name_size),
+            model,
+            shape->second,
+            !scene.headless);
+        fighter.input.set_actions(urdf::FighterInput::Actions(record.actions));
+        fighter.current_fire_mode = record.current_fire_mode;
+        fighter.current_spawn_idx = record.current_spawn_idx;
+        fighter.last_fired_time = record.last_fired_time;
+        if (!std::isnan(record.time_of_death))
+        {
+            fighter.time_of_death = record.time_of_death;
+        }
+
+        if (!scene.headless)
+        {
+            scene.emplace_visual(snapshot.fighter_entities[i], model->visual_name);
+        }
+    }
+
+    registry.clear<RoamingStateMachineComponent>();
+    for (auto entity = snapshot.roaming_entities.rbegin();
+         entity != snapshot.roaming_entities.rend();
+         ++entity)
+    {
+        registry.emplace<RoamingStateMachineComponent>(
+            *entity, std::make_shared<sm::RoamingStateMachineContext>());
+    }
+
+    scene.lasers.clear();
+    for (const auto& laser : snapshot.lasers)
+    {
+        scene.lasers.insert(laser);
+    }
+
+    scene.player_uid = snapshot.header.player_uid;
+    scene.camera_uid = snapshot.header.camera_uid;
+
+    return snapshot.header.t;
+}
+}  // namespace ecs
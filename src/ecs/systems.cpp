@@ -1,9 +1,16 @@
+#include <algorithm>
+
 #include <GL/glew.h>
 
 #include "rendering/draw.h"
+#include "geometry/broadphase.h"
+#include "geometry/ccd.h"
 #include "geometry/collision.h"
+#include "geometry/motion_state_arrays.h"
 #include "ecs/components.h"
 #include "ecs/systems.h"
+#include "jobs/thread_pool.h"
+#include "profiling/profiler.h"
 
 namespace
 {
@@ -20,21 +27,127 @@ static const Eigen::Matrix4f T_opengl_ros = []() {
     return out;
 }();
 
+// Splits the entities of a view into chunks across the thread pool and calls
+// fn(entities, begin, end) for each. Only for per-entity updates that neither read other entities
+// nor add/remove components.
+template <typename View, typename Fn>
+void parallel_chunks(jobs::ThreadPool& thread_pool, const View& view, Fn&& fn)
+{
+    // Reused across ticks. Referenced (not captured by name) since workers have their own copy.
+    static thread_local std::vector<entt::entity> entities_storage;
+    auto& entities = entities_storage;
+    entities.assign(view.begin(), view.end());
+
+    thread_pool.parallel_for(
+        entities.size(), 64, [&entities, &fn](const std::size_t begin, const std::size_t end) {
+            AWING_TRACE_SCOPE("parallel_chunk");
+            fn(entities, begin, end);
+        });
+}
+
+// As parallel_chunks, but calls fn(entity) for every entity
+template <typename View, typename Fn>
+void parallel_each(jobs::ThreadPool& thread_pool, const View& view, Fn&& fn)
+{
+    parallel_chunks(thread_pool,
+                    view,
+                    [&fn](const std::vector<entt::entity>& entities,
+                          const std::size_t begin,
+                          const std::size_t end) {
+                        for (auto i = begin; i < end; ++i)
+                        {
+                            fn(entities[i]);
+                        }
+                    });
+}
+
+// Capital ships without a team collide with everything
+CollisionFilterComponent get_collision_filter(const entt::registry& registry,
+                                              const entt::entity entity)
+{
+    const auto* filter = registry.try_get<CollisionFilterComponent>(entity);
+    return filter ? *filter : CollisionFilterComponent();
+}
+
+// A laser's swept segment over the last tick, along its direction from its current position
+float laser_tmin(const ecs::ProjectileStore::Projectile& laser, const float dt)
+{
+    return -laser.length / 2.0f - laser.speed * dt;
+}
+
+float laser_tmax(const ecs::ProjectileStore::Projectile& laser)
+{
+    return laser.length / 2.0f;
+}
+
+// The closest part of a capital ship's collision model a laser hit, if entity isn't null
+struct HullHit
+{
+    entt::entity entity;
+    std::size_t leaf;
+    float t;
+};
+
+// A fighter's impact with another fighter or with a part of a capital ship, at fraction s of the
+// tick
+struct Impact
+{
+    float s;
+    entt::entity fighter;
+    entt::entity other;
+    Eigen::Vector3f normal;           // In world, from the fighter towards the other
+    std::optional<std::size_t> leaf;  // The part hit, if the other is a capital ship
+    bool contact;  // See geometry::TimeOfImpact::contact
+};
+
+// Reused across ticks by sweep_collisions
+struct SweepScratch
+{
+    std::vector<std::uint32_t> candidates;
+    std::vector<std::uint32_t> leaves;
+    std::vector<Impact> impacts;
+    std::vector<entt::entity> stopped;
+};
+
+geometry::Sweep make_sweep(const PreviousPoseComponent& previous,
+                           const MotionStateComponent& motion)
+{
+    return geometry::Sweep{
+        previous.position, previous.orientation, motion.position, motion.orientation
+    };
+}
+
+// Radius of the sphere around the fighter frame holding its box
+float fighter_radius(const FighterComponent& fighter)
+{
+    return fighter.model->dimensions.norm() / 2.0f;
+}
+
+// Reused across ticks by detect_collisions
+struct LaserHitScratch
+{
+    std::vector<std::uint32_t> candidates;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> pairs;  // (fighter id, laser index)
+    std::vector<Eigen::Vector3f> positions;                      // Per laser
+    std::vector<entt::entity> targets;                           // Per laser, the fighter it hit
+    std::vector<HullHit> hull_hits;                              // Per laser
+    geometry::RayBatch rays;
+    std::vector<std::uint64_t> hit_mask;
+};
+
 void render_visual(const rendering::ShaderProgram& shader_program,
-                   const VisualComponent& visual_component,
+                   const ecs::RenderSnapshot& snapshot,
+                   const ecs::RenderSnapshot::Visual& visual,
                    const Eigen::Isometry3f& pose)
 {
-    shader_program.setUniformMatrix4fv("model_scale",
-                                       visual_component.size ?
-                                           geometry::to_scale_matrix(*visual_component.size) :
-                                           Eigen::Matrix4f::Identity());
+    shader_program.setUniformMatrix4fv("model_scale", visual.scale);
 
-    const auto& meshes = visual_component.model->get_meshes();
+    const auto& meshes = visual.model->get_meshes();
     for (std::size_t i = 0; i < meshes.size(); ++i)
     {
         if (meshes[i].has_texture())
         {
-            if (!visual_component.textures)
+            if (!visual.textures_begin)
             {
                 throw std::runtime_error("Mesh has texture, but no textures were provided");
             }
@@ -42,7 +155,7 @@ void render_visual(const rendering::ShaderProgram& shader_program,
             rendering::draw_textured(shader_program,
                                      meshes[i],
                                      pose,
-                                     *visual_component.textures.value()[i],  // FIXME
+                                     *snapshot.textures[*visual.textures_begin + i],  // FIXME
                                      GL_TRIANGLES);
         }
         else
@@ -50,37 +163,154 @@ void render_visual(const rendering::ShaderProgram& shader_program,
             rendering::draw_colored(shader_program,
                                     meshes[i],
                                     pose,
-                                    visual_component.color ? *visual_component.color :
-                                                             Eigen::Vector3f::Ones(),
+                                    visual.color ? *visual.color : Eigen::Vector3f::Ones(),
                                     GL_TRIANGLES);
         }
     }
 }
+
+// The motion of an entity over the last tick, from its previous pose if it keeps one
+ecs::RenderSnapshot::Motion get_motion(const entt::registry& registry,
+                                       const entt::entity entity,
+                                       const MotionStateComponent& motion_state)
+{
+    const auto end = ecs::RenderSnapshot::Pose{ motion_state.position, motion_state.orientation };
+    if (const auto* previous_pose = registry.try_get<PreviousPoseComponent>(entity))
+    {
+        return ecs::RenderSnapshot::Motion{
+            { previous_pose->position, previous_pose->orientation }, end
+        };
+    }
+    return ecs::RenderSnapshot::Motion{ end, end };
+}
+
+ecs::RenderSnapshot::Pose to_pose(const Eigen::Isometry3f& pose)
+{
+    return ecs::RenderSnapshot::Pose{ pose.translation(), Eigen::Quaternionf(pose.linear()) };
+}
+
+template <typename Component>
+void add_pool_size(const ecs::Scene& scene, const char* name, ecs::RenderSnapshot& snapshot)
+{
+    snapshot.pool_sizes.emplace_back(name, scene.registry.view<Component>().size());
+}
 }  // namespace
 
 namespace ecs::systems
 {
-void render(const Scene& scene, const float t)
+void publish_snapshot(const Scene& scene, const float t, const float dt, RenderSnapshot& snapshot)
 {
-    const auto& resource_manager = scene.resource_manager;
-    const auto& camera = scene.registry.get<MotionStateComponent>(scene.camera_uid);
-    const Eigen::Matrix4f camera_matrix = camera.pose().matrix().inverse();
+    AWING_PROFILE_SCOPE("publish_snapshot");
 
-    glEnable(GL_CULL_FACE);
-    glDisable(GL_DEPTH_TEST);
+    snapshot.t = t;
+    snapshot.dt = dt;
+    snapshot.published_at = std::chrono::steady_clock::now();
+
+    const auto& registry = scene.registry;
+    snapshot.camera = get_motion(
+        registry, scene.camera_uid, registry.get<MotionStateComponent>(scene.camera_uid));
+
+    snapshot.visuals.clear();
+    snapshot.textures.clear();
+    for (const auto [entity, motion_state, visual_component] :
+         registry.view<MotionStateComponent, VisualComponent>().each())
+    {
+        auto textures_begin = std::optional<std::size_t>();
+        if (visual_component.textures)
+        {
+            textures_begin = snapshot.textures.size();
+            for (const auto& texture : *visual_component.textures)
+            {
+                snapshot.textures.push_back(&*texture);
+            }
+        }
+
+        snapshot.visuals.push_back(RenderSnapshot::Visual{
+            get_motion(registry, entity, motion_state),
+            &*visual_component.model,
+            visual_component.size ? geometry::to_scale_matrix(*visual_component.size) :
+                                    Eigen::Matrix4f::Identity(),
+            textures_begin,
+            visual_component.color });
+    }
 
-    const auto& shader_skybox = *resource_manager.get_shader("skybox");
-    shader_skybox.use();
-    shader_skybox.setUniformMatrix4fv("camera", T_opengl_ros * camera_matrix);
+    // Lasers move in straight lines, so where they were at the start of the tick is exact
+    snapshot.lasers.clear();
+    for (const auto& laser : scene.lasers)
+    {
+        const auto& laser_info = laser.fighter_model->laser_info;
+        snapshot.lasers.push_back(
+            RenderSnapshot::Laser{ { to_pose(laser.pose(t - dt)), to_pose(laser.pose(t)) },
+                                   geometry::to_scale_matrix(laser_info.size),
+                                   laser_info.color });
+    }
+
+    snapshot.billboards.clear();
+    for (const auto [entity, motion_state, billboard_component] :
+         registry.view<MotionStateComponent, BillboardComponent>().each())
+    {
+        snapshot.billboards.push_back(
+            RenderSnapshot::Billboard{ get_motion(registry, entity, motion_state),
+                                       billboard_component.size,
+                                       billboard_component.birth_time });
+    }
+
+    snapshot.skyboxes.clear();
+    for (const auto [entity, skybox_component] : registry.view<SkyboxComponent>().each())
+    {
+        std::ignore = entity;
+        snapshot.skyboxes.push_back(
+            RenderSnapshot::Skybox{ &*skybox_component.model, &*skybox_component.texture });
+    }
 
-    for (const auto [entity, skybox_component] : scene.registry.view<SkyboxComponent>().each())
+    snapshot.splines.clear();
+    for (const auto [entity, spline_component] : registry.view<SplineComponent>().each())
     {
         std::ignore = entity;
-        rendering::draw_textured(shader_skybox,
-                                 skybox_component.model->get_meshes()[0],
-                                 Eigen::Isometry3f::Identity(),
-                                 *skybox_component.texture,
-                                 GL_TRIANGLES);
+        snapshot.splines.push_back(spline_component.curve.C);
+    }
+
+    snapshot.pool_sizes.clear();
+    add_pool_size<MotionStateComponent>(scene, "MotionState", snapshot);
+    add_pool_size<FighterComponent>(scene, "Fighter", snapshot);
+    add_pool_size<HealthComponent>(scene, "Health", snapshot);
+    snapshot.pool_sizes.emplace_back("Lasers (ProjectileStore)", scene.lasers.size());
+    add_pool_size<VisualComponent>(scene, "Visual", snapshot);
+    add_pool_size<BillboardComponent>(scene, "Billboard", snapshot);
+    add_pool_size<SoundEffectComponent>(scene, "SoundEffect", snapshot);
+    add_pool_size<CameraComponent>(scene, "Camera", snapshot);
+    add_pool_size<SkyboxComponent>(scene, "Skybox", snapshot);
+    add_pool_size<SplineComponent>(scene, "Spline", snapshot);
+    add_pool_size<RoamingStateMachineComponent>(scene, "RoamingStateMachine", snapshot);
+}
+
+void render(const RenderSnapshot& snapshot,
+            const ResourceManager& resource_manager,
+            const float alpha)
+{
+    AWING_PROFILE_SCOPE("render");
+
+    const float t = snapshot.time(alpha);
+    const Eigen::Matrix4f camera_matrix = snapshot.camera.pose(alpha).matrix().inverse();
+
+    glEnable(GL_CULL_FACE);
+    glDisable(GL_DEPTH_TEST);
+
+    {
+        AWING_PROFILE_SCOPE("render_skybox");
+
+        const auto& shader_skybox = *resource_manager.get_shader("skybox");
+        shader_skybox.use();
+        shader_skybox.setUniformMatrix4fv("camera", T_opengl_ros * camera_matrix);
+
+        for (const auto& skybox : snapshot.skyboxes)
+        {
+            rendering::draw_textured(shader_skybox,
+                                     skybox.model->get_meshes()[0],
+                                     Eigen::Isometry3f::Identity(),
+                                     *skybox.texture,
+                                     GL_TRIANGLES);
+        }
     }
 
     glEnable(GL_DEPTH_TEST);
@@ -88,55 +318,193 @@ void render(const Scene& scene, const float t)
 
     const auto& shader_model = *resource_manager.get_shader("model");
 
-    shader_model.use();
-    shader_model.setUniformMatrix4fv("camera", T_opengl_ros * camera_matrix);
+    {
+        AWING_PROFILE_SCOPE("render_visuals");
+
+        shader_model.use();
+        shader_model.setUniformMatrix4fv("camera", T_opengl_ros * camera_matrix);
+
+        for (const auto& visual : snapshot.visuals)
+        {
+            render_visual(shader_model, snapshot, visual, visual.motion.pose(alpha));
+        }
+    }
 
-    for (const auto [entity, motion_state, visual_component] :
-         scene.registry.view<MotionStateComponent, VisualComponent>().each())
     {
-        std::ignore = entity;
-        render_visual(shader_model, visual_component, motion_state.pose());
+        AWING_PROFILE_SCOPE("render_lasers");
+
+        const auto& box_mesh = resource_manager.get_model("box")->get_meshes()[0];
+        for (const auto& laser : snapshot.lasers)
+        {
+            shader_model.setUniformMatrix4fv("model_scale", laser.scale);
+            rendering::draw_colored(
+                shader_model, box_mesh, laser.motion.pose(alpha), laser.color, GL_TRIANGLES);
+        }
     }
 
-    const auto& shader_spark = *resource_manager.get_shader("spark");
+    {
+        AWING_PROFILE_SCOPE("render_billboards");
 
-    shader_spark.use();
-    shader_model.setUniformMatrix4fv("camera", T_opengl_ros * camera_matrix);
-    shader_spark.setUniform1f("time", t);
-    glEnable(GL_BLEND);
-    glDepthMask(false);
+        const auto& shader_spark = *resource_manager.get_shader("spark");
+
+        shader_spark.use();
+        shader_model.setUniformMatrix4fv("camera", T_opengl_ros * camera_matrix);
+        shader_spark.setUniform1f("time", t);
+        glEnable(GL_BLEND);
+        glDepthMask(false);
+
+        const auto& quad_mesh = resource_manager.get_model("quad")->get_meshes()[0];
+        for (const auto& billboard : snapshot.billboards)
+        {
+            shader_spark.setUniformMatrix4fv("model_scale", billboard.scale);
+            shader_spark.setUniform1f("start_time", billboard.birth_time);
+            rendering::draw_colored(shader_spark,
+                                    quad_mesh,
+                                    billboard.motion.pose(alpha),
+                                    Eigen::Vector3f(0.0f, 0.0f, 1.0f),
+                                    GL_TRIANGLES);
+        }
+
+        glDepthMask(true);
+        glDisable(GL_BLEND);
+    }
 
-    const auto& quad_mesh = scene.resource_manager.get_model("quad")->get_meshes()[0];
-    for (const auto [entity, motion_state, billboard_component] :
-         scene.registry.view<MotionStateComponent, BillboardComponent>().each())
     {
-        std::ignore = entity;
-        shader_spark.setUniformMatrix4fv("model_scale", billboard_component.size);
-        shader_spark.setUniform1f("start_time", billboard_component.birth_time);
-        rendering::draw_colored(shader_spark,
-                                quad_mesh,
-                                motion_state.pose(),
-                                Eigen::Vector3f(0.0f, 0.0f, 1.0f),
-                                GL_TRIANGLES);
+        AWING_PROFILE_SCOPE("render_splines");
+
+        const auto& shader_spline = *resource_manager.get_shader("spline");
+        shader_spline.use();
+        shader_spline.setUniformMatrix4fv("camera", T_opengl_ros * camera_matrix);
+
+        for (const auto& control_points : snapshot.splines)
+        {
+            shader_spline.setUniformMatrix3x4fv("C", control_points);
+            glDrawArrays(GL_POINTS, 0, 1);
+        }
     }
+}
+
+void render(const Scene& scene, const float t)
+{
+    static thread_local RenderSnapshot snapshot;
+    publish_snapshot(scene, t, 0.0f, snapshot);
+    render(snapshot, scene.resource_manager, 1.0f);
+}
+
+namespace
+{
+template <typename... Components>
+void create_storage(entt::registry& registry)
+{
+    (static_cast<void>(registry.storage<Components>()), ...);
+}
+
+// The phases of a tick, added in the order they would run one after the other
+void add_systems(Scene& scene)
+{
+    // Views create the storage of their components on first use, which must not happen while
+    // other systems are iterating theirs
+    create_storage<MotionStateComponent,
+                   PreviousPoseComponent,
+                   FighterComponent,
+                   HealthComponent,
+                   CameraComponent,
+                   ActorComponent,
+                   CollisionComponent,
+                   CollisionFilterComponent,
+                   SoundEffectComponent,
+                   BillboardComponent>(scene.registry);
 
-    glDepthMask(true);
-    glDisable(GL_BLEND);
+    auto& scheduler = scene.scheduler;
+    scheduler.add(
+        "update_camera",
+        [](Scene& scene, CommandBuffer&, float, float dt) { update_camera(scene, dt); },
+        Reads<FighterComponent, CameraComponent>(),
+        Writes<MotionStateComponent, control::CameraController, audio::AudioContextManager>());
+    scheduler.add(
+        "integrate_motion",
+        [](Scene& scene, CommandBuffer&, float, float dt) { integrate_motion(scene, dt); },
+        Reads<>(),
+        Writes<MotionStateComponent, PreviousPoseComponent, geometry::MotionStateArrays>(),
+        true);
+    scheduler.add(
+        "sweep_collisions",
+        [](Scene& scene, CommandBuffer&, float, float) { sweep_collisions(scene); },
+        Reads<FighterComponent,
+              PreviousPoseComponent,
+              CollisionFilterComponent,
+              ActorComponent,
+              CollisionComponent>(),
+        Writes<MotionStateComponent, geometry::UniformGrid>());
+    scheduler.add("update_fighters",
+                  [](Scene& scene, CommandBuffer& commands, float t, float) {
+                      update_fighters(scene, commands, t);
+                  },
+                  Reads<MotionStateComponent>(),
+                  Writes<FighterComponent, audio::AudioContextManager>());
+    scheduler.add(
+        "control_fighters",
+        [](Scene& scene, CommandBuffer&, float, float dt) { control_fighters(scene, dt); },
+        Reads<FighterComponent, control::ShipController>(),
+        Writes<MotionStateComponent>(),
+        true);
+    scheduler.add("detect_collisions",
+                  [](Scene& scene, CommandBuffer& commands, float t, float dt) {
+                      detect_collisions(scene, commands, t, dt);
+                  },
+                  Reads<geometry::UniformGrid,
+                        ActorComponent,
+                        CollisionComponent,
+                        CollisionFilterComponent>(),
+                  Writes<FighterComponent,
+                         MotionStateComponent,
+                         HealthComponent,
+                         ProjectileStore>());
+    scheduler.add("expire_lasers",
+                  [](Scene& scene, CommandBuffer&, float t, float) { expire_lasers(scene, t); },
+                  Reads<>(),
+                  Writes<ProjectileStore>());
+    scheduler.add("remove_finished_sound_effects",
+                  [](Scene& scene, CommandBuffer& commands, float, float) {
+                      remove_finished_sound_effects(scene, commands);
+                  },
+                  Reads<SoundEffectComponent, audio::AudioContextManager>(),
+                  Writes<>());
+    scheduler.add("expire_billboards",
+                  [](Scene& scene, CommandBuffer& commands, float t, float) {
+                      expire_billboards(scene, commands, t);
+                  },
+                  Reads<BillboardComponent>(),
+                  Writes<>());
+}
+}  // namespace
+
+void integrate(Scene& scene, const float t, const float dt)
+{
+    AWING_PROFILE_SCOPE("integrate");
+
+    if (scene.scheduler.empty())
+    {
+        add_systems(scene);
+    }
 
-    const auto& shader_spline = *resource_manager.get_shader("spline");
-    shader_spline.use();
-    shader_spline.setUniformMatrix4fv("camera", T_opengl_ros * camera_matrix);
+    // Then the sync point: spawn fired lasers, explosions and impacts, remove destroyed ships,
+    // finished sound effects and expired billboards
+    scene.scheduler.run(scene, t, dt);
 
-    for (const auto [entity, spline_component] : scene.registry.view<SplineComponent>().each())
+    if (!scene.headless)
     {
-        shader_spline.setUniformMatrix3x4fv("C", spline_component.curve.C);
-        glDrawArrays(GL_POINTS, 0, 1);
+        audio::AudioContextManager::update();
     }
 }
 
-void integrate(Scene& scene, const float t, const float dt)
+void update_camera(Scene& scene, const float dt)
 {
-    // Update Camera: Invoke camera controller, (update linear/angular acceleration)
+    AWING_PROFILE_SCOPE("update_camera");
+
+    const bool audio_enabled = !scene.headless;
+
+    // Invoke camera controller, (update linear/angular acceleration)
     if (scene.player_uid != entt::null)
     {
         auto fighter_motion_state = scene.registry.try_get<MotionStateComponent>(scene.player_uid);
@@ -154,21 +522,244 @@ void integrate(Scene& scene, const float t, const float dt)
                                                       fighter_component->model->camera_poses[1]),
                     dt);
 
-                audio::AudioContextManager::set_listener_pose(T_opengl_ros *
-                                                              camera_motion_state.pose().matrix());
+                if (audio_enabled)
+                {
+                    audio::AudioContextManager::set_listener_pose(
+                        T_opengl_ros * camera_motion_state.pose().matrix());
+                }
             }
         }
     }
+}
+
+void integrate_motion(Scene& scene, const float dt)
+{
+    AWING_PROFILE_SCOPE("integrate_motion");
 
-    // Integrate all MotionStateComponents
-    for (auto [entity, motion_state] : scene.registry.view<MotionStateComponent>().each())
+    for (auto [entity, previous_pose, motion_state] :
+         scene.registry.view<PreviousPoseComponent, MotionStateComponent>().each())
     {
         std::ignore = entity;
-        motion_state.integrate(dt);
+        previous_pose = PreviousPoseComponent{ motion_state.position, motion_state.orientation };
+    }
+
+    // Integrate all MotionStateComponents, 8 at a time through their SoA copies
+    auto motion_view = scene.registry.view<MotionStateComponent>();
+    auto& motion_arrays = scene.motion_state_arrays;
+    auto integrate_chunk = [&motion_view, &motion_arrays, dt](
+                               const std::vector<entt::entity>& entities,
+                               const std::size_t begin,
+                               const std::size_t end) {
+        for (auto i = begin; i < end; ++i)
+        {
+            motion_arrays.load(i, motion_view.get<MotionStateComponent>(entities[i]));
+        }
+        motion_arrays.integrate(dt, begin, end);
+        for (auto i = begin; i < end; ++i)
+        {
+            motion_arrays.store(i, motion_view.get<MotionStateComponent>(entities[i]));
+        }
+    };
+    motion_arrays.resize(motion_view.size());
+    parallel_chunks(scene.thread_pool, motion_view, integrate_chunk);
+}
+
+void sweep_collisions(Scene& scene)
+{
+    AWING_PROFILE_SCOPE("sweep_collisions");
+
+    // At up to 1300 m/s, fighters move further than their own length in a tick. So they are
+    // swept from their poses at the start of the tick to those at the end, to catch impacts
+    // that testing only the end poses would tunnel through.
+    auto fighter_view =
+        scene.registry.view<FighterComponent, MotionStateComponent, PreviousPoseComponent>();
+
+    // Broadphase: fighters by the volume they swept. detect_collisions() reuses the grid.
+    scene.fighter_grid.clear();
+    for (auto [fighter_entity, fighter_component, fighter_motion, previous_pose] :
+         fighter_view.each())
+    {
+        const auto [min, max] = geometry::swept_aabb(make_sweep(previous_pose, fighter_motion),
+                                                     fighter_radius(fighter_component));
+        scene.fighter_grid.insert(entt::to_integral(fighter_entity), min, max);
+    }
+    scene.fighter_grid.build();
+
+    static thread_local SweepScratch scratch;
+    scratch.impacts.clear();
+
+    // Fighters against fighters, each candidate pair once
+    for (auto [fighter_entity, fighter_component, fighter_motion, previous_pose] :
+         fighter_view.each())
+    {
+        const auto sweep = make_sweep(previous_pose, fighter_motion);
+        const auto [min, max] = geometry::swept_aabb(sweep, fighter_radius(fighter_component));
+
+        scratch.candidates.clear();
+        scene.fighter_grid.query_aabb(min, max, scratch.candidates);
+        const auto& filter = scene.registry.get<CollisionFilterComponent>(fighter_entity);
+        for (const auto id : scratch.candidates)
+        {
+            const auto other_entity = static_cast<entt::entity>(id);
+            if (id <= entt::to_integral(fighter_entity) ||
+                !filter.collides_with(scene.registry.get<CollisionFilterComponent>(other_entity)))
+            {
+                continue;
+            }
+
+            const auto& [other_component, other_motion, other_previous_pose] =
+                fighter_view.get<FighterComponent, MotionStateComponent, PreviousPoseComponent>(
+                    other_entity);
+            auto simplex = geometry::GjkSimplex();
+            if (const auto impact =
+                    geometry::time_of_impact(fighter_component.collision_shape,
+                                             sweep,
+                                             other_component.collision_shape,
+                                             make_sweep(other_previous_pose, other_motion),
+                                             simplex))
+            {
+                scratch.impacts.push_back(Impact{ impact->s,
+                                                  fighter_entity,
+                                                  other_entity,
+                                                  impact->normal,
+                                                  {},
+                                                  impact->contact });
+            }
+        }
+    }
+
+    // Fighters against the parts of capital ships that their swept volume overlaps, keeping the
+    // earliest impact per ship
+    auto hull_view = scene.registry.view<ActorComponent,
+                                         CollisionComponent,
+                                         MotionStateComponent,
+                                         PreviousPoseComponent>();
+    for (const auto [hull_entity, actor_component, collision_component, hull_motion, hull_pose] :
+         hull_view.each())
+    {
+        std::ignore = actor_component;
+        const auto& bvh = *collision_component.bvh;
+        const auto hull_filter = get_collision_filter(scene.registry, hull_entity);
+        const auto hull_sweep = make_sweep(hull_pose, hull_motion);
+        const Eigen::Isometry3f T_hull_world_start = hull_sweep.pose(0.0f).inverse();
+        const Eigen::Isometry3f T_hull_world_end = hull_sweep.pose(1.0f).inverse();
+
+        for (auto [fighter_entity, fighter_component, fighter_motion, previous_pose] :
+             fighter_view.each())
+        {
+            if (!hull_filter.collides_with(
+                    scene.registry.get<CollisionFilterComponent>(fighter_entity)))
+            {
+                continue;
+            }
+
+            const auto sweep = make_sweep(previous_pose, fighter_motion);
+            const auto radius = Eigen::Vector3f::Constant(fighter_radius(fighter_component));
+            const Eigen::Vector3f start = T_hull_world_start * sweep.start_position;
+            const Eigen::Vector3f end = T_hull_world_end * sweep.end_position;
+
+            scratch.leaves.clear();
+            bvh.query_aabb(Eigen::AlignedBox3f(start.cwiseMin(end) - radius,
+                                               start.cwiseMax(end) + radius),
+                           scratch.leaves);
+
+            auto earliest = std::optional<Impact>();
+            for (const auto leaf : scratch.leaves)
+            {
+                auto simplex = geometry::GjkSimplex();
+                const auto impact = geometry::time_of_impact(fighter_component.collision_shape,
+                                                             sweep,
+                                                             bvh.get_leaves()[leaf].shape,
+                                                             hull_sweep,
+                                                             simplex);
+                if (impact && (!earliest || impact->s < earliest->s))
+                {
+                    earliest = Impact{ impact->s,
+                                       fighter_entity,
+                                       hull_entity,
+                                       impact->normal,
+                                       leaf,
+                                       impact->contact };
+                }
+            }
+            if (earliest)
+            {
+                scratch.impacts.push_back(*earliest);
+            }
+        }
+    }
+
+    // React to the earliest impacts first. A fighter is stopped at its first impact; any later
+    // one was against where it would have been had it not stopped, so is dropped.
+    std::sort(scratch.impacts.begin(), scratch.impacts.end(), [](const auto& lhs, const auto& rhs) {
+        return std::tie(lhs.s, lhs.fighter, lhs.other) < std::tie(rhs.s, rhs.fighter, rhs.other);
+    });
+    scratch.stopped.clear();
+    auto stopped = [](const entt::entity entity) {
+        return std::find(scratch.stopped.begin(), scratch.stopped.end(), entity) !=
+               scratch.stopped.end();
+    };
+
+    for (const auto& impact : scratch.impacts)
+    {
+        const bool other_is_fighter = !impact.leaf;
+        if (stopped(impact.fighter) || (other_is_fighter && stopped(impact.other)))
+        {
+            continue;
+        }
+
+        // Moves a fighter back to where it was at the impact
+        auto stop = [&](const entt::entity entity) {
+            auto [motion, previous_pose] =
+                fighter_view.get<MotionStateComponent, PreviousPoseComponent>(entity);
+            const auto pose = make_sweep(previous_pose, motion).pose(impact.s);
+            motion.position = pose.translation();
+            motion.orientation = Eigen::Quaternionf(pose.linear());
+            scratch.stopped.push_back(entity);
+        };
+
+        auto& fighter_motion = fighter_view.get<MotionStateComponent>(impact.fighter);
+        stop(impact.fighter);
+
+        // Not known to have touched, so only kept from passing through each other
+        if (!impact.contact)
+        {
+            if (other_is_fighter)
+            {
+                stop(impact.other);
+            }
+            continue;
+        }
+
+        // Take out the velocity closing the gap: shared between two fighters, all of it for
+        // the fighter against the much heavier capital ship
+        const auto& other_motion = scene.registry.get<MotionStateComponent>(impact.other);
+        const float closing = (fighter_motion.velocity - other_motion.velocity).dot(impact.normal);
+
+        if (other_is_fighter)
+        {
+            auto& other_velocity = fighter_view.get<MotionStateComponent>(impact.other).velocity;
+            stop(impact.other);
+            if (closing > 0.0f)
+            {
+                fighter_motion.velocity -= impact.normal * (closing / 2.0f);
+                other_velocity += impact.normal * (closing / 2.0f);
+            }
+        }
+        else if (closing > 0.0f)
+        {
+            fighter_motion.velocity -= impact.normal * closing;
+        }
     }
+}
 
-    // Update Fighters (invoke controller, react to controls) ...
-    std::set<entt::entity> to_remove;
+void update_fighters(Scene& scene, CommandBuffer& commands, const float t)
+{
+    AWING_PROFILE_SCOPE("update_fighters");
+
+    const bool audio_enabled = !scene.headless;
+
+    // Fire lasers, react to controls and handle dead fighters
     for (auto [entity, fighter_component, motion_state] :
          scene.registry.view<FighterComponent, MotionStateComponent>().each())
     {
@@ -179,15 +770,15 @@ void integrate(Scene& scene, const float t, const float dt)
                 for (const auto& dispatch : *dispatches)
                 {
                     auto laser_pose = motion_state.pose() * dispatch.first;
-                    scene.register_laser(Eigen::Vector3f(laser_pose.translation()),
-                                         Eigen::Quaternionf(laser_pose.linear()),
-                                         fighter_component.model,
-                                         dispatch.second.size,
-                                         dispatch.second.color,
-                                         dispatch.second.speed,
-                                         entity);
-
-                    if (!fighter_component.model->sounds.laser.empty())
+                    commands.spawn([position = Eigen::Vector3f(laser_pose.translation()),
+                                    orientation = Eigen::Quaternionf(laser_pose.linear()),
+                                    model = fighter_component.model,
+                                    t,
+                                    entity](Scene& scene) {
+                        scene.register_laser(position, orientation, model, t, entity);
+                    });
+
+                    if (audio_enabled && !fighter_component.model->sounds.laser.empty())
                     {
                         fighter_component.fire_sound_source->play(*scene.resource_manager.get_sound(
                             fighter_component.model->sounds.laser));
@@ -195,23 +786,22 @@ void integrate(Scene& scene, const float t, const float dt)
                 }
             }
 
-            if (!fighter_component.model->sounds.engine.empty() &&
-                !fighter_component.engine_sound_source->is_playing())
+            if (audio_enabled)
             {
-                fighter_component.engine_sound_source->play(
-                    *scene.resource_manager.get_sound(fighter_component.model->sounds.engine));
-            }
+                if (!fighter_component.model->sounds.engine.empty() &&
+                    !fighter_component.engine_sound_source->is_playing())
+                {
+                    fighter_component.engine_sound_source->play(
+                        *scene.resource_manager.get_sound(fighter_component.model->sounds.engine));
+                }
 
-            fighter_component.fire_sound_source->set_pose(T_opengl_ros *
-                                                          motion_state.pose().matrix());
-            fighter_component.engine_sound_source->set_pose(T_opengl_ros *
-                                                            motion_state.pose().matrix());
+                fighter_component.fire_sound_source->set_pose(T_opengl_ros *
+                                                              motion_state.pose().matrix());
+                fighter_component.engine_sound_source->set_pose(T_opengl_ros *
+                                                                motion_state.pose().matrix());
+            }
 
             fighter_component.try_toggle_fire_mode();
-
-            motion_state = scene.ship_controller.update(
-                motion_state, fighter_component.get_target_state(motion_state), dt);
-            fighter_component.model->apply_motion_limits(motion_state);
         }
         else
         {
@@ -225,18 +815,35 @@ void integrate(Scene& scene, const float t, const float dt)
 
                 for (const auto& offset : offsets)
                 {
-                    scene.register_billboard(motion_state.position,
-                                             offset * motion_state.orientation,
-                                             { 0.0f, 60.0f, 60.0f },
-                                             2.0f,
-                                             t);
+                    const Eigen::Quaternionf orientation = offset * motion_state.orientation;
+                    commands.spawn(
+                        [position = motion_state.position, orientation, t](Scene& scene) {
+                            scene.register_billboard(
+                                position, orientation, { 0.0f, 60.0f, 60.0f }, 2.0f, t);
+                        });
                 }
-                to_remove.insert(entity);
+                commands.destroy(entity);
             }
         }
     }
-    // ... and remove destroyed ships
-    scene.registry.destroy(to_remove.begin(), to_remove.end());
+}
+
+void control_fighters(Scene& scene, const float dt)
+{
+    AWING_PROFILE_SCOPE("control_fighters");
+
+    // Invoke the flight controllers, which only touch their own fighter
+    auto fighter_control_view = scene.registry.view<FighterComponent, MotionStateComponent>();
+    parallel_each(scene.thread_pool, fighter_control_view, [&](const entt::entity entity) {
+        auto [fighter_component, motion_state] =
+            fighter_control_view.get<FighterComponent, MotionStateComponent>(entity);
+        if (fighter_component.alive())
+        {
+            motion_state = scene.ship_controller.update(
+                motion_state, fighter_component.get_target_state(motion_state), dt);
+            fighter_component.model->apply_motion_limits(motion_state);
+        }
+    });
 
     // Tick state machines
     // for (auto [entity, motion_state, state_machine_component] :
@@ -247,89 +854,224 @@ void integrate(Scene& scene, const float t, const float dt)
     //     // Poll state, create new roaming goal if necessary.
     //     if (state_machine_component.instance.isActive)
     // }
+}
 
-    // Calculate, detect and react to collisions ...
-    to_remove.clear();
+void detect_collisions(Scene& scene, CommandBuffer& commands, const float t, const float dt)
+{
+    AWING_PROFILE_SCOPE("detect_collisions");
+
+    const bool audio_enabled = !scene.headless;
+
+    // Calculate, detect and react to collisions
     auto fighter_view =
-        scene.registry.view<FighterComponent, MotionStateComponent, HealthComponent>().each();
-    auto laser_view = scene.registry.view<LaserComponent, MotionStateComponent>().each();
-    for (auto [laser_entity, laser_component, laser_motion] : laser_view)
+        scene.registry.view<FighterComponent, MotionStateComponent, HealthComponent>();
+
+    // Lasers are tested over the segment they swept during the tick. Their positions are
+    // analytic, so nothing is integrated for them beforehand.
+    static thread_local LaserHitScratch scratch;
+    auto& lasers = scene.lasers;
+
+    // Broadphase: pair every laser with the fighters sharing a cell with its swept segment, in the
+    // grid sweep_collisions() built
+    scratch.pairs.clear();
+    scratch.positions.resize(lasers.size());
+    for (std::size_t i = 0; i < lasers.size(); ++i)
     {
-        for (auto [fighter_entity, fighter_component, fighter_motion, health_component] :
-             fighter_view)
+        const auto& laser = lasers[i];
+        scratch.positions[i] = laser.position(t);
+
+        scratch.candidates.clear();
+        scene.fighter_grid.query_segment(
+            scratch.positions[i] + laser_tmin(laser, dt) * laser.direction,
+            scratch.positions[i] + laser_tmax(laser) * laser.direction,
+            scratch.candidates);
+
+        for (const auto id : scratch.candidates)
         {
-            if (laser_component.producer != fighter_entity)
+            const auto entity = static_cast<entt::entity>(id);
+            if (entity != laser.producer &&
+                (laser.mask & scene.registry.get<CollisionFilterComponent>(entity).layer))
             {
-                auto laser_speed = laser_motion.velocity.dot(laser_motion.fwd());
+                scratch.pairs.emplace_back(id, static_cast<std::uint32_t>(i));
+            }
+        }
+    }
 
-                if (geometry::ray_aabb_test(laser_motion.pose(),
-                                            laser_component.length / 2.0f,
-                                            -laser_component.length / 2.0f - laser_speed * dt,
-                                            fighter_motion.pose(),
-                                            fighter_component.model->dimensions))
-                {
-                    health_component.take_damage(laser_component.fighter_model->laser_info.damage);
-                    std::cout << "laser hit " << fighter_component.name
-                              << ". shields: " << health_component.shields
-                              << ", hull: " << health_component.hull << std::endl;
-                    if (health_component.hull <= 0 && fighter_component.alive())
-                    {
-                        fighter_component.time_of_death = t;
-                        fighter_motion.angular_velocity =
-                            fighter_motion.orientation * Eigen::Vector3f(M_PI_2, 0.0f, 0.0f);
-                    }
+    // Narrowphase: each fighter against all of its candidate lasers at once. Fighters go in id
+    // order, so a laser hitting several fighters hits the lowest id, as the broadphase lists them.
+    std::sort(scratch.pairs.begin(), scratch.pairs.end());
+    scratch.targets.assign(lasers.size(), entt::null);
+    for (auto begin = scratch.pairs.begin(); begin != scratch.pairs.end();)
+    {
+        const auto fighter_id = begin->first;
+        const auto end = std::find_if(begin, scratch.pairs.end(), [fighter_id](const auto& pair) {
+            return pair.first != fighter_id;
+        });
 
-                    auto backwards_offset = laser_motion.orientation *
-                                            Eigen::Vector3f(-laser_speed * dt, 0.0f, 0.0f) / 2.0f;
-                    auto& impact_info = laser_component.fighter_model->laser_info.impact_info;
+        scratch.rays.clear();
+        for (auto it = begin; it != end; ++it)
+        {
+            const auto& laser = lasers[it->second];
+            scratch.rays.push_back(scratch.positions[it->second],
+                                   laser.direction,
+                                   laser_tmin(laser, dt),
+                                   laser_tmax(laser));
+        }
 
-                    scene.register_billboard(laser_motion.position + backwards_offset,
-                                             laser_motion.orientation,
-                                             impact_info.size,
-                                             impact_info.duration,
-                                             t);
+        const auto fighter_entity = static_cast<entt::entity>(fighter_id);
+        const auto& [fighter_component, fighter_motion] =
+            fighter_view.get<FighterComponent, MotionStateComponent>(fighter_entity);
+        geometry::ray_obb_test(scratch.rays,
+                               fighter_motion.pose(),
+                               fighter_component.model->dimensions,
+                               scratch.hit_mask);
 
-                    if (!fighter_component.model->sounds.hit.empty())
-                    {
-                        scene.register_sound_effect(fighter_component.model->sounds.hit,
-                                                    fighter_motion.position,
-                                                    fighter_motion.orientation);
-                    }
+        for (auto it = begin; it != end; ++it)
+        {
+            const auto k = static_cast<std::size_t>(it - begin);
+            const bool hit = (scratch.hit_mask[k / 64] >> (k % 64)) & 1;
+            if (hit && scratch.targets[it->second] == entt::null)
+            {
+                scratch.targets[it->second] = fighter_entity;
+            }
+        }
 
-                    to_remove.insert(laser_entity);
-                    break;
-                }
+        begin = end;
+    }
+
+    // Lasers that missed every fighter against the capital ships, through their BVHs. Each keeps
+    // the closest part it hits.
+    scratch.hull_hits.assign(lasers.size(), HullHit{ entt::null, 0, 0.0f });
+    for (const auto [hull_entity, actor_component, collision_component, hull_motion] :
+         scene.registry.view<ActorComponent, CollisionComponent, MotionStateComponent>().each())
+    {
+        std::ignore = actor_component;
+        const auto& bvh = *collision_component.bvh;
+        const auto hull_layer = get_collision_filter(scene.registry, hull_entity).layer;
+        const Eigen::Isometry3f T_hull_world = hull_motion.pose().inverse();
+        for (std::size_t i = 0; i < lasers.size(); ++i)
+        {
+            if (scratch.targets[i] != entt::null || !(lasers[i].mask & hull_layer))
+            {
+                continue;
+            }
+
+            const auto& laser = lasers[i];
+            auto& hull_hit = scratch.hull_hits[i];
+            const Eigen::Vector3f origin = T_hull_world * scratch.positions[i];
+            const Eigen::Vector3f direction = T_hull_world.linear() * laser.direction;
+            const float tmax = hull_hit.entity == entt::null ? laser_tmax(laser) : hull_hit.t;
+            if (const auto hit = bvh.raycast(origin, direction, laser_tmin(laser, dt), tmax))
+            {
+                hull_hit = HullHit{ hull_entity, hit->leaf, hit->t };
             }
         }
     }
-    // ... and remove lasers that hit something
-    scene.registry.destroy(to_remove.begin(), to_remove.end());
 
-    // Check if any SoundEffects have finished playing ...
-    to_remove.clear();
+    // React to the hits in laser order
+    for (std::size_t i = 0; i < lasers.size(); ++i)
+    {
+        const auto fighter_entity = scratch.targets[i];
+        const auto& hull_hit = scratch.hull_hits[i];
+        if (fighter_entity == entt::null && hull_hit.entity == entt::null)
+        {
+            continue;
+        }
+
+        const auto& laser = lasers[i];
+        const auto& laser_info = laser.fighter_model->laser_info;
+
+        Eigen::Vector3f impact_position;
+        if (fighter_entity != entt::null)
+        {
+            auto [fighter_component, fighter_motion, health_component] =
+                fighter_view.get<FighterComponent, MotionStateComponent, HealthComponent>(
+                    fighter_entity);
+
+            health_component.take_damage(laser_info.damage);
+            std::cout << "laser hit " << fighter_component.name
+                      << ". shields: " << health_component.shields
+                      << ", hull: " << health_component.hull << std::endl;
+            if (health_component.hull <= 0 && fighter_component.alive())
+            {
+                fighter_component.time_of_death = t;
+                fighter_motion.angular_velocity =
+                    fighter_motion.orientation * Eigen::Vector3f(M_PI_2, 0.0f, 0.0f);
+            }
+
+            impact_position = scratch.positions[i] - laser.direction * (laser.speed * dt / 2.0f);
+        }
+        else
+        {
+            const auto& [actor_component, collision_component] =
+                scene.registry.get<ActorComponent, CollisionComponent>(hull_hit.entity);
+            std::cout << "laser hit " << actor_component.name << " ("
+                      << collision_component.bvh->get_leaves()[hull_hit.leaf].shape.name << ")"
+                      << std::endl;
+
+            impact_position = scratch.positions[i] + laser.direction * hull_hit.t;
+        }
+
+        const auto& impact_info = laser_info.impact_info;
+
+        commands.spawn([position = impact_position,
+                        orientation = laser.orientation,
+                        impact_info,
+                        t](Scene& scene) {
+            scene.register_billboard(
+                position, orientation, impact_info.size, impact_info.duration, t);
+        });
+
+        if (fighter_entity != entt::null && audio_enabled)
+        {
+            const auto& [fighter_component, fighter_motion] =
+                fighter_view.get<FighterComponent, MotionStateComponent>(fighter_entity);
+            if (!fighter_component.model->sounds.hit.empty())
+            {
+                commands.spawn([model = fighter_component.model,
+                                position = fighter_motion.position,
+                                orientation = fighter_motion.orientation](Scene& scene) {
+                    scene.register_sound_effect(model->sounds.hit, position, orientation);
+                });
+            }
+        }
+
+        lasers.kill(i);
+    }
+}
+
+void remove_finished_sound_effects(Scene& scene, CommandBuffer& commands)
+{
+    AWING_PROFILE_SCOPE("remove_finished_sound_effects");
+
     for (auto [entity, sound_effect_component] : scene.registry.view<SoundEffectComponent>().each())
     {
         if (!sound_effect_component.sound_source->is_playing())
         {
-            to_remove.insert(entity);
+            commands.destroy(entity);
         }
     }
-    // ... and remove those who have
-    scene.registry.destroy(to_remove.begin(), to_remove.end());
+}
+
+void expire_lasers(Scene& scene, const float t)
+{
+    AWING_PROFILE_SCOPE("expire_lasers");
+
+    // Drops the lasers that hit something this tick along with the expired ones
+    scene.lasers.compact(t);
+}
+
+void expire_billboards(Scene& scene, CommandBuffer& commands, const float t)
+{
+    AWING_PROFILE_SCOPE("expire_billboards");
 
-    // Update Billboards ...
-    to_remove.clear();
     for (auto [entity, billboard_component] : scene.registry.view<BillboardComponent>().each())
     {
         if (billboard_component.birth_time + billboard_component.duration < t)
         {
-            to_remove.insert(entity);
+            commands.destroy(entity);
         }
     }
-    // ... and remove those who have expired
-    scene.registry.destroy(to_remove.begin(), to_remove.end());
-
-    audio::AudioContextManager::update();
 }
 
 void handle_key_events(Scene& scene, const std::vector<KeyEvent>& key_events)
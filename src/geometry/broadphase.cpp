@@ -0,0 +1,175 @@
+#include "geometry/broadphase.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace geometry
+{
+namespace
+{
+void sort_unique_tail(std::vector<std::uint32_t>& out, const std::size_t first)
+{
+    std::sort(out.begin() + first, out.end());
+    out.erase(std::unique(out.begin() + first, out.end()), out.end());
+}
+}  // namespace
+
+UniformGrid::UniformGrid(const float cell_size) : cell_size(cell_size)
+{
+}
+
+void UniformGrid::clear()
+{
+    entries.clear();
+}
+
+void UniformGrid::insert(const std::uint32_t id,
+                         const Eigen::Vector3f& min,
+                         const Eigen::Vector3f& max)
+{
+    const Eigen::Vector3i lo = to_cell(min);
+    const Eigen::Vector3i hi = to_cell(max);
+
+    for (int x = lo.x(); x <= hi.x(); ++x)
+    {
+        for (int y = lo.y(); y <= hi.y(); ++y)
+        {
+            for (int z = lo.z(); z <= hi.z(); ++z)
+            {
+                entries.push_back({ to_key(Eigen::Vector3i(x, y, z)), id });
+            }
+        }
+    }
+}
+
+void UniformGrid::build()
+{
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.key < b.key || (a.key == b.key && a.id < b.id);
+    });
+}
+
+void UniformGrid::query_segment(const Eigen::Vector3f& from,
+                                const Eigen::Vector3f& to,
+                                std::vector<std::uint32_t>& out) const
+{
+    // Amanatides & Woo, "A Fast Voxel Traversal Algorithm for Ray Tracing"
+    const auto first = out.size();
+    const Eigen::Vector3f dir = to - from;
+    const Eigen::Vector3i last_cell = to_cell(to);
+    Eigen::Vector3i cell = to_cell(from);
+
+    Eigen::Vector3i step;
+    Eigen::Vector3f t_max;
+    Eigen::Vector3f t_delta;
+    for (int i = 0; i < 3; ++i)
+    {
+        if (dir(i) > 0.0f)
+        {
+            step(i) = 1;
+            t_max(i) = ((cell(i) + 1) * cell_size - from(i)) / dir(i);
+            t_delta(i) = cell_size / dir(i);
+        }
+        else if (dir(i) < 0.0f)
+        {
+            step(i) = -1;
+            t_max(i) = (cell(i) * cell_size - from(i)) / dir(i);
+            t_delta(i) = -cell_size / dir(i);
+        }
+        else
+        {
+            step(i) = 0;
+            t_max(i) = std::numeric_limits<float>::infinity();
+            t_delta(i) = std::numeric_limits<float>::infinity();
+        }
+    }
+
+    append_cell(cell, out);
+
+    const int num_steps = (last_cell - cell).cwiseAbs().sum();
+    for (int n = 0; n < num_steps; ++n)
+    {
+        int axis;
+        t_max.minCoeff(&axis);
+        cell(axis) += step(axis);
+        t_max(axis) += t_delta(axis);
+        append_cell(cell, out);
+    }
+
+    // Guard against rounding making the walk drift off the end cell
+    if (cell != last_cell)
+    {
+        append_cell(last_cell, out);
+    }
+
+    sort_unique_tail(out, first);
+}
+
+void UniformGrid::query_aabb(const Eigen::Vector3f& min,
+                             const Eigen::Vector3f& max,
+                             std::vector<std::uint32_t>& out) const
+{
+    const auto first = out.size();
+    const Eigen::Vector3i lo = to_cell(min);
+    const Eigen::Vector3i hi = to_cell(max);
+
+    for (int x = lo.x(); x <= hi.x(); ++x)
+    {
+        for (int y = lo.y(); y <= hi.y(); ++y)
+        {
+            for (int z = lo.z(); z <= hi.z(); ++z)
+            {
+                append_cell(Eigen::Vector3i(x, y, z), out);
+            }
+        }
+    }
+
+    sort_unique_tail(out, first);
+}
+
+float UniformGrid::get_cell_size() const
+{
+    return cell_size;
+}
+
+std::size_t UniformGrid::num_entries() const
+{
+    return entries.size();
+}
+
+Eigen::Vector3i UniformGrid::to_cell(const Eigen::Vector3f& point) const
+{
+    return (point / cell_size).array().floor().cast<int>();
+}
+
+std::uint64_t UniformGrid::to_key(const Eigen::Vector3i& cell)
+{
+    // 21 bits per axis, wrapping. Distinct cells that alias only cost extra narrowphase tests.
+    constexpr std::uint64_t mask = (1u << 21) - 1;
+    return ((static_cast<std::uint64_t>(cell.x()) & mask) << 42) |
+           ((static_cast<std::uint64_t>(cell.y()) & mask) << 21) |
+           (static_cast<std::uint64_t>(cell.z()) & mask);
+}
+
+void UniformGrid::append_cell(const Eigen::Vector3i& cell, std::vector<std::uint32_t>& out) const
+{
+    const auto key = to_key(cell);
+    auto it = std::lower_bound(entries.begin(), entries.end(), key, [](const Entry& e, auto k) {
+        return e.key < k;
+    });
+
+    for (; it != entries.end() && it->key == key; ++it)
+    {
+        out.push_back(it->id);
+    }
+}
+
+std::pair<Eigen::Vector3f, Eigen::Vector3f> world_aabb(const Eigen::Isometry3f& pose,
+                                                       const Eigen::Vector3f& dimensions)
+{
+    const Eigen::Vector3f half_extents = pose.linear().cwiseAbs() * (dimensions / 2.0f);
+    const Eigen::Vector3f center = pose.translation();
+
+    return std::make_pair(center - half_extents, center + half_extents);
+}
+}  // namespace geometry
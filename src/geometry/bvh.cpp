@@ -0,0 +1,431 @@
+#include "geometry/bvh.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include <Eigen/Eigenvalues>
+
+namespace geometry
+{
+namespace
+{
+// Balanced trees over any realistic number of parts are nowhere near this deep
+constexpr std::size_t max_depth = 64;
+
+Eigen::Vector3f center(const Bvh::Leaf& leaf)
+{
+    return leaf.aabb.center();
+}
+
+// Principal axes of the points, unless the resulting box is larger than the AABB
+Bvh::Obb fit_obb(const Eigen::Matrix3Xf& points, const Eigen::AlignedBox3f& aabb)
+{
+    const Eigen::Vector3f mean = points.rowwise().mean();
+    const Eigen::Matrix3Xf centered = points.colwise() - mean;
+    const Eigen::Matrix3f covariance = centered * centered.transpose() / points.cols();
+
+    Eigen::Matrix3f rotation = Eigen::SelfAdjointEigenSolver<Eigen::Matrix3f>(covariance)
+                                   .eigenvectors();
+    if (rotation.determinant() < 0.0f)
+    {
+        rotation.col(0) = -rotation.col(0);
+    }
+
+    const Eigen::Matrix3Xf local = rotation.transpose() * centered;
+    const Eigen::Vector3f min = local.rowwise().minCoeff();
+    const Eigen::Vector3f max = local.rowwise().maxCoeff();
+
+    const auto obb = Bvh::Obb{ rotation, mean + rotation * (min + max) / 2.0f, (max - min) / 2.0f };
+    if (8.0f * obb.half_extents.prod() >= aabb.volume())
+    {
+        return Bvh::Obb{ Eigen::Matrix3f::Identity(), aabb.center(), aabb.sizes() / 2.0f };
+    }
+    return obb;
+}
+
+void collect_leaves(const CollisionShape& shape, std::vector<Bvh::Leaf>& leaves)
+{
+    if (!shape.children.empty())
+    {
+        for (const auto& child : shape.children)
+        {
+            collect_leaves(child, leaves);
+        }
+        return;
+    }
+
+    const auto aabb = Eigen::AlignedBox3f(shape.vertices.rowwise().minCoeff(),
+                                          shape.vertices.rowwise().maxCoeff());
+    const Eigen::MatrixXf projections = shape.face_normals.transpose() * shape.vertices;
+    leaves.push_back(Bvh::Leaf{ shape,
+                                aabb,
+                                fit_obb(shape.vertices, aabb),
+                                projections.rowwise().minCoeff(),
+                                projections.rowwise().maxCoeff() });
+}
+
+// Clips [tmin, tmax] to where origin + t * direction projects into [lo, hi]
+bool clip_slab(const float origin,
+               const float direction,
+               const float lo,
+               const float hi,
+               float& tmin,
+               float& tmax)
+{
+    if (std::abs(direction) < 1e-12f)
+    {
+        return lo <= origin && origin <= hi;
+    }
+
+    const float inv_direction = 1.0f / direction;
+    const float t0 = (lo - origin) * inv_direction;
+    const float t1 = (hi - origin) * inv_direction;
+
+    tmin = std::max(tmin, std::min(t0, t1));
+    tmax = std::min(tmax, std::max(t0, t1));
+    return tmin <= tmax;
+}
+
+bool clip_box(const Eigen::AlignedBox3f& aabb,
+              const Bvh::Obb& obb,
+              const Eigen::Vector3f& origin,
+              const Eigen::Vector3f& direction,
+              float& tmin,
+              float& tmax)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        if (!clip_slab(origin[i], direction[i], aabb.min()[i], aabb.max()[i], tmin, tmax))
+        {
+            return false;
+        }
+    }
+
+    const Eigen::Vector3f local_origin = obb.rotation.transpose() * (origin - obb.center);
+    const Eigen::Vector3f local_direction = obb.rotation.transpose() * direction;
+    for (int i = 0; i < 3; ++i)
+    {
+        if (!clip_slab(local_origin[i],
+                       local_direction[i],
+                       -obb.half_extents[i],
+                       obb.half_extents[i],
+                       tmin,
+                       tmax))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool clip_node(const Bvh::Node& node,
+               const Eigen::Vector3f& origin,
+               const Eigen::Vector3f& direction,
+               float& tmin,
+               float& tmax)
+{
+    return clip_box(node.aabb, node.obb, origin, direction, tmin, tmax);
+}
+
+bool clip_leaf(const Bvh::Leaf& leaf,
+               const Eigen::Vector3f& origin,
+               const Eigen::Vector3f& direction,
+               float& tmin,
+               float& tmax)
+{
+    if (!clip_box(leaf.aabb, leaf.obb, origin, direction, tmin, tmax))
+    {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < leaf.shape.num_face_normals(); ++i)
+    {
+        const auto& normal = leaf.shape.face_normals.col(i);
+        if (!clip_slab(
+                normal.dot(origin), normal.dot(direction), leaf.lo[i], leaf.hi[i], tmin, tmax))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Whether the shape's vertices, brought into the model frame by relative_pose, overlap the node's
+// boxes along their axes. Allocates nothing.
+bool overlaps(const Bvh::Node& node,
+              const Eigen::AlignedBox3f& bounds,
+              const CollisionShape& shape,
+              const Eigen::Isometry3f& relative_pose)
+{
+    if (!node.aabb.intersects(bounds))
+    {
+        return false;
+    }
+
+    for (int i = 0; i < 3; ++i)
+    {
+        const Eigen::Vector3f axis = node.obb.rotation.col(i);
+        const Eigen::Vector3f local_axis = relative_pose.linear().transpose() * axis;
+        const float offset = axis.dot(relative_pose.translation() - node.obb.center);
+
+        float min = std::numeric_limits<float>::max();
+        float max = std::numeric_limits<float>::lowest();
+        for (Eigen::Index j = 0; j < shape.vertices.cols(); ++j)
+        {
+            const float projection = local_axis.dot(shape.vertices.col(j)) + offset;
+            min = std::min(min, projection);
+            max = std::max(max, projection);
+        }
+
+        if (min > node.obb.half_extents[i] || max < -node.obb.half_extents[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+}  // namespace
+
+Bvh::Bvh(const CollisionShape& root)
+{
+    collect_leaves(root, leaves);
+
+    nodes.push_back(Node{ {}, {}, 0, static_cast<std::uint32_t>(leaves.size()) });
+
+    // Split nodes in two along the longest axis of their leaves' centers, until small enough
+    auto to_split = std::vector<std::uint32_t>{ 0 };
+    while (!to_split.empty())
+    {
+        const auto index = to_split.back();
+        to_split.pop_back();
+
+        const auto first = nodes[index].first_leaf;
+        const auto count = nodes[index].num_leaves;
+        if (count <= max_leaves_per_node)
+        {
+            continue;
+        }
+
+        auto center_bounds = Eigen::AlignedBox3f();
+        for (auto i = first; i < first + count; ++i)
+        {
+            center_bounds.extend(center(leaves[i]));
+        }
+        int axis = 0;
+        center_bounds.sizes().maxCoeff(&axis);
+
+        const auto mid = first + count / 2;
+        std::nth_element(leaves.begin() + first,
+                         leaves.begin() + mid,
+                         leaves.begin() + first + count,
+                         [axis](const Leaf& a, const Leaf& b) {
+                             return center(a)[axis] < center(b)[axis];
+                         });
+
+        const auto child = static_cast<std::uint32_t>(nodes.size());
+        nodes[index].child = child;
+        nodes.push_back(Node{ {}, {}, first, mid - first });
+        nodes.push_back(Node{ {}, {}, mid, first + count - mid });
+        to_split.push_back(child);
+        to_split.push_back(child + 1);
+    }
+
+    refit();
+}
+
+void Bvh::refit()
+{
+    static const auto unit_corners = []() {
+        auto corners = Eigen::Matrix<float, 3, 8>();
+        for (int i = 0; i < 8; ++i)
+        {
+            corners.col(i) << (i & 1 ? 1.0f : -1.0f), (i & 2 ? 1.0f : -1.0f),
+                (i & 4 ? 1.0f : -1.0f);
+        }
+        return corners;
+    }();
+
+    for (auto& node : nodes)
+    {
+        // Fitting to the corners of the leaves' boxes rather than to their vertices keeps them
+        // inside the node's box
+        auto corners = Eigen::Matrix3Xf(3, 8 * node.num_leaves);
+        node.aabb.setEmpty();
+        for (auto j = node.first_leaf; j < node.first_leaf + node.num_leaves; ++j)
+        {
+            const auto& leaf = leaves[j];
+            node.aabb.extend(leaf.aabb);
+            corners.middleCols<8>(8 * (j - node.first_leaf)) =
+                (leaf.obb.rotation * leaf.obb.half_extents.asDiagonal() * unit_corners)
+                    .colwise() +
+                leaf.obb.center;
+        }
+        node.obb = fit_obb(corners, node.aabb);
+    }
+}
+
+template <bool any_hit>
+std::optional<Bvh::RayHit> Bvh::traverse(const Eigen::Vector3f& origin,
+                                         const Eigen::Vector3f& direction,
+                                         const float tmin,
+                                         float tmax) const
+{
+    auto closest = std::optional<RayHit>();
+
+    float root_tmin = tmin;
+    float root_tmax = tmax;
+    if (!clip_node(nodes[0], origin, direction, root_tmin, root_tmax))
+    {
+        return closest;
+    }
+
+    auto stack = std::array<std::uint32_t, max_depth>();
+    std::size_t stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size)
+    {
+        const auto& node = nodes[stack[--stack_size]];
+
+        if (node.is_leaf())
+        {
+            for (auto i = node.first_leaf; i < node.first_leaf + node.num_leaves; ++i)
+            {
+                float leaf_tmin = tmin;
+                float leaf_tmax = tmax;
+                if (clip_leaf(leaves[i], origin, direction, leaf_tmin, leaf_tmax) &&
+                    (!closest || leaf_tmin < closest->t))
+                {
+                    closest = RayHit{ i, leaf_tmin };
+                    if constexpr (any_hit)
+                    {
+                        return closest;
+                    }
+                    tmax = leaf_tmin;
+                }
+            }
+            continue;
+        }
+
+        // Nothing beyond the closest hit so far can be closer, and the nearer child is visited
+        // first so that its hits prune the other one
+        float tmin0 = tmin, tmax0 = tmax;
+        float tmin1 = tmin, tmax1 = tmax;
+        const bool hit0 = clip_node(nodes[node.child], origin, direction, tmin0, tmax0);
+        const bool hit1 = clip_node(nodes[node.child + 1], origin, direction, tmin1, tmax1);
+
+        if (hit0 && hit1)
+        {
+            const bool first_nearer = tmin0 <= tmin1;
+            stack[stack_size++] = first_nearer ? node.child + 1 : node.child;
+            stack[stack_size++] = first_nearer ? node.child : node.child + 1;
+        }
+        else if (hit0 || hit1)
+        {
+            stack[stack_size++] = hit0 ? node.child : node.child + 1;
+        }
+    }
+
+    return closest;
+}
+
+std::optional<Bvh::RayHit> Bvh::raycast(const Eigen::Vector3f& origin,
+                                        const Eigen::Vector3f& direction,
+                                        const float tmin,
+                                        const float tmax) const
+{
+    return traverse<false>(origin, direction, tmin, tmax);
+}
+
+bool Bvh::raycast_any(const Eigen::Vector3f& origin,
+                      const Eigen::Vector3f& direction,
+                      const float tmin,
+                      const float tmax) const
+{
+    return traverse<true>(origin, direction, tmin, tmax).has_value();
+}
+
+const Bvh::Leaf* Bvh::intersect(const CollisionShape& shape,
+                                const Eigen::Isometry3f& relative_pose) const
+{
+    auto bounds = Eigen::AlignedBox3f();
+    for (Eigen::Index i = 0; i < shape.vertices.cols(); ++i)
+    {
+        bounds.extend(relative_pose * Eigen::Vector3f(shape.vertices.col(i)));
+    }
+
+    auto stack = std::array<std::uint32_t, max_depth>();
+    std::size_t stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size)
+    {
+        const auto& node = nodes[stack[--stack_size]];
+        if (!overlaps(node, bounds, shape, relative_pose))
+        {
+            continue;
+        }
+
+        if (node.is_leaf())
+        {
+            for (auto i = node.first_leaf; i < node.first_leaf + node.num_leaves; ++i)
+            {
+                if (intersect_test(leaves[i].shape, shape, relative_pose))
+                {
+                    return &leaves[i];
+                }
+            }
+            continue;
+        }
+
+        stack[stack_size++] = node.child + 1;
+        stack[stack_size++] = node.child;
+    }
+
+    return nullptr;
+}
+
+void Bvh::query_aabb(const Eigen::AlignedBox3f& box, std::vector<std::uint32_t>& out) const
+{
+    auto stack = std::array<std::uint32_t, max_depth>();
+    std::size_t stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size)
+    {
+        const auto& node = nodes[stack[--stack_size]];
+        if (!node.aabb.intersects(box))
+        {
+            continue;
+        }
+
+        if (node.is_leaf())
+        {
+            for (auto i = node.first_leaf; i < node.first_leaf + node.num_leaves; ++i)
+            {
+                if (leaves[i].aabb.intersects(box))
+                {
+                    out.push_back(i);
+                }
+            }
+            continue;
+        }
+
+        stack[stack_size++] = node.child + 1;
+        stack[stack_size++] = node.child;
+    }
+}
+
+const std::vector<Bvh::Node>& Bvh::get_nodes() const
+{
+    return nodes;
+}
+
+const std::vector<Bvh::Leaf>& Bvh::get_leaves() const
+{
+    return leaves;
+}
+}  // namespace geometry
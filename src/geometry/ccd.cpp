@@ -0,0 +1,110 @@
+#include "geometry/ccd.h"
+
+#include <cmath>
+
+#include "geometry/geometry.h"
+
+namespace geometry
+{
+namespace
+{
+constexpr int max_iterations = 32;
+
+// Below this, the closest points are too close together to give the normal a direction
+constexpr float min_normal_distance = 1e-6f;
+
+// Angle the orientation turns through over the sweep
+float sweep_angle(const Sweep& sweep)
+{
+    return sweep.start_orientation.angularDistance(sweep.end_orientation);
+}
+}  // namespace
+
+Eigen::Isometry3f Sweep::pose(const float s) const
+{
+    return make_pose(lerp(start_position, end_position, s),
+                     slerp(start_orientation, end_orientation, s));
+}
+
+std::optional<TimeOfImpact> time_of_impact(const CollisionShape& a,
+                                           const Sweep& sweep_a,
+                                           const CollisionShape& b,
+                                           const Sweep& sweep_b,
+                                           GjkSimplex& simplex,
+                                           const float tolerance)
+{
+    // Over the whole tick, no point of a moves further than its frame origin does, plus the arc
+    // its furthest vertex turns through. Same for b.
+    const Eigen::Vector3f translation_a = sweep_a.end_position - sweep_a.start_position;
+    const Eigen::Vector3f translation_b = sweep_b.end_position - sweep_b.start_position;
+    const float rotation_bound =
+        sweep_angle(sweep_a) * bounding_radius(a) + sweep_angle(sweep_b) * bounding_radius(b);
+
+    auto impact = std::optional<TimeOfImpact>();
+    float s = 0.0f;
+    for (int i = 1;; ++i)
+    {
+        const Eigen::Isometry3f pose_a = sweep_a.pose(s);
+        const auto result = gjk(a, b, pose_a.inverse() * sweep_b.pose(s), simplex);
+        if (result.intersecting)
+        {
+            // Shapes overlapping from the start are left to whatever put them there. Past the
+            // start only rounding gets them here, and the previous step is close enough.
+            return impact;
+        }
+
+        const Eigen::Vector3f gap = result.point_b - result.point_a;
+        if (gap.norm() < min_normal_distance)
+        {
+            // Touching, the previous step's normal stands in for this one's
+            if (!impact)
+            {
+                return std::nullopt;
+            }
+            impact->s = s;
+            impact->point = pose_a * result.point_a;
+            return impact;
+        }
+
+        const Eigen::Vector3f normal = pose_a.linear() * gap.normalized();
+        impact = TimeOfImpact{ s, normal, pose_a * result.point_a, true };
+        if (result.distance <= tolerance)
+        {
+            return impact;
+        }
+
+        // Out of iterations, stop short of the impact rather than risk tunnelling
+        if (i == max_iterations)
+        {
+            impact->contact = false;
+            return impact;
+        }
+
+        // Fastest the gap along the normal can close, per tick
+        const float closing = (translation_a - translation_b).dot(normal) + rotation_bound;
+        if (closing <= 0.0f)
+        {
+            return std::nullopt;
+        }
+
+        // Advance by as much as certainly leaves the shapes tolerance / 2 apart
+        s += (result.distance - tolerance / 2.0f) / closing;
+        if (s > 1.0f)
+        {
+            return std::nullopt;
+        }
+    }
+}
+
+std::pair<Eigen::Vector3f, Eigen::Vector3f> swept_aabb(const Sweep& sweep, const float radius)
+{
+    const Eigen::Vector3f extent = Eigen::Vector3f::Constant(radius);
+    return std::make_pair(sweep.start_position.cwiseMin(sweep.end_position) - extent,
+                          sweep.start_position.cwiseMax(sweep.end_position) + extent);
+}
+
+float bounding_radius(const CollisionShape& shape)
+{
+    return std::sqrt(shape.vertices.colwise().squaredNorm().maxCoeff());
+}
+}  // namespace geometry
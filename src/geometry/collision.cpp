@@ -2,12 +2,102 @@
 
 #include <vector>
 #include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
+
+#include "geometry/hull.h"
+#include "geometry/simd.h"
 
 namespace geometry
 {
 namespace
 {
+// A box's rotation (transposed, so it brings world vectors into the box frame), center and half
+// extents
+struct ObbFrame
+{
+    float R_T[3][3];
+    float center[3];
+    float half_extents[3];
+};
+
+template <typename T>
+__attribute__((always_inline)) inline T min_lanes(const T& a, const T& b)
+{
+    return a < b ? a : b;
+}
+
+template <typename T>
+__attribute__((always_inline)) inline T max_lanes(const T& a, const T& b)
+{
+    return a < b ? b : a;
+}
+
+// T is either float (one ray) or simd::float8 (eight rays). The slab test of ray_aabb_test, without
+// branches, after bringing the rays into the box frame.
+template <typename T>
+__attribute__((always_inline)) inline auto
+ray_obb_lanes(const RayBatch& rays, const ObbFrame& obb, const std::size_t i)
+{
+    using simd::load;
+
+    const T ox = load<T>(rays.origin_x.data() + i) - obb.center[0];
+    const T oy = load<T>(rays.origin_y.data() + i) - obb.center[1];
+    const T oz = load<T>(rays.origin_z.data() + i) - obb.center[2];
+    const T dx = load<T>(rays.direction_x.data() + i);
+    const T dy = load<T>(rays.direction_y.data() + i);
+    const T dz = load<T>(rays.direction_z.data() + i);
+
+    const T local_ox = obb.R_T[0][0] * ox + obb.R_T[0][1] * oy + obb.R_T[0][2] * oz;
+    const T local_oy = obb.R_T[1][0] * ox + obb.R_T[1][1] * oy + obb.R_T[1][2] * oz;
+    const T local_oz = obb.R_T[2][0] * ox + obb.R_T[2][1] * oy + obb.R_T[2][2] * oz;
+    const T inv_dx = 1.0f / (obb.R_T[0][0] * dx + obb.R_T[0][1] * dy + obb.R_T[0][2] * dz);
+    const T inv_dy = 1.0f / (obb.R_T[1][0] * dx + obb.R_T[1][1] * dy + obb.R_T[1][2] * dz);
+    const T inv_dz = 1.0f / (obb.R_T[2][0] * dx + obb.R_T[2][1] * dy + obb.R_T[2][2] * dz);
+
+    const T t0x = (-obb.half_extents[0] - local_ox) * inv_dx;
+    const T t0y = (-obb.half_extents[1] - local_oy) * inv_dy;
+    const T t0z = (-obb.half_extents[2] - local_oz) * inv_dz;
+    const T t1x = (obb.half_extents[0] - local_ox) * inv_dx;
+    const T t1y = (obb.half_extents[1] - local_oy) * inv_dy;
+    const T t1z = (obb.half_extents[2] - local_oz) * inv_dz;
+
+    const T tmin = max_lanes(
+        load<T>(rays.tmin.data() + i),
+        max_lanes(min_lanes(t0x, t1x), max_lanes(min_lanes(t0y, t1y), min_lanes(t0z, t1z))));
+    const T tmax = min_lanes(
+        load<T>(rays.tmax.data() + i),
+        min_lanes(max_lanes(t0x, t1x), min_lanes(max_lanes(t0y, t1y), max_lanes(t0z, t1z))));
+
+    return tmin < tmax;
+}
+
+AWING_TARGET_CLONES
+void ray_obb_range(const RayBatch& rays, const ObbFrame& obb, std::uint64_t* hit_mask)
+{
+    const auto num_rays = rays.size();
+
+    // 8 lanes divide 64 bits, so a group never straddles two mask words
+    std::size_t i = 0;
+    for (; i + simd::lanes <= num_rays; i += simd::lanes)
+    {
+        const auto hits = ray_obb_lanes<simd::float8>(rays, obb, i);
+
+        std::uint64_t bits = 0;
+        for (std::size_t lane = 0; lane < simd::lanes; ++lane)
+        {
+            bits |= static_cast<std::uint64_t>(hits[lane] & 1) << lane;
+        }
+        hit_mask[i / 64] |= bits << (i % 64);
+    }
+    for (; i < num_rays; ++i)
+    {
+        const bool hit = ray_obb_lanes<float>(rays, obb, i);
+        hit_mask[i / 64] |= static_cast<std::uint64_t>(hit) << (i % 64);
+    }
+}
+
 std::tuple<Eigen::Matrix3Xf, Eigen::Matrix3Xf, Eigen::Matrix3Xf>
 make_box_attribs(const Eigen::Vector3f& min, const Eigen::Vector3f& max)
 {
@@ -40,53 +130,84 @@ make_box_attribs(const Eigen::Vector3f& min, const Eigen::Vector3f& max)
     return std::make_tuple(vertices, face_normals, edges);
 }
 
-Eigen::Matrix3Xf make_separating_axes(const CollisionShape& a,
-                                      const CollisionShape& b,
-                                      const Eigen::Isometry3f& relative_pose)
+// Extent of points, each transformed by pose, along axis
+std::pair<float, float> project(const Eigen::Vector3f& axis,
+                                const Eigen::Matrix3Xf& points,
+                                const Eigen::Isometry3f& pose = Eigen::Isometry3f::Identity())
+{
+    // axis . (R * p + t) == (R^T * axis) . p + axis . t, so the points needn't be transformed
+    const Eigen::Vector3f local_axis = pose.linear().transpose() * axis;
+    const float offset = axis.dot(pose.translation());
+
+    float min = std::numeric_limits<float>::max();
+    float max = std::numeric_limits<float>::lowest();
+    for (Eigen::Index i = 0; i < points.cols(); ++i)
+    {
+        const float projection = local_axis.dot(points.col(i));
+        min = std::min(min, projection);
+        max = std::max(max, projection);
+    }
+
+    return std::make_pair(min + offset, max + offset);
+}
+
+bool is_separating_axis(const Eigen::Vector3f& axis,
+                        const CollisionShape& a,
+                        const CollisionShape& b,
+                        const Eigen::Isometry3f& relative_pose)
 {
-    // Bring shape B into A's frame first
-    auto face_normals = relative_pose * b.face_normals.colwise().homogeneous();
-    auto edges = relative_pose * b.edges.colwise().homogeneous();
+    const auto [min_a, max_a] = project(axis, a.vertices);
+    const auto [min_b, max_b] = project(axis, b.vertices, relative_pose);
+
+    return min_b > max_a || max_b < min_a;
+}
 
-    auto num_cols = a.num_face_normals() + b.num_face_normals() + (a.num_edges() * b.num_edges());
-    Eigen::Matrix3Xf separating_axes(3, num_cols);
+// SAT over the face normals of both shapes and the cross products of their edges. The axes are
+// generated as they are tested, so nothing is stored.
+bool convex_intersection_test(const CollisionShape& a,
+                              const CollisionShape& b,
+                              const Eigen::Isometry3f& relative_pose)
+{
+    const Eigen::Matrix3f R = relative_pose.linear();
 
     for (std::size_t i = 0; i < a.num_face_normals(); ++i)
     {
-        separating_axes.col(i) = a.face_normals.col(i);
+        if (is_separating_axis(a.face_normals.col(i), a, b, relative_pose))
+        {
+            return false;
+        }
     }
 
-    auto start_idx = a.num_face_normals();
     for (std::size_t i = 0; i < b.num_face_normals(); ++i)
     {
-        separating_axes.col(start_idx + i) = face_normals.col(i);
+        if (is_separating_axis(R * b.face_normals.col(i), a, b, relative_pose))
+        {
+            return false;
+        }
     }
 
-    start_idx = a.num_face_normals() + b.num_face_normals();
-    int idx = 0;
-    for (std::size_t i = 0; i < a.num_edges(); ++i)
+    for (std::size_t j = 0; j < b.num_edges(); ++j)
     {
-        for (std::size_t j = 0; j < b.num_edges(); ++j)
+        const Eigen::Vector3f b_edge = R * b.edges.col(j);
+        for (std::size_t i = 0; i < a.num_edges(); ++i)
         {
-            separating_axes.col(start_idx + idx++) = a.edges.col(i).cross(edges.col(j));
+            if (is_separating_axis(a.edges.col(i).cross(b_edge), a, b, relative_pose))
+            {
+                return false;
+            }
         }
     }
 
-    return separating_axes;
+    return true;
 }
 
-bool convex_intersection_test(const Eigen::Matrix3Xf& separating_axes,
-                              const Eigen::Matrix3Xf& points1,
-                              const Eigen::Matrix3Xf& points2)
+// The pose of b's box in a's box frame, given the pose of b's frame in a's frame
+Eigen::Isometry3f box_relative_pose(const CollisionShape& a,
+                                    const CollisionShape& b,
+                                    const Eigen::Isometry3f& relative_pose)
 {
-    for (int i = 0; i < separating_axes.cols(); ++i)
-    {
-        if (is_separating_axis(separating_axes.col(i), points1, points2))
-        {
-            return false;
-        }
-    }
-    return true;
+    return Eigen::Translation3f(-(a.min + a.max) / 2.0f) * relative_pose *
+           Eigen::Translation3f((b.min + b.max) / 2.0f);
 }
 
 std::pair<Eigen::Vector3f, Eigen::Vector3f> calculate_extents(const CollisionShape& shape)
@@ -118,13 +239,13 @@ std::pair<Eigen::Vector3f, Eigen::Vector3f> calculate_extents(const CollisionSha
 }  // namespace
 
 CollisionShape::CollisionShape(const Eigen::Vector3f& min, const Eigen::Vector3f& max)
-  : min(min), max(max)
+  : min(min), max(max), is_box(true)
 {
     // If given ony extents, assume Box
     std::tie(vertices, face_normals, edges) = make_box_attribs(min, max);
 }
 
-CollisionShape::CollisionShape(const resources::GeometryData& data)
+CollisionShape::CollisionShape(const resources::GeometryData& data) : name(data.name)
 {
     if (data.children.size())
     {
@@ -136,12 +257,13 @@ CollisionShape::CollisionShape(const resources::GeometryData& data)
         // Calculate combined extents...
         std::tie(min, max) = calculate_extents(*this);
         std::tie(vertices, face_normals, edges) = make_box_attribs(min, max);
+        is_box = true;
     }
     else
     {
-        if (data.vertices.empty() || data.face_indices.empty() || data.edge_indices.empty())
+        if (data.vertices.empty() || data.face_indices.empty())
         {
-            throw std::runtime_error("GeometryData Leaf node has no vertices and/or face/edge "
+            throw std::runtime_error("GeometryData Leaf node has no vertices and/or face "
                                      "indices!");
         }
 
@@ -157,55 +279,149 @@ CollisionShape::CollisionShape(const resources::GeometryData& data)
                 data.vertices[3 * i + 0], data.vertices[3 * i + 1], data.vertices[3 * i + 2]);
         }
 
-        face_normals.resize(3, data.face_indices.size());
-        for (std::size_t i = 0; i < data.face_indices.size(); ++i)
+        auto hull = cook_hull(vertices, data.face_indices);
+        face_normals = std::move(hull.face_normals);
+        edges = std::move(hull.edges);
+        neighbour_offsets = std::move(hull.neighbour_offsets);
+        neighbours = std::move(hull.neighbours);
+
+        min = Eigen::Vector3f(data.min.value()[0], data.min.value()[1], data.min.value()[2]);
+        max = Eigen::Vector3f(data.max.value()[0], data.max.value()[1], data.max.value()[2]);
+    }
+}
+
+std::uint32_t CollisionShape::support(const Eigen::Vector3f& direction,
+                                      const std::uint32_t start) const
+{
+    if (neighbours.empty() || start >= vertices.cols())
+    {
+        std::uint32_t best = 0;
+        float best_projection = std::numeric_limits<float>::lowest();
+        for (Eigen::Index i = 0; i < vertices.cols(); ++i)
         {
-            const auto dir1 = vertices.col(std::get<0>(data.face_indices[i])) -
-                              vertices.col(std::get<1>(data.face_indices[i]));
-            const auto dir2 = vertices.col(std::get<0>(data.face_indices[i])) -
-                              vertices.col(std::get<2>(data.face_indices[i]));
-            face_normals.col(i) = dir1.cross(dir2).normalized();
+            if (const float projection = direction.dot(vertices.col(i));
+                projection > best_projection)
+            {
+                best = static_cast<std::uint32_t>(i);
+                best_projection = projection;
+            }
         }
+        return best;
+    }
 
-        edges.resize(3, data.edge_indices.size());
-
-        std::size_t i = 0;
-        for (const auto& [idx1, idx2] : data.edge_indices)
+    // On a convex hull, a vertex no neighbour of which is further along direction is the furthest
+    auto best = start;
+    float best_projection = direction.dot(vertices.col(best));
+    for (bool climbing = true; climbing;)
+    {
+        climbing = false;
+        const auto current = best;
+        for (auto i = neighbour_offsets[current]; i < neighbour_offsets[current + 1]; ++i)
         {
-            edges.col(i++) = (vertices.col(idx1) - vertices.col(idx2)).normalized();
+            if (const float projection = direction.dot(vertices.col(neighbours[i]));
+                projection > best_projection)
+            {
+                best = neighbours[i];
+                best_projection = projection;
+                climbing = true;
+            }
         }
+    }
+    return best;
+}
 
-        min = Eigen::Vector3f(data.min.value()[0], data.min.value()[1], data.min.value()[2]);
-        max = Eigen::Vector3f(data.max.value()[0], data.max.value()[1], data.max.value()[2]);
+const CollisionShape* intersect_test(const CollisionShape& a,
+                                     const CollisionShape& b,
+                                     const Eigen::Isometry3f& relative_pose)
+{
+    const bool intersects = a.is_box && b.is_box ?
+                                obb_intersect_test(a.scale() / 2.0f,
+                                                   b.scale() / 2.0f,
+                                                   box_relative_pose(a, b, relative_pose)) :
+                                convex_intersection_test(a, b, relative_pose);
+    if (!intersects)
+    {
+        return nullptr;
+    }
+
+    // If B is a leaf, A and B intersect
+    if (b.children.empty())
+    {
+        return &b;
     }
+
+    // If B has children, run down the tree
+    for (const auto& b_child : b.children)
+    {
+        if (const auto* hit = intersect_test(a, b_child, relative_pose))
+        {
+            return hit;
+        }
+    }
+
+    return nullptr;
 }
 
-std::optional<CollisionShape> intersect_test(const CollisionShape& a,
-                                             const CollisionShape& b,
-                                             const Eigen::Isometry3f& relative_pose)
+bool obb_intersect_test(const Eigen::Vector3f& half_extents_a,
+                        const Eigen::Vector3f& half_extents_b,
+                        const Eigen::Isometry3f& relative_pose)
 {
-    if (convex_intersection_test(
-            make_separating_axes(a, b, Eigen::Isometry3f(relative_pose.linear())),
-            a.vertices,
-            relative_pose * b.vertices.colwise().homogeneous()))
+    // The 15 axis test from Ericson, Real-Time Collision Detection, 4.4.1. Column j of R is B's
+    // axis j in A's frame.
+    const auto& a = half_extents_a;
+    const auto& b = half_extents_b;
+    const Eigen::Matrix3f R = relative_pose.linear();
+    const Eigen::Vector3f t = relative_pose.translation();
+
+    // The epsilon keeps the cross products of near parallel axes from separating anything
+    const Eigen::Matrix3f abs_R = R.cwiseAbs().array() + 1e-6f;
+
+    // A's axes
+    for (int i = 0; i < 3; ++i)
     {
-        // If B is a leaf, A and B intersect
-        if (!b.children.size())
+        if (std::abs(t[i]) > a[i] + b.dot(abs_R.row(i)))
         {
-            return b;
+            return false;
         }
+    }
 
-        // If B has children, run down the tree
-        for (const auto& b_child : b.children)
+    // B's axes
+    for (int j = 0; j < 3; ++j)
+    {
+        if (std::abs(t.dot(R.col(j))) > a.dot(abs_R.col(j)) + b[j])
         {
-            if (const auto& test = intersect_test(a, b_child, relative_pose))
+            return false;
+        }
+    }
+
+    // A's axis i cross B's axis j
+    for (int i = 0; i < 3; ++i)
+    {
+        const int i1 = (i + 1) % 3;
+        const int i2 = (i + 2) % 3;
+        for (int j = 0; j < 3; ++j)
+        {
+            const int j1 = (j + 1) % 3;
+            const int j2 = (j + 2) % 3;
+            const float ra = a[i1] * abs_R(i2, j) + a[i2] * abs_R(i1, j);
+            const float rb = b[j1] * abs_R(i, j2) + b[j2] * abs_R(i, j1);
+            if (std::abs(t[i2] * R(i1, j) - t[i1] * R(i2, j)) > ra + rb)
             {
-                return b_child;
+                return false;
             }
         }
     }
 
-    return std::nullopt;
+    return true;
+}
+
+bool obb_intersect_test(const Eigen::Isometry3f& T_world_a,
+                        const Eigen::Vector3f& dimensions_a,
+                        const Eigen::Isometry3f& T_world_b,
+                        const Eigen::Vector3f& dimensions_b)
+{
+    return obb_intersect_test(
+        dimensions_a / 2.0f, dimensions_b / 2.0f, T_world_a.inverse() * T_world_b);
 }
 
 bool is_inside(const CollisionShape& box, const Eigen::Matrix3Xf& points)
@@ -277,6 +493,63 @@ bool ray_aabb_test(const Eigen::Isometry3f& T_world_ray,
     return ray_aabb_test(ray_dir, ray_pos, ray_tmax, ray_tmin, aabb_dimensions);
 }
 
+void RayBatch::clear()
+{
+    for (auto* array : { &origin_x,
+                         &origin_y,
+                         &origin_z,
+                         &direction_x,
+                         &direction_y,
+                         &direction_z,
+                         &tmin,
+                         &tmax })
+    {
+        array->clear();
+    }
+}
+
+void RayBatch::push_back(const Eigen::Vector3f& origin,
+                         const Eigen::Vector3f& direction,
+                         const float ray_tmin,
+                         const float ray_tmax)
+{
+    origin_x.push_back(origin.x());
+    origin_y.push_back(origin.y());
+    origin_z.push_back(origin.z());
+    direction_x.push_back(direction.x());
+    direction_y.push_back(direction.y());
+    direction_z.push_back(direction.z());
+    tmin.push_back(ray_tmin);
+    tmax.push_back(ray_tmax);
+}
+
+std::size_t RayBatch::size() const
+{
+    return origin_x.size();
+}
+
+void ray_obb_test(const RayBatch& rays,
+                  const Eigen::Isometry3f& T_world_obb,
+                  const Eigen::Vector3f& obb_dimensions,
+                  std::vector<std::uint64_t>& hit_mask)
+{
+    hit_mask.assign((rays.size() + 63) / 64, 0);
+
+    auto obb = ObbFrame();
+    const Eigen::Matrix3f R = T_world_obb.linear();
+    for (int row = 0; row < 3; ++row)
+    {
+        for (int col = 0; col < 3; ++col)
+        {
+            obb.R_T[row][col] = R(col, row);
+        }
+        obb.center[row] = T_world_obb.translation()[row];
+        obb.half_extents[row] = obb_dimensions[row] / 2.0f;
+    }
+
+    ray_obb_range(rays, obb, hit_mask.data());
+}
+
 bool is_separating_axis(const Eigen::Vector3f& axis,
                         const Eigen::Matrix3Xf& pointsA,
                         const Eigen::Matrix3Xf& pointsB)
@@ -284,16 +557,10 @@ bool is_separating_axis(const Eigen::Vector3f& axis,
     // https://en.wikipedia.org/wiki/Hyperplane_separation_theorem#Use_in_collision_detection
 
     // Project the points from the two objects onto the axis
-    auto projectionsA = (axis.transpose() * pointsA).transpose();
-    auto projectionsB = (axis.transpose() * pointsB).transpose();
+    const auto [min_a, max_a] = project(axis, pointsA);
+    const auto [min_b, max_b] = project(axis, pointsB);
 
     // Axis is separating if the projections of object B and object A onto the axis have no overlap
-    if (projectionsB.minCoeff() > projectionsA.maxCoeff() ||
-        projectionsB.maxCoeff() < projectionsA.minCoeff())
-    {
-        return true;
-    }
-
-    return false;
+    return min_b > max_a || max_b < min_a;
 }
 }  // namespace geometry
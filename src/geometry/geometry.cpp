@@ -1,6 +1,7 @@
 #include <iostream>
 
 #include "geometry/geometry.h"
+#include "geometry/motion_state_arrays.h"
 
 namespace geometry
 {
@@ -21,11 +22,8 @@ Eigen::Vector3f MotionState::fwd() const
 
 void MotionState::integrate(const float dt)
 {
-    velocity += acceleration * dt;
-    position += velocity * dt;
-
-    angular_velocity = angular_velocity + angular_acceleration * dt;
-    orientation = angular_velocity_to_quat(angular_velocity, dt) * orientation;
+    // Shares its arithmetic with the batched MotionStateArrays kernel
+    integrate_motion_state(*this, dt);
 }
 
 // https://stackoverflow.com/questions/14971712/eigen-perspective-projection-matrix
@@ -0,0 +1,631 @@
+#include "geometry/gjk.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace geometry
+{
+namespace
+{
+constexpr int max_gjk_iterations = 64;
+constexpr int max_epa_iterations = 128;
+
+// GJK stops once a new support point gets the simplex less than this much closer, relatively
+constexpr float gjk_relative_tolerance = 1e-5f;
+
+// EPA stops once the polytope grows less than this much (in meters) towards the closest face
+constexpr float epa_tolerance = 1e-4f;
+
+// A point of the Minkowski difference a - b, with the points of a and b it came from
+struct Vertex
+{
+    Eigen::Vector3f w;
+    Eigen::Vector3f a;
+    Eigen::Vector3f b;
+    std::uint32_t index_a;
+    std::uint32_t index_b;
+};
+
+struct Simplex
+{
+    std::array<Vertex, 4> vertices;
+    std::array<float, 4> lambdas;  // Barycentric coordinates of the point closest to the origin
+    int size = 0;
+
+    Eigen::Vector3f closest_point() const
+    {
+        Eigen::Vector3f point = Eigen::Vector3f::Zero();
+        for (int i = 0; i < size; ++i)
+        {
+            point += lambdas[i] * vertices[i].w;
+        }
+        return point;
+    }
+
+    bool contains(const Vertex& vertex) const
+    {
+        for (int i = 0; i < size; ++i)
+        {
+            if (vertices[i].index_a == vertex.index_a && vertices[i].index_b == vertex.index_b)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+Vertex make_vertex(const CollisionShape& a,
+                   const CollisionShape& b,
+                   const Eigen::Isometry3f& relative_pose,
+                   const std::uint32_t index_a,
+                   const std::uint32_t index_b)
+{
+    const Eigen::Vector3f point_a = a.vertices.col(index_a);
+    const Eigen::Vector3f point_b = relative_pose * Eigen::Vector3f(b.vertices.col(index_b));
+    return Vertex{ point_a - point_b, point_a, point_b, index_a, index_b };
+}
+
+// The point of the Minkowski difference furthest along direction. Hill climbing shapes search
+// from the vertices at start_a and start_b, so passing those of a nearby point saves steps.
+Vertex support(const CollisionShape& a,
+               const CollisionShape& b,
+               const Eigen::Isometry3f& relative_pose,
+               const Eigen::Vector3f& direction,
+               const std::uint32_t start_a = 0,
+               const std::uint32_t start_b = 0)
+{
+    return make_vertex(a,
+                       b,
+                       relative_pose,
+                       a.support(direction, start_a),
+                       b.support(relative_pose.linear().transpose() * -direction, start_b));
+}
+
+void set_vertex(Simplex& simplex, const Vertex& vertex)
+{
+    simplex.vertices[0] = vertex;
+    simplex.lambdas[0] = 1.0f;
+    simplex.size = 1;
+}
+
+void set_segment(Simplex& simplex, const Vertex& a, const Vertex& b, const float t)
+{
+    simplex.vertices[0] = a;
+    simplex.vertices[1] = b;
+    simplex.lambdas[0] = 1.0f - t;
+    simplex.lambdas[1] = t;
+    simplex.size = 2;
+}
+
+// The closest point to the origin of each kind of simplex follows Ericson, Real-Time Collision
+// Detection, 5.1, and reduces the simplex to the vertices spanning the region it is in
+void solve_segment(Simplex& simplex)
+{
+    const auto a = simplex.vertices[0];
+    const auto b = simplex.vertices[1];
+    const Eigen::Vector3f ab = b.w - a.w;
+
+    const float t = -a.w.dot(ab);
+    if (t <= 0.0f)
+    {
+        set_vertex(simplex, a);
+    }
+    else if (const float length2 = ab.squaredNorm(); t >= length2)
+    {
+        set_vertex(simplex, b);
+    }
+    else
+    {
+        set_segment(simplex, a, b, t / length2);
+    }
+}
+
+void solve_triangle(Simplex& simplex)
+{
+    const auto a = simplex.vertices[0];
+    const auto b = simplex.vertices[1];
+    const auto c = simplex.vertices[2];
+    const Eigen::Vector3f ab = b.w - a.w;
+    const Eigen::Vector3f ac = c.w - a.w;
+
+    const float d1 = -ab.dot(a.w);
+    const float d2 = -ac.dot(a.w);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+    {
+        return set_vertex(simplex, a);
+    }
+
+    const float d3 = -ab.dot(b.w);
+    const float d4 = -ac.dot(b.w);
+    if (d3 >= 0.0f && d4 <= d3)
+    {
+        return set_vertex(simplex, b);
+    }
+
+    const float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+    {
+        return set_segment(simplex, a, b, d1 / (d1 - d3));
+    }
+
+    const float d5 = -ab.dot(c.w);
+    const float d6 = -ac.dot(c.w);
+    if (d6 >= 0.0f && d5 <= d6)
+    {
+        return set_vertex(simplex, c);
+    }
+
+    const float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+    {
+        return set_segment(simplex, a, c, d2 / (d2 - d6));
+    }
+
+    const float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+    {
+        return set_segment(simplex, b, c, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    }
+
+    const float denominator = va + vb + vc;
+    if (denominator <= 0.0f)
+    {
+        // Degenerate triangle, whose regions above all missed the origin by rounding
+        return set_vertex(simplex, a);
+    }
+    simplex.lambdas[1] = vb / denominator;
+    simplex.lambdas[2] = vc / denominator;
+    simplex.lambdas[0] = 1.0f - simplex.lambdas[1] - simplex.lambdas[2];
+}
+
+// Returns false if the origin is inside the tetrahedron
+bool solve_tetrahedron(Simplex& simplex)
+{
+    static constexpr std::array<std::array<int, 4>, 4> faces = {
+        { { 0, 1, 2, 3 }, { 0, 2, 3, 1 }, { 0, 3, 1, 2 }, { 1, 3, 2, 0 } }
+    };
+
+    const auto vertices = simplex.vertices;
+    auto best = Simplex();
+    float best_distance2 = std::numeric_limits<float>::max();
+    bool inside = true;
+
+    for (const auto& [i, j, k, opposite] : faces)
+    {
+        const Eigen::Vector3f normal =
+            (vertices[j].w - vertices[i].w).cross(vertices[k].w - vertices[i].w);
+        const float sign_origin = -normal.dot(vertices[i].w);
+        const float sign_opposite = normal.dot(vertices[opposite].w - vertices[i].w);
+
+        // Flat tetrahedra, as made by the coplanar vertices of boxes, can't enclose the origin.
+        // Their faces are all tested, as rounding can put the opposite vertex on either side.
+        const bool flat = sign_opposite * sign_opposite <=
+                          1e-8f * normal.squaredNorm() *
+                              (vertices[opposite].w - vertices[i].w).squaredNorm();
+        if (!flat && sign_origin * sign_opposite > 0.0f)
+        {
+            continue;
+        }
+        inside = false;
+
+        auto face = Simplex();
+        face.vertices = { vertices[i], vertices[j], vertices[k], vertices[k] };
+        face.size = 3;
+        solve_triangle(face);
+
+        if (const float distance2 = face.closest_point().squaredNorm(); distance2 < best_distance2)
+        {
+            best = face;
+            best_distance2 = distance2;
+        }
+    }
+
+    if (inside)
+    {
+        return false;
+    }
+
+    simplex = best;
+    return true;
+}
+
+// Reduces the simplex to the smallest one supporting its closest point to the origin. Returns
+// false if the simplex is a tetrahedron enclosing the origin.
+bool solve(Simplex& simplex)
+{
+    switch (simplex.size)
+    {
+        case 1:
+            simplex.lambdas[0] = 1.0f;
+            return true;
+        case 2:
+            solve_segment(simplex);
+            return true;
+        case 3:
+            solve_triangle(simplex);
+            return true;
+        default:
+            return solve_tetrahedron(simplex);
+    }
+}
+
+void store(const Simplex& simplex, GjkSimplex& out)
+{
+    for (int i = 0; i < simplex.size; ++i)
+    {
+        out.index_a[i] = simplex.vertices[i].index_a;
+        out.index_b[i] = simplex.vertices[i].index_b;
+    }
+    out.size = simplex.size;
+}
+
+Simplex load(const CollisionShape& a,
+             const CollisionShape& b,
+             const Eigen::Isometry3f& relative_pose,
+             const GjkSimplex& in)
+{
+    auto simplex = Simplex();
+    for (int i = 0; i < std::min(in.size, 4); ++i)
+    {
+        // Skip anything that doesn't belong to these shapes
+        if (in.index_a[i] >= a.vertices.cols() || in.index_b[i] >= b.vertices.cols())
+        {
+            continue;
+        }
+
+        const auto vertex = make_vertex(a, b, relative_pose, in.index_a[i], in.index_b[i]);
+        if (!simplex.contains(vertex))
+        {
+            simplex.vertices[simplex.size++] = vertex;
+        }
+    }
+    return simplex;
+}
+
+struct Face
+{
+    std::array<std::uint32_t, 3> vertices;
+    Eigen::Vector3f normal;
+    float distance;
+};
+
+struct Polytope
+{
+    std::vector<Vertex> vertices;
+    std::vector<Face> faces;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> horizon;
+
+    // Adds the face i, j, k, wound counter-clockwise seen from outside. Returns false if it is
+    // degenerate.
+    bool add_face(const std::uint32_t i, const std::uint32_t j, const std::uint32_t k)
+    {
+        const Eigen::Vector3f normal =
+            (vertices[j].w - vertices[i].w).cross(vertices[k].w - vertices[i].w);
+        const float norm = normal.norm();
+        if (norm <= std::numeric_limits<float>::epsilon())
+        {
+            return false;
+        }
+
+        faces.push_back(Face{ { i, j, k }, normal / norm, normal.dot(vertices[i].w) / norm });
+        return true;
+    }
+};
+
+// Grows the simplex of intersecting shapes into a tetrahedron, which fails if the shapes only
+// touch so that the Minkowski difference is flat around the origin
+bool make_tetrahedron(const CollisionShape& a,
+                      const CollisionShape& b,
+                      const Eigen::Isometry3f& relative_pose,
+                      Simplex& simplex)
+{
+    constexpr float min_distance = 1e-6f;
+
+    auto try_add = [&](const Eigen::Vector3f& direction, auto&& accept) {
+        const auto& start = simplex.vertices[0];
+        const auto vertex =
+            support(a, b, relative_pose, direction, start.index_a, start.index_b);
+        if (!simplex.contains(vertex) && accept(vertex.w))
+        {
+            simplex.vertices[simplex.size++] = vertex;
+            return true;
+        }
+        return false;
+    };
+
+    if (simplex.size == 0)
+    {
+        simplex.vertices[simplex.size++] = support(a, b, relative_pose, Eigen::Vector3f::UnitX());
+    }
+
+    if (simplex.size == 1)
+    {
+        const Eigen::Vector3f origin = simplex.vertices[0].w;
+        bool added = false;
+        for (int axis = 0; axis < 3 && !added; ++axis)
+        {
+            for (const float sign : { 1.0f, -1.0f })
+            {
+                if (try_add(sign * Eigen::Vector3f::Unit(axis), [&](const Eigen::Vector3f& w) {
+                        return (w - origin).norm() > min_distance;
+                    }))
+                {
+                    added = true;
+                    break;
+                }
+            }
+        }
+        if (!added)
+        {
+            return false;
+        }
+    }
+
+    if (simplex.size == 2)
+    {
+        const Eigen::Vector3f origin = simplex.vertices[0].w;
+        const Eigen::Vector3f line = (simplex.vertices[1].w - origin).normalized();
+
+        int least_aligned = 0;
+        line.cwiseAbs().minCoeff(&least_aligned);
+        const Eigen::Vector3f perpendicular =
+            line.cross(Eigen::Vector3f::Unit(least_aligned)).normalized();
+
+        bool added = false;
+        for (int i = 0; i < 6 && !added; ++i)
+        {
+            const auto rotation = Eigen::AngleAxisf(i * static_cast<float>(M_PI) / 3.0f, line);
+            added = try_add(rotation * perpendicular, [&](const Eigen::Vector3f& w) {
+                return line.cross(w - origin).norm() > min_distance;
+            });
+        }
+        if (!added)
+        {
+            return false;
+        }
+    }
+
+    if (simplex.size == 3)
+    {
+        const Eigen::Vector3f origin = simplex.vertices[0].w;
+        const Eigen::Vector3f normal = (simplex.vertices[1].w - origin)
+                                           .cross(simplex.vertices[2].w - origin)
+                                           .normalized();
+        auto off_plane = [&](const Eigen::Vector3f& w) {
+            return std::abs(normal.dot(w - origin)) > min_distance;
+        };
+        if (!try_add(normal, off_plane) && !try_add(-normal, off_plane))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Barycentric coordinates of the projection of point onto the triangle a, b, c
+Eigen::Vector3f barycentric(const Eigen::Vector3f& point,
+                            const Eigen::Vector3f& a,
+                            const Eigen::Vector3f& b,
+                            const Eigen::Vector3f& c)
+{
+    const Eigen::Vector3f v0 = b - a;
+    const Eigen::Vector3f v1 = c - a;
+    const Eigen::Vector3f v2 = point - a;
+    const float d00 = v0.dot(v0);
+    const float d01 = v0.dot(v1);
+    const float d11 = v1.dot(v1);
+    const float d20 = v2.dot(v0);
+    const float d21 = v2.dot(v1);
+    const float denominator = d00 * d11 - d01 * d01;
+    if (std::abs(denominator) <= std::numeric_limits<float>::min())
+    {
+        return Eigen::Vector3f(1.0f, 0.0f, 0.0f);
+    }
+
+    const float v = (d11 * d20 - d01 * d21) / denominator;
+    const float w = (d00 * d21 - d01 * d20) / denominator;
+    return Eigen::Vector3f(1.0f - v - w, v, w);
+}
+}  // namespace
+
+GjkResult gjk(const CollisionShape& a,
+              const CollisionShape& b,
+              const Eigen::Isometry3f& relative_pose,
+              GjkSimplex& warm_start)
+{
+    auto simplex = load(a, b, relative_pose, warm_start);
+    if (simplex.size == 0)
+    {
+        const Eigen::Vector3f direction = relative_pose * ((b.min + b.max) / 2.0f) -
+                                          (a.min + a.max) / 2.0f;
+        set_vertex(simplex, support(a, b, relative_pose, -direction));
+    }
+
+    auto result = GjkResult{ false, 0.0f, Eigen::Vector3f::Zero(), Eigen::Vector3f::Zero(), 0 };
+    auto previous = Simplex();
+    float previous_distance2 = std::numeric_limits<float>::max();
+    while (true)
+    {
+        if (!solve(simplex))
+        {
+            result.intersecting = true;
+            break;
+        }
+
+        const Eigen::Vector3f closest = simplex.closest_point();
+        const float distance2 = closest.squaredNorm();
+        if (distance2 <= std::numeric_limits<float>::epsilon() * 1e-4f)
+        {
+            result.intersecting = true;
+            break;
+        }
+
+        // Boxes have many coplanar vertices, on which rounding can make the simplex cycle
+        // instead of getting closer. Settle for the closest simplex seen so far if so.
+        if (distance2 >= previous_distance2)
+        {
+            simplex = previous;
+            break;
+        }
+
+        if (++result.num_iterations == max_gjk_iterations)
+        {
+            break;
+        }
+
+        // Stop once the furthest point towards the origin brings the simplex no closer
+        const auto vertex = support(a,
+                                    b,
+                                    relative_pose,
+                                    -closest,
+                                    simplex.vertices[0].index_a,
+                                    simplex.vertices[0].index_b);
+        if (distance2 - closest.dot(vertex.w) <= gjk_relative_tolerance * distance2 ||
+            simplex.contains(vertex))
+        {
+            break;
+        }
+
+        previous = simplex;
+        previous_distance2 = distance2;
+        simplex.vertices[simplex.size++] = vertex;
+    }
+
+    store(simplex, warm_start);
+
+    if (!result.intersecting)
+    {
+        for (int i = 0; i < simplex.size; ++i)
+        {
+            result.point_a += simplex.lambdas[i] * simplex.vertices[i].a;
+            result.point_b += simplex.lambdas[i] * simplex.vertices[i].b;
+        }
+        result.distance = (result.point_a - result.point_b).norm();
+    }
+
+    return result;
+}
+
+std::optional<Contact> epa(const CollisionShape& a,
+                           const CollisionShape& b,
+                           const Eigen::Isometry3f& relative_pose,
+                           const GjkSimplex& gjk_simplex)
+{
+    auto simplex = load(a, b, relative_pose, gjk_simplex);
+    if (!make_tetrahedron(a, b, relative_pose, simplex))
+    {
+        return std::nullopt;
+    }
+
+    // Reused across calls, so that only the first few queries on each thread allocate
+    static thread_local Polytope polytope;
+    polytope.vertices.assign(simplex.vertices.begin(), simplex.vertices.end());
+    polytope.faces.clear();
+
+    // Wind the faces of the tetrahedron outwards
+    if ((polytope.vertices[1].w - polytope.vertices[0].w)
+            .cross(polytope.vertices[2].w - polytope.vertices[0].w)
+            .dot(polytope.vertices[3].w - polytope.vertices[0].w) > 0.0f)
+    {
+        std::swap(polytope.vertices[1], polytope.vertices[2]);
+    }
+    if (!polytope.add_face(0, 1, 2) || !polytope.add_face(0, 3, 1) ||
+        !polytope.add_face(0, 2, 3) || !polytope.add_face(1, 3, 2))
+    {
+        return std::nullopt;
+    }
+
+    auto closest = polytope.faces.begin();
+    for (int iteration = 0; iteration < max_epa_iterations; ++iteration)
+    {
+        closest = std::min_element(
+            polytope.faces.begin(), polytope.faces.end(), [](const Face& lhs, const Face& rhs) {
+                return lhs.distance < rhs.distance;
+            });
+
+        const auto& start = polytope.vertices[closest->vertices[0]];
+        const auto vertex =
+            support(a, b, relative_pose, closest->normal, start.index_a, start.index_b);
+        if (closest->normal.dot(vertex.w) - closest->distance <= epa_tolerance)
+        {
+            break;
+        }
+
+        // Remove every face the new vertex sees, keeping the edges around the hole they leave
+        const auto index = static_cast<std::uint32_t>(polytope.vertices.size());
+        polytope.vertices.push_back(vertex);
+        polytope.horizon.clear();
+
+        for (auto it = polytope.faces.begin(); it != polytope.faces.end();)
+        {
+            if (it->normal.dot(vertex.w - polytope.vertices[it->vertices[0]].w) <= 0.0f)
+            {
+                ++it;
+                continue;
+            }
+
+            for (int e = 0; e < 3; ++e)
+            {
+                const auto edge = std::make_pair(it->vertices[e], it->vertices[(e + 1) % 3]);
+                const auto reverse = std::find(polytope.horizon.begin(),
+                                               polytope.horizon.end(),
+                                               std::make_pair(edge.second, edge.first));
+                if (reverse != polytope.horizon.end())
+                {
+                    *reverse = polytope.horizon.back();
+                    polytope.horizon.pop_back();
+                }
+                else
+                {
+                    polytope.horizon.push_back(edge);
+                }
+            }
+
+            *it = polytope.faces.back();
+            polytope.faces.pop_back();
+        }
+
+        for (const auto& [i, j] : polytope.horizon)
+        {
+            polytope.add_face(i, j, index);
+        }
+
+        if (polytope.faces.empty())
+        {
+            return std::nullopt;
+        }
+    }
+
+    closest = std::min_element(
+        polytope.faces.begin(), polytope.faces.end(), [](const Face& lhs, const Face& rhs) {
+            return lhs.distance < rhs.distance;
+        });
+
+    const auto& v0 = polytope.vertices[closest->vertices[0]];
+    const auto& v1 = polytope.vertices[closest->vertices[1]];
+    const auto& v2 = polytope.vertices[closest->vertices[2]];
+    const Eigen::Vector3f lambdas =
+        barycentric(closest->normal * closest->distance, v0.w, v1.w, v2.w);
+
+    return Contact{ closest->normal,
+                    closest->distance,
+                    lambdas[0] * v0.a + lambdas[1] * v1.a + lambdas[2] * v2.a,
+                    lambdas[0] * v0.b + lambdas[1] * v1.b + lambdas[2] * v2.b };
+}
+
+std::optional<Contact> contact_test(const CollisionShape& a,
+                                    const CollisionShape& b,
+                                    const Eigen::Isometry3f& relative_pose,
+                                    GjkSimplex& simplex)
+{
+    if (!gjk(a, b, relative_pose, simplex).intersecting)
+    {
+        return std::nullopt;
+    }
+    return epa(a, b, relative_pose, simplex);
+}
+}  // namespace geometry
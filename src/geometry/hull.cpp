@@ -0,0 +1,183 @@
+#include "geometry/hull.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <optional>
+#include <utility>
+
+namespace geometry
+{
+namespace
+{
+// Directions closer to parallel than about a quarter of a degree are merged. Dropping axes only
+// makes SAT more conservative, it never reports a false separation.
+constexpr float parallel_tolerance = 1e-5f;
+
+// Distance from a plane, relative to the size of the mesh, within which points are on it
+constexpr float plane_tolerance = 1e-4f;
+
+bool is_parallel(const Eigen::Vector3f& a, const Eigen::Vector3f& b)
+{
+    return std::abs(a.dot(b)) >= 1.0f - parallel_tolerance;
+}
+
+// Appends direction unless it is parallel to one already there
+void insert_direction(std::vector<Eigen::Vector3f>& directions, const Eigen::Vector3f& direction)
+{
+    if (std::none_of(directions.begin(), directions.end(), [&](const Eigen::Vector3f& other) {
+            return is_parallel(direction, other);
+        }))
+    {
+        directions.push_back(direction);
+    }
+}
+
+Eigen::Matrix3Xf to_matrix(const std::vector<Eigen::Vector3f>& directions)
+{
+    auto matrix = Eigen::Matrix3Xf(3, directions.size());
+    for (std::size_t i = 0; i < directions.size(); ++i)
+    {
+        matrix.col(i) = directions[i];
+    }
+    return matrix;
+}
+
+// Whether every vertex is on the same side of every triangle
+bool is_convex(const Eigen::Matrix3Xf& vertices,
+               const std::vector<std::tuple<int, int, int>>& triangles,
+               const std::vector<std::optional<Eigen::Vector3f>>& normals,
+               const float tolerance)
+{
+    for (std::size_t i = 0; i < triangles.size(); ++i)
+    {
+        if (!normals[i])
+        {
+            continue;
+        }
+
+        const Eigen::Vector3f origin = vertices.col(std::get<0>(triangles[i]));
+        const Eigen::VectorXf distances =
+            normals[i]->transpose() * (vertices.colwise() - origin);
+        if (distances.maxCoeff() > tolerance && distances.minCoeff() < -tolerance)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+}  // namespace
+
+Hull cook_hull(const Eigen::Matrix3Xf& vertices,
+               const std::vector<std::tuple<int, int, int>>& triangles)
+{
+    const float size = (vertices.rowwise().maxCoeff() - vertices.rowwise().minCoeff()).norm();
+    const float tolerance = plane_tolerance * size;
+
+    // Normals of all but degenerate triangles
+    std::vector<std::optional<Eigen::Vector3f>> normals;
+    normals.reserve(triangles.size());
+    for (const auto& [i, j, k] : triangles)
+    {
+        const Eigen::Vector3f normal =
+            (vertices.col(j) - vertices.col(i)).cross(vertices.col(k) - vertices.col(i));
+        if (normal.norm() > std::numeric_limits<float>::epsilon() * size * size)
+        {
+            normals.push_back(normal.normalized());
+        }
+        else
+        {
+            normals.push_back(std::nullopt);
+        }
+    }
+
+    // The triangles on either side of each edge, -1 if none
+    std::map<std::pair<int, int>, std::array<int, 2>> edge_triangles;
+    bool manifold = true;
+    for (std::size_t t = 0; t < triangles.size(); ++t)
+    {
+        const auto& [i, j, k] = triangles[t];
+        const std::array<std::pair<int, int>, 3> triangle_edges = {
+            { { i, j }, { j, k }, { k, i } }
+        };
+        for (const auto& [from, to] : triangle_edges)
+        {
+            auto& sides =
+                edge_triangles.emplace(std::minmax(from, to), std::array<int, 2>{ -1, -1 })
+                    .first->second;
+            if (sides[0] == -1)
+            {
+                sides[0] = static_cast<int>(t);
+            }
+            else if (sides[1] == -1)
+            {
+                sides[1] = static_cast<int>(t);
+            }
+            else
+            {
+                manifold = false;
+            }
+        }
+    }
+
+    std::vector<Eigen::Vector3f> face_normals;
+    for (const auto& normal : normals)
+    {
+        if (normal)
+        {
+            insert_direction(face_normals, *normal);
+        }
+    }
+
+    std::vector<Eigen::Vector3f> edges;
+    bool closed = true;
+    for (const auto& [edge, sides] : edge_triangles)
+    {
+        closed &= sides[1] != -1;
+
+        // An edge between coplanar triangles splits a face, and isn't an edge of the hull
+        if (sides[1] != -1 && normals[sides[0]] && normals[sides[1]] &&
+            is_parallel(*normals[sides[0]], *normals[sides[1]]))
+        {
+            continue;
+        }
+
+        const Eigen::Vector3f direction = vertices.col(edge.second) - vertices.col(edge.first);
+        if (direction.norm() > tolerance)
+        {
+            insert_direction(edges, direction.normalized());
+        }
+    }
+
+    auto hull = Hull{ to_matrix(face_normals), to_matrix(edges), {}, {} };
+
+    // Hill climbing only finds the support point if every vertex is on the surface of a closed,
+    // convex mesh
+    std::vector<std::vector<std::uint32_t>> adjacency(vertices.cols());
+    for (const auto& [edge, sides] : edge_triangles)
+    {
+        adjacency[edge.first].push_back(static_cast<std::uint32_t>(edge.second));
+        adjacency[edge.second].push_back(static_cast<std::uint32_t>(edge.first));
+    }
+
+    const bool connected = std::none_of(adjacency.begin(),
+                                        adjacency.end(),
+                                        [](const auto& neighbours) { return neighbours.empty(); });
+    if (!(manifold && closed && connected && is_convex(vertices, triangles, normals, tolerance)))
+    {
+        return hull;
+    }
+
+    hull.neighbour_offsets.reserve(adjacency.size() + 1);
+    hull.neighbour_offsets.push_back(0);
+    for (const auto& neighbours : adjacency)
+    {
+        hull.neighbours.insert(hull.neighbours.end(), neighbours.begin(), neighbours.end());
+        hull.neighbour_offsets.push_back(static_cast<std::uint32_t>(hull.neighbours.size()));
+    }
+
+    return hull;
+}
+}  // namespace geometry
@@ -0,0 +1,457 @@
+#include "geometry/motion_codec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace geometry
+{
+namespace
+{
+std::uint32_t mask(const int num_bits)
+{
+    return num_bits >= 32 ? ~0u : (1u << num_bits) - 1u;
+}
+
+std::int32_t max_for_bits(const int num_bits)
+{
+    return static_cast<std::int32_t>((1u << (num_bits - 1)) - 1u);
+}
+
+// Bits for the integers in [-max, max]
+int bits_for_max(const std::int32_t max)
+{
+    int num_bits = 1;
+    while (max_for_bits(num_bits) < max)
+    {
+        ++num_bits;
+    }
+    return num_bits;
+}
+}  // namespace
+
+BitWriter::BitWriter(std::vector<std::uint8_t>& out) : out(out)
+{
+}
+
+void BitWriter::write(const std::uint32_t value, const int num_bits)
+{
+    scratch |= static_cast<std::uint64_t>(value & mask(num_bits)) << scratch_bits;
+    scratch_bits += num_bits;
+    bits_written += num_bits;
+
+    while (scratch_bits >= 8)
+    {
+        out.push_back(static_cast<std::uint8_t>(scratch));
+        scratch >>= 8;
+        scratch_bits -= 8;
+    }
+}
+
+void BitWriter::write_bool(const bool value)
+{
+    write(value ? 1u : 0u, 1);
+}
+
+void BitWriter::flush()
+{
+    if (scratch_bits > 0)
+    {
+        out.push_back(static_cast<std::uint8_t>(scratch));
+    }
+    scratch = 0;
+    scratch_bits = 0;
+}
+
+std::size_t BitWriter::num_bits() const
+{
+    return bits_written;
+}
+
+BitReader::BitReader(const std::uint8_t* data, const std::size_t size) : data(data), size(size)
+{
+}
+
+BitReader::BitReader(const std::vector<std::uint8_t>& data) : BitReader(data.data(), data.size())
+{
+}
+
+std::uint32_t BitReader::read(const int num_bits)
+{
+    while (scratch_bits < num_bits)
+    {
+        if (byte == size)
+        {
+            throw std::runtime_error("Unexpected end of bit stream");
+        }
+        scratch |= static_cast<std::uint64_t>(data[byte++]) << scratch_bits;
+        scratch_bits += 8;
+    }
+
+    const auto value = static_cast<std::uint32_t>(scratch) & mask(num_bits);
+    scratch >>= num_bits;
+    scratch_bits -= num_bits;
+    return value;
+}
+
+bool BitReader::read_bool()
+{
+    return read(1) != 0;
+}
+
+bool MotionStateCodec::Quantized::operator==(const Quantized& other) const
+{
+    return position == other.position && orientation_index == other.orientation_index &&
+           orientation == other.orientation && velocity == other.velocity &&
+           acceleration == other.acceleration && angular_velocity == other.angular_velocity &&
+           angular_acceleration == other.angular_acceleration;
+}
+
+bool MotionStateCodec::Quantized::operator!=(const Quantized& other) const
+{
+    return !(*this == other);
+}
+
+MotionStateCodec::Field MotionStateCodec::Field::from_bits(const float range, const int num_bits)
+{
+    if (num_bits < 2 || num_bits > 31)
+    {
+        throw std::runtime_error("Quantized fields take between 2 and 31 bits");
+    }
+    if (!(range > 0.0f))
+    {
+        throw std::runtime_error("Quantized fields need a positive range");
+    }
+
+    const auto max = max_for_bits(num_bits);
+    const int delta_bits = std::max((num_bits + 1) / 2, 2);
+    return Field{
+        static_cast<float>(max) / range, num_bits, max, delta_bits, max_for_bits(delta_bits)
+    };
+}
+
+MotionStateCodec::Field MotionStateCodec::Field::from_resolution(const float range,
+                                                                 const float resolution)
+{
+    const auto steps = std::ceil(range / resolution);
+    if (!(steps >= 1.0f) || steps > static_cast<float>(max_for_bits(31)))
+    {
+        throw std::runtime_error("Position resolution doesn't fit 31 bits over the sector");
+    }
+
+    auto field = from_bits(range, bits_for_max(static_cast<std::int32_t>(steps)));
+    field.scale = 1.0f / resolution;
+    field.max = static_cast<std::int32_t>(steps);
+    return field;
+}
+
+// Zero stays exactly zero, so that resting bodies don't drift
+std::int32_t MotionStateCodec::Field::quantize(const float value) const
+{
+    if (std::isnan(value))
+    {
+        return 0;
+    }
+    const auto bound = static_cast<float>(max);
+    return static_cast<std::int32_t>(std::lround(std::clamp(value * scale, -bound, bound)));
+}
+
+float MotionStateCodec::Field::dequantize(const std::int32_t value) const
+{
+    return static_cast<float>(value) / scale;
+}
+
+void MotionStateCodec::Field::encode(const std::array<std::int32_t, 3>& value,
+                                     const std::array<std::int32_t, 3>* baseline,
+                                     BitWriter& writer) const
+{
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        if (baseline)
+        {
+            const auto delta = value[i] - (*baseline)[i];
+            const bool small = delta >= -max_delta && delta <= max_delta;
+            writer.write_bool(small);
+            if (small)
+            {
+                writer.write(static_cast<std::uint32_t>(delta + max_delta), delta_bits);
+                continue;
+            }
+        }
+        writer.write(static_cast<std::uint32_t>(value[i] + max), num_bits);
+    }
+}
+
+std::array<std::int32_t, 3>
+MotionStateCodec::Field::decode(const std::array<std::int32_t, 3>* baseline,
+                                BitReader& reader) const
+{
+    auto value = std::array<std::int32_t, 3>();
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        if (baseline && reader.read_bool())
+        {
+            value[i] = (*baseline)[i] + static_cast<std::int32_t>(reader.read(delta_bits)) -
+                       max_delta;
+        }
+        else
+        {
+            value[i] = static_cast<std::int32_t>(reader.read(num_bits)) - max;
+        }
+
+        if (value[i] < -max || value[i] > max)
+        {
+            throw std::runtime_error("Encoded motion state is out of range");
+        }
+    }
+    return value;
+}
+
+MotionStateCodec::MotionStateCodec(const Eigen::Vector3f& sector_origin,
+                                   const float sector_extent,
+                                   const Limits& limits,
+                                   const Precision& precision)
+  : sector_origin(sector_origin),
+    position(Field::from_resolution(sector_extent, precision.position_resolution)),
+    orientation(Field::from_bits(1.0f / std::sqrt(2.0f), precision.orientation_bits)),
+    velocity(Field::from_bits(limits.velocity, precision.velocity_bits)),
+    acceleration(Field::from_bits(limits.acceleration, precision.acceleration_bits)),
+    angular_velocity(Field::from_bits(limits.angular_velocity, precision.angular_velocity_bits)),
+    angular_acceleration(
+        Field::from_bits(limits.angular_acceleration, precision.angular_acceleration_bits))
+{
+}
+
+MotionStateCodec::MotionStateCodec(const Eigen::Vector3f& sector_origin,
+                                   const float sector_extent,
+                                   const Limits& limits)
+  : MotionStateCodec(sector_origin, sector_extent, limits, Precision())
+{
+}
+
+bool MotionStateCodec::keep_in_sector(MotionState& state) const
+{
+    // The largest offset a position quantizes to unclamped
+    const float extent = static_cast<float>(position.max) / position.scale;
+
+    bool outside = false;
+    for (int i = 0; i < 3; ++i)
+    {
+        const float offset = state.position[i] - sector_origin[i];
+        if (std::abs(offset) <= extent)
+        {
+            continue;
+        }
+
+        outside = true;
+        const float side = std::copysign(1.0f, offset);
+        state.position[i] = sector_origin[i] + side * extent;
+        if (state.velocity[i] * side > 0.0f)
+        {
+            state.velocity[i] = 0.0f;
+        }
+        if (state.acceleration[i] * side > 0.0f)
+        {
+            state.acceleration[i] = 0.0f;
+        }
+    }
+    return outside;
+}
+
+MotionStateCodec::Quantized MotionStateCodec::quantize(const MotionState& state) const
+{
+    const auto quantize_vector = [](const Field& field, const Eigen::Vector3f& value) {
+        return std::array<std::int32_t, 3>{ field.quantize(value.x()),
+                                            field.quantize(value.y()),
+                                            field.quantize(value.z()) };
+    };
+
+    auto out = Quantized();
+    out.position = quantize_vector(position, state.position - sector_origin);
+
+    // Smallest three: the largest component is at least 1/2, follows from the others, and can be
+    // made positive as q and -q are the same rotation. The others are then within +-1/sqrt(2).
+    const Eigen::Vector4f q = state.orientation.normalized().coeffs();
+    Eigen::Index largest;
+    q.cwiseAbs().maxCoeff(&largest);
+    const float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+
+    out.orientation_index = static_cast<std::uint32_t>(largest);
+    for (Eigen::Index i = 0, j = 0; i < 4; ++i)
+    {
+        if (i != largest)
+        {
+            out.orientation[j++] = orientation.quantize(sign * q[i]);
+        }
+    }
+
+    out.velocity = quantize_vector(velocity, state.velocity);
+    out.acceleration = quantize_vector(acceleration, state.acceleration);
+    out.angular_velocity = quantize_vector(angular_velocity, state.angular_velocity);
+    out.angular_acceleration = quantize_vector(angular_acceleration, state.angular_acceleration);
+    return out;
+}
+
+MotionState MotionStateCodec::dequantize(const Quantized& state) const
+{
+    const auto dequantize_vector = [](const Field& field,
+                                      const std::array<std::int32_t, 3>& value) {
+        return Eigen::Vector3f(
+            field.dequantize(value[0]), field.dequantize(value[1]), field.dequantize(value[2]));
+    };
+
+    auto out = MotionState();
+    out.position = sector_origin + dequantize_vector(position, state.position);
+
+    Eigen::Vector4f q;
+    float sum_of_squares = 0.0f;
+    for (Eigen::Index i = 0, j = 0; i < 4; ++i)
+    {
+        if (i != static_cast<Eigen::Index>(state.orientation_index))
+        {
+            q[i] = orientation.dequantize(state.orientation[j++]);
+            sum_of_squares += q[i] * q[i];
+        }
+    }
+    q[state.orientation_index] = std::sqrt(std::max(0.0f, 1.0f - sum_of_squares));
+    out.orientation.coeffs() = q.normalized();
+
+    out.velocity = dequantize_vector(velocity, state.velocity);
+    out.acceleration = dequantize_vector(acceleration, state.acceleration);
+    out.angular_velocity = dequantize_vector(angular_velocity, state.angular_velocity);
+    out.angular_acceleration = dequantize_vector(angular_acceleration, state.angular_acceleration);
+    return out;
+}
+
+void MotionStateCodec::encode(const Quantized& state,
+                              const Quantized* baseline,
+                              BitWriter& writer) const
+{
+    // Each field is preceded by whether it changed since the baseline, if there is one
+    const auto encode_vector = [&state, baseline, &writer](
+                                   const Field& field,
+                                   std::array<std::int32_t, 3> Quantized::*member) {
+        const auto* base = baseline ? &(baseline->*member) : nullptr;
+        if (base)
+        {
+            const bool changed = state.*member != *base;
+            writer.write_bool(changed);
+            if (!changed)
+            {
+                return;
+            }
+        }
+        field.encode(state.*member, base, writer);
+    };
+
+    encode_vector(position, &Quantized::position);
+
+    // Components are only comparable to the baseline's if they leave out the same one
+    const bool same_index = baseline && baseline->orientation_index == state.orientation_index;
+    const bool orientation_changed = !same_index || baseline->orientation != state.orientation;
+    if (baseline)
+    {
+        writer.write_bool(orientation_changed);
+    }
+    if (orientation_changed)
+    {
+        writer.write(state.orientation_index, 2);
+        orientation.encode(
+            state.orientation, same_index ? &baseline->orientation : nullptr, writer);
+    }
+
+    encode_vector(velocity, &Quantized::velocity);
+    encode_vector(acceleration, &Quantized::acceleration);
+    encode_vector(angular_velocity, &Quantized::angular_velocity);
+    encode_vector(angular_acceleration, &Quantized::angular_acceleration);
+}
+
+MotionStateCodec::Quantized MotionStateCodec::decode(const Quantized* baseline,
+                                                     BitReader& reader) const
+{
+    auto out = Quantized();
+
+    const auto decode_vector = [&out, baseline, &reader](
+                                   const Field& field,
+                                   std::array<std::int32_t, 3> Quantized::*member) {
+        const auto* base = baseline ? &(baseline->*member) : nullptr;
+        if (base && !reader.read_bool())
+        {
+            out.*member = *base;
+            return;
+        }
+        out.*member = field.decode(base, reader);
+    };
+
+    decode_vector(position, &Quantized::position);
+
+    if (baseline && !reader.read_bool())
+    {
+        out.orientation_index = baseline->orientation_index;
+        out.orientation = baseline->orientation;
+    }
+    else
+    {
+        out.orientation_index = reader.read(2);
+        const bool same_index = baseline && baseline->orientation_index == out.orientation_index;
+        out.orientation = orientation.decode(same_index ? &baseline->orientation : nullptr, reader);
+    }
+
+    decode_vector(velocity, &Quantized::velocity);
+    decode_vector(acceleration, &Quantized::acceleration);
+    decode_vector(angular_velocity, &Quantized::angular_velocity);
+    decode_vector(angular_acceleration, &Quantized::angular_acceleration);
+    return out;
+}
+
+int MotionStateCodec::max_bits() const
+{
+    return 3 * (position.num_bits + orientation.num_bits + velocity.num_bits +
+                acceleration.num_bits + angular_velocity.num_bits +
+                angular_acceleration.num_bits) +
+           2;
+}
+
+int MotionStateCodec::max_delta_bits() const
+{
+    // Each of the six fields adds whether it changed, and each of its components whether it is
+    // small enough for the delta, which never takes more bits than the value
+    return max_bits() + 6 * (1 + 3);
+}
+
+float MotionStateCodec::max_position_error() const
+{
+    // Plus the spacing of floats at the edge of the sector, which the position is rounded to
+    const float extent = static_cast<float>(position.max) / position.scale;
+    return 0.5f / position.scale + extent * std::numeric_limits<float>::epsilon();
+}
+
+float MotionStateCodec::max_orientation_error() const
+{
+    // With each of the three components off by e at most, the largest one, recomputed from them,
+    // is off by 3e at most, so the quaternion by sqrt(12)e, and the angle by twice that
+    const float e = 0.5f / orientation.scale;
+    return 2.0f * std::sqrt(12.0f) * e;
+}
+
+float MotionStateCodec::max_velocity_error() const
+{
+    return 0.5f / velocity.scale;
+}
+
+float MotionStateCodec::max_acceleration_error() const
+{
+    return 0.5f / acceleration.scale;
+}
+
+float MotionStateCodec::max_angular_velocity_error() const
+{
+    return 0.5f / angular_velocity.scale;
+}
+
+float MotionStateCodec::max_angular_acceleration_error() const
+{
+    return 0.5f / angular_acceleration.scale;
+}
+}  // namespace geometry
@@ -0,0 +1,220 @@
+#include "geometry/motion_state_arrays.h"
+
+#include "geometry/simd.h"
+
+namespace geometry
+{
+namespace
+{
+using simd::float8;
+using simd::lanes;
+using simd::load;
+using simd::store;
+
+struct Fields
+{
+    float* px;
+    float* py;
+    float* pz;
+    float* qw;
+    float* qx;
+    float* qy;
+    float* qz;
+    float* vx;
+    float* vy;
+    float* vz;
+    float* ax;
+    float* ay;
+    float* az;
+    float* wx;
+    float* wy;
+    float* wz;
+    float* alpha_x;
+    float* alpha_y;
+    float* alpha_z;
+};
+
+// T is either float (one entity) or float8 (eight entities). Only +, - and * are used, so both
+// give bit-identical results per entity.
+template <typename T>
+__attribute__((always_inline)) inline void integrate_lanes(const Fields& f,
+                                                           const std::size_t i,
+                                                           const float dt)
+{
+    const T zero = T{};
+    const T h = zero + dt;
+    const T half_h = zero + 0.5f * dt;
+
+    // Linear
+    const T vx = load<T>(f.vx + i) + load<T>(f.ax + i) * h;
+    const T vy = load<T>(f.vy + i) + load<T>(f.ay + i) * h;
+    const T vz = load<T>(f.vz + i) + load<T>(f.az + i) * h;
+    store(f.vx + i, vx);
+    store(f.vy + i, vy);
+    store(f.vz + i, vz);
+    store(f.px + i, load<T>(f.px + i) + vx * h);
+    store(f.py + i, load<T>(f.py + i) + vy * h);
+    store(f.pz + i, load<T>(f.pz + i) + vz * h);
+
+    // Angular
+    const T wx = load<T>(f.wx + i) + load<T>(f.alpha_x + i) * h;
+    const T wy = load<T>(f.wy + i) + load<T>(f.alpha_y + i) * h;
+    const T wz = load<T>(f.wz + i) + load<T>(f.alpha_z + i) * h;
+    store(f.wx + i, wx);
+    store(f.wy + i, wy);
+    store(f.wz + i, wz);
+
+    // exp(w * dt / 2) through the Taylor series of cos(x) and sin(x) / x, in terms of x^2.
+    // Per-tick rotations are far below a radian, where this is exact to float precision.
+    const T hx = wx * half_h;
+    const T hy = wy * half_h;
+    const T hz = wz * half_h;
+    const T x2 = hx * hx + hy * hy + hz * hz;
+    const T cos_x = 1.0f + x2 * (-1.0f / 2.0f + x2 * (1.0f / 24.0f + x2 * (-1.0f / 720.0f)));
+    const T sinc_x = 1.0f + x2 * (-1.0f / 6.0f + x2 * (1.0f / 120.0f + x2 * (-1.0f / 5040.0f)));
+    const T dw = cos_x;
+    const T dx = sinc_x * hx;
+    const T dy = sinc_x * hy;
+    const T dz = sinc_x * hz;
+
+    // q = dq * q
+    const T qw = load<T>(f.qw + i);
+    const T qx = load<T>(f.qx + i);
+    const T qy = load<T>(f.qy + i);
+    const T qz = load<T>(f.qz + i);
+    const T rw = dw * qw - dx * qx - dy * qy - dz * qz;
+    const T rx = dw * qx + dx * qw + dy * qz - dz * qy;
+    const T ry = dw * qy - dx * qz + dy * qw + dz * qx;
+    const T rz = dw * qz + dx * qy - dy * qx + dz * qw;
+
+    // Renormalize with one Newton step of 1 / sqrt(n) around n = 1, enough to stop drift
+    const T n = rw * rw + rx * rx + ry * ry + rz * rz;
+    const T inv_norm = 1.5f - 0.5f * n;
+    store(f.qw + i, rw * inv_norm);
+    store(f.qx + i, rx * inv_norm);
+    store(f.qy + i, ry * inv_norm);
+    store(f.qz + i, rz * inv_norm);
+}
+
+AWING_TARGET_CLONES
+void integrate_range(const Fields& f,
+                     const std::size_t begin,
+                     const std::size_t end,
+                     const float dt)
+{
+    std::size_t i = begin;
+    for (; i + lanes <= end; i += lanes)
+    {
+        integrate_lanes<float8>(f, i, dt);
+    }
+    for (; i < end; ++i)
+    {
+        integrate_lanes<float>(f, i, dt);
+    }
+}
+}  // namespace
+
+void MotionStateArrays::resize(const std::size_t size)
+{
+    for (auto* array : { &px, &py, &pz, &qw, &qx, &qy, &qz, &vx, &vy, &vz,
+                         &ax, &ay, &az, &wx, &wy, &wz, &alpha_x, &alpha_y, &alpha_z })
+    {
+        array->resize(size);
+    }
+}
+
+std::size_t MotionStateArrays::size() const
+{
+    return px.size();
+}
+
+void MotionStateArrays::load(const std::size_t i, const MotionState& state)
+{
+    px[i] = state.position.x();
+    py[i] = state.position.y();
+    pz[i] = state.position.z();
+    qw[i] = state.orientation.w();
+    qx[i] = state.orientation.x();
+    qy[i] = state.orientation.y();
+    qz[i] = state.orientation.z();
+    vx[i] = state.velocity.x();
+    vy[i] = state.velocity.y();
+    vz[i] = state.velocity.z();
+    ax[i] = state.acceleration.x();
+    ay[i] = state.acceleration.y();
+    az[i] = state.acceleration.z();
+    wx[i] = state.angular_velocity.x();
+    wy[i] = state.angular_velocity.y();
+    wz[i] = state.angular_velocity.z();
+    alpha_x[i] = state.angular_acceleration.x();
+    alpha_y[i] = state.angular_acceleration.y();
+    alpha_z[i] = state.angular_acceleration.z();
+}
+
+void MotionStateArrays::store(const std::size_t i, MotionState& state) const
+{
+    state.position = Eigen::Vector3f(px[i], py[i], pz[i]);
+    state.orientation = Eigen::Quaternionf(qw[i], qx[i], qy[i], qz[i]);
+    state.velocity = Eigen::Vector3f(vx[i], vy[i], vz[i]);
+    state.acceleration = Eigen::Vector3f(ax[i], ay[i], az[i]);
+    state.angular_velocity = Eigen::Vector3f(wx[i], wy[i], wz[i]);
+    state.angular_acceleration = Eigen::Vector3f(alpha_x[i], alpha_y[i], alpha_z[i]);
+}
+
+void MotionStateArrays::integrate(const float dt, const std::size_t begin, const std::size_t end)
+{
+    auto fields = Fields();
+    fields.px = px.data();
+    fields.py = py.data();
+    fields.pz = pz.data();
+    fields.qw = qw.data();
+    fields.qx = qx.data();
+    fields.qy = qy.data();
+    fields.qz = qz.data();
+    fields.vx = vx.data();
+    fields.vy = vy.data();
+    fields.vz = vz.data();
+    fields.ax = ax.data();
+    fields.ay = ay.data();
+    fields.az = az.data();
+    fields.wx = wx.data();
+    fields.wy = wy.data();
+    fields.wz = wz.data();
+    fields.alpha_x = alpha_x.data();
+    fields.alpha_y = alpha_y.data();
+    fields.alpha_z = alpha_z.data();
+
+    integrate_range(fields, begin, end, dt);
+}
+
+void MotionStateArrays::integrate(const float dt)
+{
+    integrate(dt, 0, size());
+}
+
+void integrate_motion_state(MotionState& state, const float dt)
+{
+    auto fields = Fields();
+    fields.px = &state.position.x();
+    fields.py = &state.position.y();
+    fields.pz = &state.position.z();
+    fields.qw = &state.orientation.w();
+    fields.qx = &state.orientation.x();
+    fields.qy = &state.orientation.y();
+    fields.qz = &state.orientation.z();
+    fields.vx = &state.velocity.x();
+    fields.vy = &state.velocity.y();
+    fields.vz = &state.velocity.z();
+    fields.ax = &state.acceleration.x();
+    fields.ay = &state.acceleration.y();
+    fields.az = &state.acceleration.z();
+    fields.wx = &state.angular_velocity.x();
+    fields.wy = &state.angular_velocity.y();
+    fields.wz = &state.angular_velocity.z();
+    fields.alpha_x = &state.angular_acceleration.x();
+    fields.alpha_y = &state.angular_acceleration.y();
+    fields.alpha_z = &state.angular_acceleration.z();
+
+    integrate_lanes<float>(fields, 0, dt);
+}
+}  // namespace geometry
@@ -0,0 +1,76 @@
+#include "jobs/task_graph.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace jobs
+{
+namespace
+{
+bool overlaps(const TaskGraph::Access& a, const TaskGraph::Access& b)
+{
+    return std::any_of(a.begin(), a.end(), [&b](const std::type_index& type) {
+        return std::find(b.begin(), b.end(), type) != b.end();
+    });
+}
+}  // namespace
+
+std::size_t TaskGraph::add(const Access& reads, const Access& writes, const bool exclusive)
+{
+    const std::size_t index = tasks.size();
+    auto task = Task{ reads, writes, {}, 0 };
+
+    // Tasks are added in an order they could run in one after the other, so a task only ever
+    // depends on earlier ones, and goes in a wave after theirs
+    std::size_t first_wave = 0;
+    for (std::size_t i = 0; i < tasks.size(); ++i)
+    {
+        const auto& other = tasks[i];
+        if (overlaps(other.writes, reads) || overlaps(other.writes, writes) ||
+            overlaps(other.reads, writes))
+        {
+            task.dependencies.push_back(i);
+            first_wave = std::max(first_wave, other.wave + 1);
+        }
+    }
+
+    // The earliest wave it can share, or a new one
+    task.wave = waves.size();
+    if (!exclusive)
+    {
+        for (auto wave = first_wave; wave < waves.size(); ++wave)
+        {
+            if (!exclusive_waves[wave])
+            {
+                task.wave = wave;
+                break;
+            }
+        }
+    }
+
+    if (task.wave == waves.size())
+    {
+        waves.emplace_back();
+        exclusive_waves.push_back(exclusive);
+    }
+    waves[task.wave].push_back(index);
+
+    tasks.push_back(std::move(task));
+    return index;
+}
+
+std::size_t TaskGraph::size() const
+{
+    return tasks.size();
+}
+
+const std::vector<std::size_t>& TaskGraph::get_dependencies(const std::size_t task) const
+{
+    return tasks[task].dependencies;
+}
+
+const std::vector<std::vector<std::size_t>>& TaskGraph::get_waves() const
+{
+    return waves;
+}
+}  // namespace jobs
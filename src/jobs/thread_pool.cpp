@@ -0,0 +1,134 @@
+#include "jobs/thread_pool.h"
+
+#include <algorithm>
+
+namespace jobs
+{
+namespace
+{
+// Whether the thread is running a chunk, of any pool
+thread_local bool in_chunk = false;
+}  // namespace
+
+ThreadPool::ThreadPool(std::size_t num_threads)
+{
+    if (num_threads == 0)
+    {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (std::size_t i = 1; i < num_threads; ++i)
+    {
+        workers.emplace_back(&ThreadPool::work_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work_cv.notify_all();
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+std::size_t ThreadPool::num_threads() const
+{
+    return workers.size() + 1;
+}
+
+void ThreadPool::run(const std::size_t count,
+                     const std::size_t grain_size,
+                     ChunkFn fn,
+                     void* ctx)
+{
+    const std::size_t grain = std::max<std::size_t>(grain_size, 1);
+
+    // Not worth waking anybody up for. From inside a chunk, the workers may all be busy with the
+    // job that chunk is part of.
+    if (workers.empty() || count <= grain || in_chunk)
+    {
+        if (count > 0)
+        {
+            fn(ctx, 0, count);
+        }
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        // Workers still draining the previous job may be reading its fields
+        done_cv.wait(lock, [this]() { return active_workers == 0; });
+
+        job_fn = fn;
+        job_ctx = ctx;
+        job_count = count;
+        job_grain_size = grain;
+        job_num_chunks = (count + grain - 1) / grain;
+        next_chunk = 0;
+        completed_chunks = 0;
+        ++generation;
+    }
+    work_cv.notify_all();
+
+    execute_chunks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [this]() { return completed_chunks == job_num_chunks; });
+}
+
+void ThreadPool::work_loop()
+{
+    std::size_t seen_generation = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_cv.wait(lock, [&]() { return stopping || generation != seen_generation; });
+            if (stopping)
+            {
+                return;
+            }
+            seen_generation = generation;
+            ++active_workers;
+        }
+
+        execute_chunks();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --active_workers;
+        }
+        done_cv.notify_all();
+    }
+}
+
+void ThreadPool::execute_chunks()
+{
+    std::size_t num_completed = 0;
+
+    in_chunk = true;
+    for (auto chunk = next_chunk++; chunk < job_num_chunks; chunk = next_chunk++)
+    {
+        const auto begin = chunk * job_grain_size;
+        const auto end = std::min(begin + job_grain_size, job_count);
+        job_fn(job_ctx, begin, end);
+        ++num_completed;
+    }
+    in_chunk = false;
+
+    if (num_completed &&
+        completed_chunks.fetch_add(num_completed) + num_completed == job_num_chunks)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done_cv.notify_all();
+    }
+}
+}  // namespace jobs
@@ -1,60 +1,197 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
 #include "rendering/context_manager.h"
+#include "ecs/profiler_overlay.h"
+#include "ecs/render_snapshot.h"
+#include "ecs/replay.h"
 #include "ecs/scene_factory.h"
 #include "ecs/systems.h"
 #include "input/key_event.h"
+#include "jobs/triple_buffer.h"
+#include "profiling/profiler.h"
+#include "profiling/trace.h"
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+// Hands key events from the render thread, which polls SDL, to the simulation thread
+class KeyEventQueue
+{
+  public:
+    void push(const std::vector<KeyEvent>& key_events)
+    {
+        const auto lock = std::lock_guard(mutex);
+        pending.insert(pending.end(), key_events.begin(), key_events.end());
+    }
+
+    // Everything pushed since the last call
+    std::vector<KeyEvent> take()
+    {
+        const auto lock = std::lock_guard(mutex);
+        return std::exchange(pending, {});
+    }
+
+  private:
+    std::mutex mutex;
+    std::vector<KeyEvent> pending;
+};
+
+// The file given by --record <file>, if any
+std::optional<std::string> get_record_filename(int argc, char* argv[])
+{
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--record")
+        {
+            return argv[i + 1];
+        }
+    }
+    return std::nullopt;
+}
+
+// Steps the scene by dt in real time until should_shutdown is set, publishing a snapshot after
+// every tick, and recording it if there is a recorder. Ticks that fall behind are caught up back to
+// back.
+void run_simulation(ecs::Scene& scene,
+                    const float dt,
+                    KeyEventQueue& key_events,
+                    jobs::TripleBuffer<ecs::RenderSnapshot>& snapshots,
+                    ecs::ReplayRecorder* recorder,
+                    const std::atomic<bool>& should_shutdown)
+{
+    profiling::TraceRecorder::get().set_thread_name("simulation");
+
+    const auto tick = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(dt));
+    auto next_tick = Clock::now() + tick;
+    float t = 0.0f;
+
+    while (!should_shutdown.load(std::memory_order_relaxed))
+    {
+        std::this_thread::sleep_until(next_tick);
+        next_tick += tick;
+
+        ecs::systems::handle_key_events(scene, key_events.take());
+        if (recorder)
+        {
+            recorder->record(scene, t);
+        }
+        ecs::systems::integrate(scene, t, dt);
+        t += dt;
+
+        ecs::systems::publish_snapshot(scene, t, dt, snapshots.write_buffer());
+        snapshots.publish();
+    }
+}
+}  // namespace
 
 int main(int argc, char* argv[])
 {
+    profiling::init_tracing(argc, argv);
+
+    const auto record_filename = get_record_filename(argc, argv);
+
     auto context_manager = rendering::ContextManager("Main Window", 1200, 900);
 
-    auto scene = ecs::SceneFactory::create_from_scenario("scenario");
+    // Loads every GL resource, so has to happen on this thread, before the simulation starts
+    const std::string scenario_name = "scenario";
+    auto scene = ecs::SceneFactory::create_from_scenario(scenario_name);
     scene->register_spline(Eigen::Vector3f(0.0f, 0.0f, 0.0f),
                            Eigen::Vector3f(50.0f, 0.0f, 0.0f),
                            Eigen::Vector3f(50.0f, 50.0f, 0.0f),
                            Eigen::Vector3f(100.0f, 50.0f, 0.0f));
 
-    float current_time = SDL_GetTicks() / 1000.0f;
     const float dt = 1.0f / 60.f;
-    float t = 0.0f;
-    float accumulator = 0.0f;
 
-    bool should_shutdown = false;
-    while (!should_shutdown)
+    // The simulation runs on its own thread, and this one only ever touches the scene through the
+    // snapshots it publishes, plus the shaders and models of its resource manager
+    auto snapshots = jobs::TripleBuffer<ecs::RenderSnapshot>();
+    ecs::systems::publish_snapshot(*scene, 0.0f, dt, snapshots.write_buffer());
+    snapshots.publish();
+
+    // Replayed with awing_replay
+    auto recorder = std::unique_ptr<ecs::ReplayRecorder>();
+    if (record_filename)
+    {
+        recorder = std::make_unique<ecs::ReplayRecorder>(*record_filename, scenario_name, dt);
+    }
+
+    auto key_events = KeyEventQueue();
+    auto should_shutdown = std::atomic<bool>(false);
+    auto simulation = std::thread(run_simulation,
+                                  std::ref(*scene),
+                                  dt,
+                                  std::ref(key_events),
+                                  std::ref(snapshots),
+                                  recorder.get(),
+                                  std::cref(should_shutdown));
+
+    bool show_profiler = false;  // Toggled with F3
+
+    while (!should_shutdown.load(std::memory_order_relaxed))
     {
-        float new_time = SDL_GetTicks() / 1000.0f;
-        float frameTime = new_time - current_time;
-        current_time = new_time;
+        AWING_PROFILE_SCOPE("frame");
+
+        // Drawn between the two most recent ticks, by how far the clock is into the next one
+        const auto& snapshot = snapshots.read();
+        const float alpha = std::clamp(
+            std::chrono::duration<float>(Clock::now() - snapshot.published_at).count() / dt,
+            0.0f,
+            1.0f);
 
-        accumulator += frameTime;
+        ecs::systems::render(snapshot, scene->resource_manager, alpha);
 
-        while (accumulator >= dt)
+        if (show_profiler)
         {
-            ecs::systems::integrate(*scene, t, dt);
-            accumulator -= dt;
-            t += dt;
+            context_manager.imgui_new_frame();
+            ecs::draw_profiler_overlay(snapshot);
+            context_manager.imgui_render();
         }
 
-        ecs::systems::render(*scene, t);
-
         SDL_GL_SwapWindow(context_manager.window);
 
-        std::vector<KeyEvent> key_events;
+        std::vector<KeyEvent> new_key_events;
         SDL_Event event;
         while (SDL_PollEvent(&event))
         {
+            context_manager.imgui_process_event(event);
+
             if (event.type == SDL_QUIT ||
                 (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE))
             {
-                should_shutdown = true;
+                should_shutdown.store(true, std::memory_order_relaxed);
+            }
+            if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F3 && !event.key.repeat)
+            {
+                show_profiler = !show_profiler;
             }
             if ((event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) && !event.key.repeat)
             {
-                key_events.emplace_back(static_cast<char>(event.key.keysym.sym),
-                                        event.type == SDL_KEYDOWN ? KeyEvent::Status::PRESSED :
-                                                                    KeyEvent::Status::RELEASED);
+                new_key_events.emplace_back(static_cast<char>(event.key.keysym.sym),
+                                            event.type == SDL_KEYDOWN ?
+                                                KeyEvent::Status::PRESSED :
+                                                KeyEvent::Status::RELEASED);
             }
         }
 
-        ecs::systems::handle_key_events(*scene, key_events);
+        key_events.push(new_key_events);
+    }
+
+    simulation.join();
+
+    if (recorder)
+    {
+        recorder->finish();
     }
+
+    profiling::TraceRecorder::get().write();
 }
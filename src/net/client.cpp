@@ -0,0 +1,212 @@
+#include "net/client.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+namespace net
+{
+GameClient::GameClient(const Address& server) : server(server)
+{
+    for (auto& snapshot : received)
+    {
+        snapshot.tick = no_tick;
+    }
+}
+
+void GameClient::connect()
+{
+    if (connected())
+    {
+        return;
+    }
+
+    outgoing.clear();
+    write_hello(outgoing);
+    socket.send(server, outgoing.data(), outgoing.size());
+    bytes_sent += outgoing.size();
+}
+
+bool GameClient::connected() const
+{
+    return welcome.has_value();
+}
+
+bool GameClient::poll()
+{
+    const auto previous_tick = latest_tick;
+
+    Address from;
+    incoming.resize(max_packet_size);
+    while (const auto size = socket.receive(from, incoming.data(), incoming.size()))
+    {
+        incoming.resize(*size);
+        if (from != server)
+        {
+            incoming.resize(max_packet_size);
+            continue;
+        }
+        bytes_received += *size;
+
+        const auto type = read_packet_type(incoming);
+        if (type == PacketType::WELCOME && !welcome)
+        {
+            welcome = read_welcome(incoming);
+            codec.emplace(Eigen::Vector3f::Zero(), welcome->sector_extent, welcome->limits);
+        }
+        else if (type == PacketType::SNAPSHOT && welcome)
+        {
+            handle_snapshot_part();
+        }
+
+        incoming.resize(max_packet_size);
+    }
+
+    return latest_tick != previous_tick;
+}
+
+std::uint32_t GameClient::send_input(const urdf::FighterInput::Actions& actions)
+{
+    if (!connected())
+    {
+        throw std::runtime_error("Sending input before connecting");
+    }
+
+    const auto sequence = next_sequence++;
+    unapplied_inputs.push_back(static_cast<std::uint16_t>(actions.to_ulong()));
+    if (unapplied_inputs.size() > max_inputs_per_packet)
+    {
+        unapplied_inputs.pop_front();
+    }
+
+    auto input = Input();
+    input.client_id = welcome->client_id;
+    input.acked_tick = latest_tick;
+    input.sequence = sequence;
+    input.actions.assign(unapplied_inputs.begin(), unapplied_inputs.end());
+
+    outgoing.clear();
+    write_input(input, outgoing);
+    socket.send(server, outgoing.data(), outgoing.size());
+    bytes_sent += outgoing.size();
+
+    return sequence;
+}
+
+const Welcome& GameClient::get_welcome() const
+{
+    return welcome.value();
+}
+
+const geometry::MotionStateCodec& GameClient::get_codec() const
+{
+    return codec.value();
+}
+
+const Snapshot* GameClient::get_latest_snapshot() const
+{
+    return latest_tick == no_tick ? nullptr : &received[latest_tick % history_size];
+}
+
+std::uint64_t GameClient::get_bytes_sent() const
+{
+    return bytes_sent;
+}
+
+std::uint64_t GameClient::get_bytes_received() const
+{
+    return bytes_received;
+}
+
+void GameClient::handle_snapshot_part()
+{
+    const auto find_baseline = [this](const std::uint32_t tick) -> const Snapshot* {
+        const auto& snapshot = received[tick % history_size];
+        return snapshot.tick == tick ? &snapshot : nullptr;
+    };
+
+    // One the server encoded against a baseline that has since been overwritten can't be decoded,
+    // and the server sends the next ones in full once it stops hearing about it
+    auto part = read_snapshot_part(incoming, find_baseline, *codec);
+    if (!part || (latest_tick != no_tick && part->snapshot.tick <= latest_tick))
+    {
+        return;
+    }
+
+    if (part->num_parts == 1)
+    {
+        complete(std::move(part->snapshot));
+        return;
+    }
+
+    auto assembly =
+        std::find_if(assemblies.begin(), assemblies.end(), [&part](const Assembly& assembly) {
+            return assembly.snapshot.tick == part->snapshot.tick;
+        });
+    if (assembly == assemblies.end())
+    {
+        if (assemblies.size() == max_assemblies)
+        {
+            assemblies.erase(assemblies.begin());
+        }
+
+        // Ticks arrive out of order now and then
+        assembly = std::find_if(
+            assemblies.begin(), assemblies.end(), [&part](const Assembly& assembly) {
+                return assembly.snapshot.tick > part->snapshot.tick;
+            });
+        assembly = assemblies.insert(assembly, Assembly());
+        assembly->snapshot.tick = part->snapshot.tick;
+        assembly->snapshot.last_input = part->snapshot.last_input;
+        assembly->received.resize(part->num_parts);
+    }
+
+    if (assembly->received.size() != part->num_parts || assembly->received[part->index])
+    {
+        return;
+    }
+    assembly->received[part->index] = true;
+    ++assembly->num_received;
+
+    auto& states = assembly->snapshot.states;
+    states.insert(states.end(), part->snapshot.states.begin(), part->snapshot.states.end());
+
+    if (assembly->num_received == assembly->received.size())
+    {
+        std::sort(states.begin(), states.end(), [](const auto& a, const auto& b) {
+            return a.first < b.first;
+        });
+        auto snapshot = std::move(assembly->snapshot);
+        assemblies.erase(assemblies.begin(), std::next(assembly));
+        complete(std::move(snapshot));
+    }
+}
+
+void GameClient::complete(Snapshot snapshot)
+{
+    // Those older can't become the latest any more
+    assemblies.erase(std::remove_if(assemblies.begin(),
+                                    assemblies.end(),
+                                    [&snapshot](const Assembly& assembly) {
+                                        return assembly.snapshot.tick <= snapshot.tick;
+                                    }),
+                     assemblies.end());
+
+    // The server has applied these, so they needn't be sent again
+    if (snapshot.last_input != no_tick)
+    {
+        const auto first_unapplied =
+            next_sequence - static_cast<std::uint32_t>(unapplied_inputs.size());
+        const auto num_applied = std::min<std::size_t>(
+            unapplied_inputs.size(),
+            snapshot.last_input + 1 > first_unapplied ? snapshot.last_input + 1 - first_unapplied
+                                                       : 0);
+        unapplied_inputs.erase(unapplied_inputs.begin(),
+                               unapplied_inputs.begin() + static_cast<std::ptrdiff_t>(num_applied));
+    }
+
+    latest_tick = snapshot.tick;
+    received[latest_tick % history_size] = std::move(snapshot);
+}
+}  // namespace net
@@ -0,0 +1,120 @@
+#include "net/prediction.h"
+
+#include <algorithm>
+
+#include "ecs/components.h"
+#include "profiling/profiler.h"
+
+namespace net
+{
+FighterPrediction::FighterPrediction(const urdf::FighterModel& model,
+                                     const geometry::MotionStateCodec& codec,
+                                     const float dt)
+  : model(model), codec(codec), dt(dt)
+{
+}
+
+void FighterPrediction::predict(const std::uint32_t sequence,
+                                const urdf::FighterInput::Actions& actions)
+{
+    if (num_entries == capacity)
+    {
+        first = (first + 1) % capacity;
+        --num_entries;
+    }
+
+    auto& entry = at(num_entries++);
+    entry.sequence = sequence;
+    entry.actions = static_cast<std::uint16_t>(actions.to_ulong());
+
+    if (state)
+    {
+        entry.state = step(*state, entry.actions);
+        state = codec.dequantize(entry.state);
+    }
+}
+
+std::size_t FighterPrediction::reconcile(const Snapshot& snapshot, const entt::entity entity)
+{
+    const auto server_state = std::lower_bound(
+        snapshot.states.begin(),
+        snapshot.states.end(),
+        entity,
+        [](const auto& entry, const entt::entity value) { return entry.first < value; });
+    if (server_state == snapshot.states.end() || server_state->first != entity)
+    {
+        return 0;
+    }
+
+    // Drops the inputs the server has applied, keeping the state predicted after the last of them
+    const Entry* last_applied = nullptr;
+    if (snapshot.last_input != no_tick)
+    {
+        while (num_entries > 0 && at(0).sequence <= snapshot.last_input)
+        {
+            if (at(0).sequence == snapshot.last_input)
+            {
+                last_applied = &at(0);
+            }
+            first = (first + 1) % capacity;
+            --num_entries;
+        }
+    }
+
+    // Before the first of the client's inputs, the server has nothing a prediction could match
+    if (state && last_applied && last_applied->state == server_state->second)
+    {
+        return 0;
+    }
+
+    AWING_PROFILE_SCOPE("rollback_prediction");
+
+    ++num_corrections;
+    state = codec.dequantize(server_state->second);
+    for (std::size_t i = 0; i < num_entries; ++i)
+    {
+        auto& entry = at(i);
+        entry.state = step(*state, entry.actions);
+        state = codec.dequantize(entry.state);
+    }
+
+    return num_entries;
+}
+
+const geometry::MotionState* FighterPrediction::get_state() const
+{
+    return state ? &*state : nullptr;
+}
+
+std::size_t FighterPrediction::get_num_pending() const
+{
+    return num_entries;
+}
+
+std::uint64_t FighterPrediction::get_num_corrections() const
+{
+    return num_corrections;
+}
+
+geometry::MotionStateCodec::Quantized FighterPrediction::step(const geometry::MotionState& from,
+                                                              const std::uint16_t actions)
+{
+    // As systems::integrate_motion and then systems::control_fighters, with the same arithmetic
+    auto next = from;
+    next.integrate(dt);
+
+    input.set_actions(urdf::FighterInput::Actions(actions));
+    next = ship_controller.update(
+        next, FighterComponent::get_target_state(model, input, next), dt);
+    model.apply_motion_limits(next);
+
+    // And GameServer::capture_snapshot
+    codec.keep_in_sector(next);
+    return codec.quantize(next);
+}
+
+FighterPrediction::Entry& FighterPrediction::at(const std::size_t i)
+{
+    return entries[(first + i) % capacity];
+}
+}  // namespace net
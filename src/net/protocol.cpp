@@ -0,0 +1,239 @@
+#include "net/protocol.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "ecs/binary_io.h"
+
+namespace net
+{
+namespace
+{
+using Quantized = geometry::MotionStateCodec::Quantized;
+
+// Type, tick, baseline tick, last input, part index, number of parts and number of states
+constexpr std::size_t snapshot_header_size = 19;
+constexpr std::size_t num_parts_offset = 15;
+
+// Reads a packet's fields after checking its type
+ecs::BinaryReader open(const std::vector<char>& packet, const PacketType type)
+{
+    auto reader = ecs::BinaryReader(packet);
+    if (reader.read<PacketType>() != type)
+    {
+        throw std::runtime_error("Unexpected packet type");
+    }
+    return reader;
+}
+
+// Finds the baselines of a snapshot's states, which are sorted by entity like the baseline's, so
+// that each takes a single walk through the baseline's states. The decoder finds the same ones.
+class BaselineCursor
+{
+  public:
+    explicit BaselineCursor(const Snapshot* baseline) : baseline(baseline)
+    {
+    }
+
+    const Quantized* find(const entt::entity entity)
+    {
+        if (!baseline)
+        {
+            return nullptr;
+        }
+
+        // A snapshot part starts somewhere in the middle
+        const auto& states = baseline->states;
+        if (next == 0)
+        {
+            next = static_cast<std::size_t>(
+                std::lower_bound(states.begin(),
+                                 states.end(),
+                                 entity,
+                                 [](const auto& state, const entt::entity value) {
+                                     return state.first < value;
+                                 }) -
+                states.begin());
+        }
+        while (next < states.size() && states[next].first < entity)
+        {
+            ++next;
+        }
+        return next < states.size() && states[next].first == entity ? &states[next].second
+                                                                     : nullptr;
+    }
+
+  private:
+    const Snapshot* baseline;
+    std::size_t next = 0;
+};
+}  // namespace
+
+std::optional<PacketType> read_packet_type(const std::vector<char>& packet)
+{
+    if (packet.empty() || static_cast<std::uint8_t>(packet[0]) >
+                              static_cast<std::uint8_t>(PacketType::SNAPSHOT))
+    {
+        return std::nullopt;
+    }
+    return static_cast<PacketType>(packet[0]);
+}
+
+void write_hello(std::vector<char>& out)
+{
+    auto writer = ecs::BinaryWriter(out);
+    writer.write(PacketType::HELLO);
+    writer.write(protocol_magic);
+}
+
+bool read_hello(const std::vector<char>& packet)
+{
+    auto reader = open(packet, PacketType::HELLO);
+    return reader.read<std::uint32_t>() == protocol_magic;
+}
+
+void write_welcome(const Welcome& welcome, std::vector<char>& out)
+{
+    auto writer = ecs::BinaryWriter(out);
+    writer.write(PacketType::WELCOME);
+    writer.write(welcome);
+}
+
+Welcome read_welcome(const std::vector<char>& packet)
+{
+    return open(packet, PacketType::WELCOME).read<Welcome>();
+}
+
+void write_input(const Input& input, std::vector<char>& out)
+{
+    auto writer = ecs::BinaryWriter(out);
+    writer.write(PacketType::INPUT);
+    writer.write(input.client_id);
+    writer.write(input.acked_tick);
+    writer.write(input.sequence);
+    writer.write(static_cast<std::uint8_t>(input.actions.size()));
+    writer.write_bytes(input.actions.data(), input.actions.size() * sizeof(std::uint16_t));
+}
+
+Input read_input(const std::vector<char>& packet)
+{
+    auto reader = open(packet, PacketType::INPUT);
+    auto input = Input();
+    input.client_id = reader.read<std::uint32_t>();
+    input.acked_tick = reader.read<std::uint32_t>();
+    input.sequence = reader.read<std::uint32_t>();
+    reader.read_array(input.actions, reader.read<std::uint8_t>());
+    if (input.actions.size() > max_inputs_per_packet || input.actions.size() > input.sequence + 1u)
+    {
+        throw std::runtime_error("Input packet has a corrupt action count");
+    }
+    return input;
+}
+
+void write_snapshot(const Snapshot& snapshot,
+                    const Snapshot* baseline,
+                    const geometry::MotionStateCodec& codec,
+                    std::vector<std::vector<char>>& packets)
+{
+    // Parts are closed before a state could overflow them, whatever its size
+    const auto max_state_bits =
+        static_cast<std::size_t>(32 + (baseline ? codec.max_delta_bits() : codec.max_bits()));
+    const auto max_bits = 8 * (max_snapshot_packet_size - snapshot_header_size);
+
+    std::vector<std::uint8_t> bits;
+    auto cursor = BaselineCursor(baseline);
+    std::size_t num_parts = 0;
+    std::size_t begin = 0;
+    while (begin < snapshot.states.size() || num_parts == 0)
+    {
+        bits.clear();
+        auto bit_writer = geometry::BitWriter(bits);
+        auto end = begin;
+        for (; end < snapshot.states.size() && bit_writer.num_bits() + max_state_bits <= max_bits;
+             ++end)
+        {
+            const auto& [entity, state] = snapshot.states[end];
+            bit_writer.write(entt::to_integral(entity), 32);
+            codec.encode(state, cursor.find(entity), bit_writer);
+        }
+        bit_writer.flush();
+
+        if (packets.size() == num_parts)
+        {
+            packets.emplace_back();
+        }
+        auto& packet = packets[num_parts];
+        packet.clear();
+
+        auto writer = ecs::BinaryWriter(packet);
+        writer.write(PacketType::SNAPSHOT);
+        writer.write(snapshot.tick);
+        writer.write(baseline ? baseline->tick : no_tick);
+        writer.write(snapshot.last_input);
+        writer.write(static_cast<std::uint16_t>(num_parts));
+        writer.write(std::uint16_t(0));  // The number of parts, once known
+        writer.write(static_cast<std::uint16_t>(end - begin));
+        writer.write_bytes(bits.data(), bits.size());
+
+        ++num_parts;
+        begin = end;
+    }
+    packets.resize(num_parts);
+
+    const auto num_parts_value = static_cast<std::uint16_t>(num_parts);
+    for (auto& packet : packets)
+    {
+        std::memcpy(packet.data() + num_parts_offset, &num_parts_value, sizeof(num_parts_value));
+    }
+}
+
+std::optional<SnapshotPart>
+read_snapshot_part(const std::vector<char>& packet,
+                   const std::function<const Snapshot*(std::uint32_t tick)>& find_baseline,
+                   const geometry::MotionStateCodec& codec)
+{
+    auto reader = open(packet, PacketType::SNAPSHOT);
+    auto part = SnapshotPart();
+    part.snapshot.tick = reader.read<std::uint32_t>();
+    const auto baseline_tick = reader.read<std::uint32_t>();
+    part.snapshot.last_input = reader.read<std::uint32_t>();
+    part.index = reader.read<std::uint16_t>();
+    part.num_parts = reader.read<std::uint16_t>();
+    const auto num_states = reader.read<std::uint16_t>();
+    if (part.index >= part.num_parts)
+    {
+        throw std::runtime_error("Snapshot part has a corrupt index");
+    }
+
+    // Every state takes at least 32 bits for its entity, which bounds a corrupt count
+    if (num_states > reader.remaining() * 8 / 32)
+    {
+        throw std::runtime_error("Snapshot part has a corrupt state count");
+    }
+
+    const Snapshot* baseline = nullptr;
+    if (baseline_tick != no_tick)
+    {
+        baseline = find_baseline(baseline_tick);
+        if (!baseline)
+        {
+            return std::nullopt;
+        }
+    }
+
+    const auto offset = packet.size() - reader.remaining();
+    auto bit_reader = geometry::BitReader(
+        reinterpret_cast<const std::uint8_t*>(packet.data()) + offset, reader.remaining());
+
+    part.snapshot.states.reserve(num_states);
+    auto cursor = BaselineCursor(baseline);
+    for (std::uint32_t i = 0; i < num_states; ++i)
+    {
+        const auto entity = static_cast<entt::entity>(bit_reader.read(32));
+        part.snapshot.states.emplace_back(entity, codec.decode(cursor.find(entity), bit_reader));
+    }
+
+    return part;
+}
+}  // namespace net
@@ -0,0 +1,351 @@
+#include "net/server.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#include "ecs/components.h"
+#include "ecs/systems.h"
+#include "profiling/profiler.h"
+
+namespace net
+{
+namespace
+{
+// Covers every fighter of the scene and the ship clients fly, so that none of them is clamped
+geometry::MotionStateCodec::Limits make_limits(ecs::Scene& scene,
+                                               const GameServer::Options& options)
+{
+    scene.resource_manager.load_fighter_model(options.ship_urdf);
+    const auto& ship = scene.resource_manager.get_fighter_model(options.ship_urdf)->motion_limits;
+    auto limits = geometry::MotionStateCodec::Limits{
+        ship.velocity, ship.acceleration, ship.angular_velocity, ship.angular_acceleration
+    };
+
+    for (const auto& [entity, fighter] : scene.registry.view<FighterComponent>().each())
+    {
+        std::ignore = entity;
+        const auto& model = fighter.model->motion_limits;
+        limits.velocity = std::max(limits.velocity, model.velocity);
+        limits.acceleration = std::max(limits.acceleration, model.acceleration);
+        limits.angular_velocity = std::max(limits.angular_velocity, model.angular_velocity);
+        limits.angular_acceleration =
+            std::max(limits.angular_acceleration, model.angular_acceleration);
+    }
+
+    return limits;
+}
+}  // namespace
+
+GameServer::GameServer(std::shared_ptr<ecs::Scene> scene,
+                       const std::uint16_t port,
+                       const float dt,
+                       const Options& options)
+  : scene(std::move(scene)),
+    socket(port),
+    dt(dt),
+    options(options),
+    limits(make_limits(*this->scene, options)),
+    codec(Eigen::Vector3f::Zero(), options.sector_extent, limits)
+{
+    for (auto& snapshot : history)
+    {
+        snapshot.tick = no_tick;
+    }
+}
+
+GameServer::GameServer(std::shared_ptr<ecs::Scene> scene, const std::uint16_t port, const float dt)
+  : GameServer(std::move(scene), port, dt, Options())
+{
+}
+
+void GameServer::update()
+{
+    AWING_PROFILE_SCOPE("server_update");
+
+    receive();
+    drop_timed_out_clients();
+    apply_inputs();
+
+    ecs::systems::integrate(*scene, t, dt);
+    t += dt;
+    ++tick;
+
+    capture_snapshot();
+    send_snapshots();
+}
+
+std::uint16_t GameServer::get_port() const
+{
+    return socket.get_local_address().port;
+}
+
+std::uint32_t GameServer::get_tick() const
+{
+    return tick;
+}
+
+float GameServer::get_time() const
+{
+    return t;
+}
+
+const ecs::Scene& GameServer::get_scene() const
+{
+    return *scene;
+}
+
+const geometry::MotionStateCodec& GameServer::get_codec() const
+{
+    return codec;
+}
+
+std::vector<GameServer::ClientStats> GameServer::get_client_stats() const
+{
+    std::vector<ClientStats> stats;
+    for (const auto& client : clients)
+    {
+        stats.push_back(ClientStats{ client.id,
+                                     client.address,
+                                     client.entity,
+                                     client.bytes_sent,
+                                     client.bytes_received,
+                                     client.full_snapshots_sent });
+    }
+    return stats;
+}
+
+void GameServer::receive()
+{
+    AWING_PROFILE_SCOPE("server_receive");
+
+    Address from;
+    incoming.resize(max_packet_size);
+    while (const auto size = socket.receive(from, incoming.data(), incoming.size()))
+    {
+        incoming.resize(*size);
+
+        // Anyone can send anything, so packets that don't parse are dropped rather than fatal
+        try
+        {
+            const auto type = read_packet_type(incoming);
+            if (type == PacketType::HELLO && read_hello(incoming))
+            {
+                handle_hello(from);
+            }
+            else if (type == PacketType::INPUT)
+            {
+                handle_input(from, read_input(incoming), *size);
+            }
+        }
+        catch (const std::runtime_error&)
+        {
+        }
+
+        incoming.resize(max_packet_size);
+    }
+}
+
+void GameServer::handle_hello(const Address& from)
+{
+    auto client = std::find_if(clients.begin(), clients.end(), [&from](const Client& client) {
+        return client.address == from;
+    });
+
+    // A client says hello until it is welcomed, so this may be a repeat. Hellos aren't
+    // authenticated, so the fighters they create are limited, until clients time out.
+    if (client == clients.end())
+    {
+        if (clients.size() >= options.max_clients)
+        {
+            return;
+        }
+
+        const auto id = next_client_id++;
+
+        // In rows of 16, facing the same way
+        const auto position =
+            Eigen::Vector3f(25.0f * static_cast<float>(id % 16), 0.0f, 25.0f * (id / 16));
+        const auto entity = scene->register_ship("client_" + std::to_string(id),
+                                                 options.ship_urdf,
+                                                 position,
+                                                 Eigen::Quaternionf::Identity());
+
+        client = clients.insert(clients.end(), Client());
+        client->id = id;
+        client->address = from;
+        client->entity = entity;
+    }
+    client->last_heard_tick = tick;
+
+    outgoing.clear();
+    write_welcome(Welcome{ client->id, client->entity, dt, options.sector_extent, limits },
+                  outgoing);
+    socket.send(from, outgoing.data(), outgoing.size());
+    client->bytes_sent += outgoing.size();
+}
+
+void GameServer::handle_input(const Address& from, const Input& input, const std::size_t size)
+{
+    auto* client = find_client(input.client_id, from);
+    if (!client)
+    {
+        return;
+    }
+
+    client->last_heard_tick = tick;
+    client->bytes_received += size;
+
+    // Datagrams can arrive out of order, and acknowledge ticks yet to be sent if they are forged.
+    // The last snapshot sent was stamped with tick, which only goes up after this.
+    if (input.acked_tick <= tick &&
+        (client->acked_tick == no_tick || input.acked_tick > client->acked_tick))
+    {
+        client->acked_tick = input.acked_tick;
+    }
+
+    // Queues the inputs after those already queued. Any missing in between were lost along with
+    // every packet that repeated them, and the held actions stand in for them.
+    const auto first = input.sequence + 1 - static_cast<std::uint32_t>(input.actions.size());
+    for (std::size_t i = 0; i < input.actions.size(); ++i)
+    {
+        const auto sequence = first + static_cast<std::uint32_t>(i);
+        const auto end =
+            client->next_input + static_cast<std::uint32_t>(client->queued_inputs.size());
+        if (sequence < end)
+        {
+            continue;
+        }
+
+        const auto held = client->queued_inputs.empty() ? client->actions
+                                                        : client->queued_inputs.back();
+
+        // A gap longer than the queue would be trimmed away again, and one from a forged sequence
+        // could be billions of inputs long, so skip straight to the input instead of filling it
+        if (sequence - end >= options.max_queued_inputs)
+        {
+            client->queued_inputs.clear();
+            client->next_input = sequence;
+            client->actions = held;
+        }
+        else
+        {
+            client->queued_inputs.insert(client->queued_inputs.end(), sequence - end, held);
+        }
+        client->queued_inputs.push_back(input.actions[i]);
+    }
+
+    // A client that got ahead, e.g. after its packets bunched up, skips inputs rather than lagging
+    // behind for good
+    while (client->queued_inputs.size() > options.max_queued_inputs)
+    {
+        client->queued_inputs.pop_front();
+        ++client->next_input;
+    }
+}
+
+void GameServer::apply_inputs()
+{
+    for (auto& client : clients)
+    {
+        if (!client.queued_inputs.empty())
+        {
+            client.actions = client.queued_inputs.front();
+            client.queued_inputs.pop_front();
+            client.last_applied = client.next_input++;
+        }
+
+        if (!scene->registry.valid(client.entity))
+        {
+            continue;
+        }
+        if (auto* fighter = scene->registry.try_get<FighterComponent>(client.entity))
+        {
+            fighter->input.set_actions(urdf::FighterInput::Actions(client.actions));
+        }
+    }
+}
+
+void GameServer::capture_snapshot()
+{
+    AWING_PROFILE_SCOPE("capture_snapshot");
+
+    auto& snapshot = history[tick % history_size];
+    snapshot.tick = tick;
+    snapshot.states.clear();
+
+    // Carries on from the quantized states, which is what clients predict from. The sector bounds
+    // the play area, so that no position is clamped by quantizing while its velocity carries on.
+    auto view = scene->registry.view<FighterComponent, MotionStateComponent>();
+    for (const auto entity : view)
+    {
+        auto& motion_state = view.get<MotionStateComponent>(entity);
+        codec.keep_in_sector(motion_state);
+        const auto& quantized =
+            snapshot.states.emplace_back(entity, codec.quantize(motion_state)).second;
+        motion_state = codec.dequantize(quantized);
+    }
+
+    std::sort(snapshot.states.begin(),
+              snapshot.states.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+}
+
+void GameServer::send_snapshots()
+{
+    AWING_PROFILE_SCOPE("send_snapshots");
+
+    auto& snapshot = history[tick % history_size];
+    for (auto& client : clients)
+    {
+        const Snapshot* baseline = nullptr;
+        if (client.acked_tick != no_tick && tick - client.acked_tick < history_size &&
+            history[client.acked_tick % history_size].tick == client.acked_tick)
+        {
+            baseline = &history[client.acked_tick % history_size];
+        }
+
+        snapshot.last_input = client.last_applied;
+        write_snapshot(snapshot, baseline, codec, snapshot_packets);
+        for (const auto& packet : snapshot_packets)
+        {
+            socket.send(client.address, packet.data(), packet.size());
+            client.bytes_sent += packet.size();
+        }
+        client.full_snapshots_sent += baseline == nullptr;
+    }
+}
+
+void GameServer::drop_timed_out_clients()
+{
+    const auto timeout_ticks =
+        static_cast<std::uint32_t>(std::lround(options.client_timeout / dt));
+
+    auto timed_out = std::stable_partition(
+        clients.begin(), clients.end(), [this, timeout_ticks](const Client& client) {
+            return tick - client.last_heard_tick <= timeout_ticks;
+        });
+    for (auto client = timed_out; client != clients.end(); ++client)
+    {
+        if (scene->registry.valid(client->entity))
+        {
+            scene->registry.destroy(client->entity);
+        }
+    }
+    clients.erase(timed_out, clients.end());
+}
+
+GameServer::Client* GameServer::find_client(const std::uint32_t id, const Address& address)
+{
+    for (auto& client : clients)
+    {
+        if (client.id == id && client.address == address)
+        {
+            return &client;
+        }
+    }
+    return nullptr;
+}
+}  // namespace net
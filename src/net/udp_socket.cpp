@@ -0,0 +1,148 @@
+#include "net/udp_socket.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace net
+{
+namespace
+{
+std::runtime_error socket_error(const std::string& what)
+{
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+sockaddr_in to_sockaddr(const Address& address)
+{
+    sockaddr_in out{};
+    out.sin_family = AF_INET;
+    out.sin_addr.s_addr = htonl(address.host);
+    out.sin_port = htons(address.port);
+    return out;
+}
+
+Address from_sockaddr(const sockaddr_in& address)
+{
+    return Address{ ntohl(address.sin_addr.s_addr), ntohs(address.sin_port) };
+}
+}  // namespace
+
+Address Address::loopback(const std::uint16_t port)
+{
+    return Address{ INADDR_LOOPBACK, port };
+}
+
+bool Address::operator==(const Address& other) const
+{
+    return host == other.host && port == other.port;
+}
+
+bool Address::operator!=(const Address& other) const
+{
+    return !(*this == other);
+}
+
+std::string Address::to_string() const
+{
+    return std::to_string(host >> 24) + "." + std::to_string((host >> 16) & 0xff) + "." +
+           std::to_string((host >> 8) & 0xff) + "." + std::to_string(host & 0xff) + ":" +
+           std::to_string(port);
+}
+
+UdpSocket::UdpSocket(const std::uint16_t port) : fd(::socket(AF_INET, SOCK_DGRAM, 0))
+{
+    if (fd < 0)
+    {
+        throw socket_error("Failed to create UDP socket");
+    }
+
+    const auto address = to_sockaddr(Address{ INADDR_ANY, port });
+    if (::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK) != 0)
+    {
+        const auto error =
+            socket_error("Failed to bind UDP socket to port " + std::to_string(port));
+        ::close(fd);
+        throw error;
+    }
+}
+
+UdpSocket::~UdpSocket()
+{
+    if (fd >= 0)
+    {
+        ::close(fd);
+    }
+}
+
+UdpSocket::UdpSocket(UdpSocket&& other) noexcept : fd(std::exchange(other.fd, -1))
+{
+}
+
+UdpSocket& UdpSocket::operator=(UdpSocket&& other) noexcept
+{
+    std::swap(fd, other.fd);
+    return *this;
+}
+
+void UdpSocket::send(const Address& to, const void* data, const std::size_t size)
+{
+    const auto address = to_sockaddr(to);
+    const auto sent = ::sendto(
+        fd, data, size, 0, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+
+    // A full send buffer drops the datagram, like the network would
+    if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+        throw socket_error("Failed to send to " + to.to_string());
+    }
+}
+
+std::optional<std::size_t>
+UdpSocket::receive(Address& from, void* buffer, const std::size_t capacity)
+{
+    sockaddr_in address{};
+    socklen_t address_size = sizeof(address);
+    while (true)
+    {
+        const auto received = ::recvfrom(
+            fd, buffer, capacity, 0, reinterpret_cast<sockaddr*>(&address), &address_size);
+        if (received >= 0)
+        {
+            from = from_sockaddr(address);
+            return static_cast<std::size_t>(received);
+        }
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            return std::nullopt;
+        }
+
+        // A port unreachable reply to an earlier send, e.g. to a client that went away, only
+        // concerns that datagram
+        if (errno != ECONNREFUSED && errno != EINTR)
+        {
+            throw socket_error("Failed to receive on a UDP socket");
+        }
+    }
+}
+
+Address UdpSocket::get_local_address() const
+{
+    sockaddr_in address{};
+    socklen_t address_size = sizeof(address);
+    if (::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &address_size) != 0)
+    {
+        throw socket_error("Failed to get the address of a UDP socket");
+    }
+    return from_sockaddr(address);
+}
+}  // namespace net
@@ -0,0 +1,100 @@
+#include "profiling/profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace profiling
+{
+float Profiler::Section::last_ms() const
+{
+    return num_samples ? samples_ms[(next + history_size - 1) % history_size] : 0.0f;
+}
+
+float Profiler::Section::mean_ms() const
+{
+    if (num_samples == 0)
+    {
+        return 0.0f;
+    }
+    return std::accumulate(samples_ms.begin(), samples_ms.begin() + num_samples, 0.0f) /
+           num_samples;
+}
+
+float Profiler::Section::max_ms() const
+{
+    return num_samples ? *std::max_element(samples_ms.begin(), samples_ms.begin() + num_samples) :
+                         0.0f;
+}
+
+std::vector<float> Profiler::Section::history() const
+{
+    auto out = std::vector<float>();
+    out.reserve(num_samples);
+
+    const auto oldest = num_samples < history_size ? 0 : next;
+    for (std::size_t i = 0; i < num_samples; ++i)
+    {
+        out.push_back(samples_ms[(oldest + i) % history_size]);
+    }
+
+    return out;
+}
+
+Profiler& Profiler::get()
+{
+    static Profiler instance;
+    return instance;
+}
+
+void Profiler::record(const char* name, const float ms)
+{
+    const auto lock = std::lock_guard(mutex);
+    auto it = std::find_if(sections.begin(), sections.end(), [name](const Section& section) {
+        return section.name == name || std::strcmp(section.name, name) == 0;
+    });
+    if (it == sections.end())
+    {
+        it = sections.insert(sections.end(), Section{ name });
+    }
+
+    it->samples_ms[it->next] = ms;
+    it->next = (it->next + 1) % history_size;
+    it->num_samples = std::min(it->num_samples + 1, history_size);
+}
+
+std::vector<Profiler::Section> Profiler::get_sections() const
+{
+    const auto lock = std::lock_guard(mutex);
+    return sections;
+}
+
+std::optional<Profiler::Section> Profiler::find(const char* name) const
+{
+    const auto lock = std::lock_guard(mutex);
+    for (const auto& section : sections)
+    {
+        if (std::strcmp(section.name, name) == 0)
+        {
+            return section;
+        }
+    }
+    return std::nullopt;
+}
+
+ScopedTimer::ScopedTimer(const char* name, const char* detail)
+  : name(name), detail(detail), start(std::chrono::steady_clock::now())
+{
+}
+
+ScopedTimer::~ScopedTimer()
+{
+    const auto end = std::chrono::steady_clock::now();
+    Profiler::get().record(name, std::chrono::duration<float, std::milli>(end - start).count());
+
+    if (auto& recorder = TraceRecorder::get(); recorder.enabled())
+    {
+        recorder.record(name, detail, start, end);
+    }
+}
+}  // namespace profiling
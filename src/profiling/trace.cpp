@@ -0,0 +1,198 @@
+#include "profiling/trace.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace profiling
+{
+namespace
+{
+void write_escaped(FILE* file, const char* str)
+{
+    for (; *str; ++str)
+    {
+        if (*str == '"' || *str == '\\')
+        {
+            std::fputc('\\', file);
+        }
+        if (static_cast<unsigned char>(*str) >= 0x20)
+        {
+            std::fputc(*str, file);
+        }
+    }
+}
+}  // namespace
+
+TraceRecorder::TraceRecorder() : epoch(Clock::now())
+{
+}
+
+TraceRecorder& TraceRecorder::get()
+{
+    static TraceRecorder instance;
+    return instance;
+}
+
+void TraceRecorder::enable(const std::string& filename)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->filename = filename;
+    }
+    is_enabled.store(true, std::memory_order_release);
+}
+
+void TraceRecorder::record(const char* name,
+                           const char* detail,
+                           const Clock::time_point start,
+                           const Clock::time_point end)
+{
+    auto& buffer = thread_buffer();
+
+    // Only this thread writes to its buffer, so the count can't change under us
+    const auto index = buffer.num_recorded.load(std::memory_order_relaxed);
+    auto& event = buffer.events[index % events_per_thread];
+
+    event.name = name;
+    event.detail[0] = '\0';
+    if (detail)
+    {
+        std::strncpy(event.detail.data(), detail, max_detail_length);
+        event.detail[max_detail_length] = '\0';
+    }
+    event.start_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(start - epoch).count();
+    event.duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+    buffer.num_recorded.store(index + 1, std::memory_order_release);
+}
+
+void TraceRecorder::set_thread_name(const std::string& name)
+{
+    auto& buffer = thread_buffer();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    buffer.name = name;
+}
+
+TraceRecorder::ThreadBuffer& TraceRecorder::thread_buffer()
+{
+    // Buffers are never freed, so they stay valid after their thread exits
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffer = buffers.back().get();
+        buffer->tid = static_cast<int>(buffers.size()) - 1;
+        buffer->name = "thread " + std::to_string(buffer->tid);
+    }
+    return *buffer;
+}
+
+bool TraceRecorder::write() const
+{
+    if (!enabled())
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    FILE* file = std::fopen(filename.c_str(), "w");
+    if (!file)
+    {
+        std::fprintf(stderr, "Could not open trace file %s\n", filename.c_str());
+        return false;
+    }
+
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    for (const auto& buffer : buffers)
+    {
+        std::fprintf(file,
+                     "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                     "\"args\":{\"name\":\"",
+                     first ? "" : ",\n",
+                     buffer->tid);
+        write_escaped(file, buffer->name.c_str());
+        std::fprintf(file, "\"}}");
+        first = false;
+
+        // Oldest surviving event first
+        const auto num_recorded = buffer->num_recorded.load(std::memory_order_acquire);
+        const auto begin = num_recorded > events_per_thread ? num_recorded - events_per_thread : 0;
+        for (auto i = begin; i < num_recorded; ++i)
+        {
+            const auto& event = buffer->events[i % events_per_thread];
+            std::fprintf(file, ",\n{\"name\":\"");
+            write_escaped(file, event.name);
+            std::fprintf(file,
+                         "\",\"cat\":\"awing\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                         "\"ts\":%.3f,\"dur\":%.3f",
+                         buffer->tid,
+                         event.start_ns / 1000.0,
+                         event.duration_ns / 1000.0);
+            if (event.detail[0])
+            {
+                std::fprintf(file, ",\"args\":{\"detail\":\"");
+                write_escaped(file, event.detail.data());
+                std::fprintf(file, "\"}");
+            }
+            std::fprintf(file, "}");
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+    std::fclose(file);
+
+    return true;
+}
+
+bool init_tracing(int argc, char* argv[])
+{
+    auto filename = std::string();
+    for (int i = 1; i < argc; ++i)
+    {
+        const auto arg = std::string(argv[i]);
+        if (arg == "--trace" && i + 1 < argc)
+        {
+            filename = argv[i + 1];
+        }
+        else if (arg.rfind("--trace=", 0) == 0)
+        {
+            filename = arg.substr(std::strlen("--trace="));
+        }
+    }
+    if (const char* env = std::getenv("AWING_TRACE"); filename.empty() && env && *env)
+    {
+        filename = env;
+    }
+
+    if (filename.empty())
+    {
+        return false;
+    }
+
+    auto& recorder = TraceRecorder::get();
+    recorder.enable(filename);
+    recorder.set_thread_name("main");
+    return true;
+}
+
+ScopedTraceEvent::ScopedTraceEvent(const char* name) : name(name)
+{
+    if (TraceRecorder::get().enabled())
+    {
+        start = TraceRecorder::Clock::now();
+    }
+}
+
+ScopedTraceEvent::~ScopedTraceEvent()
+{
+    auto& recorder = TraceRecorder::get();
+    if (recorder.enabled() && start != TraceRecorder::Clock::time_point())
+    {
+        recorder.record(name, nullptr, start, TraceRecorder::Clock::now());
+    }
+}
+}  // namespace profiling
@@ -2,7 +2,6 @@
 #include <sstream>
 #include <iostream>
 #include <cassert>
-#include <set>
 #include <string>
 #include <array>
 #include <map>
@@ -50,36 +49,19 @@ void insert_data(const std::vector<std::string>& names, const MeshData& mesh, Ge
     cur_node_ptr->min = mesh.min;
     cur_node_ptr->max = mesh.max;
 
-    if (mesh.vertices.size() / 3 == 8)
-    {
-        // std::cout << "Adding bounding box: ";
-        // print_names(names);
-        cur_node_ptr->type = GeometryData::Type::BOUNDINGBOX;
-    }
-    else
-    {
-        // std::cout << "Adding convex hull with " << std::to_string(mesh.vertices.size() / 3)
-        //           << " verts: ";
-        // print_names(names);
-        cur_node_ptr->type = GeometryData::Type::CONVEXHULL;
-        cur_node_ptr->vertices = mesh.vertices;
+    // Boxes are tagged as such, but are not necessarily axis aligned, so their hull is kept too
+    cur_node_ptr->type = mesh.vertices.size() / 3 == 8 ? GeometryData::Type::BOUNDINGBOX :
+                                                         GeometryData::Type::CONVEXHULL;
+    cur_node_ptr->vertices = mesh.vertices;
 
-        cur_node_ptr->face_indices.reserve(mesh.indices.size() / 3);
+    cur_node_ptr->face_indices.reserve(mesh.indices.size() / 3);
 
-        assert(mesh.indices.size() % 3 == 0);
+    assert(mesh.indices.size() % 3 == 0);
 
-        for (std::size_t i = 0; i < mesh.indices.size(); i = i + 3)
-        {
-            cur_node_ptr->edge_indices.insert(
-                std::make_pair(mesh.indices[i + 0], mesh.indices[i + 1]));
-            cur_node_ptr->edge_indices.insert(
-                std::make_pair(mesh.indices[i + 0], mesh.indices[i + 2]));
-            cur_node_ptr->edge_indices.insert(
-                std::make_pair(mesh.indices[i + 1], mesh.indices[i + 2]));
-
-            cur_node_ptr->face_indices.push_back(
-                std::make_tuple(mesh.indices[i + 0], mesh.indices[i + 1], mesh.indices[i + 2]));
-        }
+    for (std::size_t i = 0; i < mesh.indices.size(); i = i + 3)
+    {
+        cur_node_ptr->face_indices.push_back(
+            std::make_tuple(mesh.indices[i + 0], mesh.indices[i + 1], mesh.indices[i + 2]));
     }
 }
 
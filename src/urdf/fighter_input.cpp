@@ -76,4 +76,14 @@ FighterInput::Actuation FighterInput::current_actuation() const
 
     return { d_w, d_v };
 }
+
+const FighterInput::Actions& FighterInput::get_actions() const
+{
+    return actions;
+}
+
+void FighterInput::set_actions(const Actions& value)
+{
+    actions = value;
+}
 }  // namespace urdf
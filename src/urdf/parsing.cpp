@@ -112,6 +112,13 @@ FighterModel parse_fighter_urdf(const std::string& filename)
     {
         throw std::runtime_error("URDF does not contain 'health' element");
     }
+
+    // Team, optional
+    if (const XMLElement* team = robot->FirstChildElement("team"))
+    {
+        out.team = static_cast<int>(parse_float_attribute(team, "id"));
+    }
+
     return out;
 }
 }  // namespace urdf
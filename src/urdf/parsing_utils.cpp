@@ -203,6 +203,12 @@ FighterModel::LaserInfo parse_laser_element(const XMLElement* laser)
     {
         out.speed = 1000.0f * parse_float_attribute(speed, "kmps");
 
+        // Optional, keeps the default otherwise
+        if (const auto* range = laser->FirstChildElement("range"))
+        {
+            out.range = 1000.0f * parse_float_attribute(range, "km");
+        }
+
         if (const auto* size = laser->FirstChildElement("size"))
         {
             out.size = parse_vec3_attribute(size, "xyz");